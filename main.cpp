@@ -1,5 +1,7 @@
+#include "src/include/body_pool.hpp"
 #include "src/include/config_parser.hpp"
 #include "src/include/game.hpp"
+#include <algorithm> // std::min
 #include <ctime>
 
 int main(int argv, char* args[]) {
@@ -7,30 +9,55 @@ int main(int argv, char* args[]) {
   using namespace ktp;
 
   ConfigParser::loadConfigFiles();
+  ConfigParser::parseCommandLine(argv, args);
 
-  srand(time(nullptr));
+  const bool headless {ConfigParser::headless_config.enabled_};
+  // headless runs must be reproducible
+  srand(headless ? 0u : static_cast<unsigned int>(time(nullptr)));
 
   Game game {};
 
-  constexpr double dt {0.01};
-  double current_time {SDL_GetTicks() / 1000.0};
+  const auto& fixed_step {ConfigParser::game_config.fixed_step_};
+  const double dt {1.0 / fixed_step.tick_rate_};
+  const double frequency {static_cast<double>(SDL_GetPerformanceFrequency())};
+  Uint64 current_time {SDL_GetPerformanceCounter()};
   double accumulator {0.0};
 
   while (!game.quit()) {
 
-    const double new_time {SDL_GetTicks() / 1000.0};
-    Game::frame_time_ = new_time - current_time;
+    // ms ticks would round every frame time to a whole ms
+    const Uint64 new_time {SDL_GetPerformanceCounter()};
+    // headless runs step exactly once per frame
+    Game::frame_time_ = headless ? dt : static_cast<double>(new_time - current_time) / frequency;
     current_time = new_time;
     accumulator += Game::frame_time_;
 
     game.handleEvents();
 
-    while (accumulator >= dt) {
-      game.update(dt);
+    auto ticks {static_cast<unsigned int>(accumulator / dt)};
+    // after a hitch, catching up every tick would only make the next frame longer
+    if (ticks > fixed_step.max_steps_) {
+      Game::tick_stats_.dropped_ticks_ += ticks - fixed_step.max_steps_;
+      accumulator -= (ticks - fixed_step.max_steps_) * dt;
+      ticks = fixed_step.max_steps_;
+    }
+    // a step that overlapped the last draw and isn't done yet holds the ticks
+    // back to the next frame, so a physics spike doesn't hold the frame too.
+    // Headless runs wait for it, they must be reproducible
+    if (!headless && !Game::physics_thread_.ready()) ticks = 0u;
+    if (ticks > 1u) Game::tick_stats_.catch_up_ticks_ += ticks - 1u;
+    if (ticks > Game::tick_stats_.max_ticks_) Game::tick_stats_.max_ticks_ = ticks;
+    for (; ticks > 0u; --ticks) {
+      game.update(static_cast<float>(dt));
       accumulator -= dt;
     }
+    BodyPool::endFrame();
+    // the draw blends the last two ticks, headless runs and states that don't
+    // move anything (pause) draw the last one as it is. Held back ticks don't
+    // extrapolate past the last one
+    Game::interpolation_ = headless || !game.simulates() ? 1.f : std::min(static_cast<float>(accumulator / dt), 1.f);
 
     game.draw();
   }
-  return 0;
+  return game.exitCode();
 }
@@ -0,0 +1,15 @@
+#version 330
+
+layout(location = 0) in vec2 pos_in;
+layout(location = 1) in vec2 lower_in;
+layout(location = 2) in vec2 upper_in;
+layout(location = 3) in vec4 color_in;
+
+uniform mat4 mvp;
+
+out vec4 color;
+
+void main() {
+  gl_Position = mvp * vec4(mix(lower_in, upper_in, pos_in), 0.0f, 1.0f);
+  color = color_in;
+}
@@ -0,0 +1,30 @@
+#version 330 core
+
+// See entity.vert for the permutations.
+
+#ifdef TEXTURE
+in vec2 tex_coord;
+uniform sampler2D our_texture;
+#endif
+#ifdef VERTEX_COLOR
+in vec4 vertex_color;
+#endif
+#ifdef UNIFORM_COLOR
+uniform vec4 color;
+#endif
+
+out vec4 frag_color;
+
+void main() {
+  vec4 result = vec4(1.0);
+#ifdef TEXTURE
+  result *= texture(our_texture, tex_coord);
+#endif
+#ifdef VERTEX_COLOR
+  result *= vertex_color;
+#endif
+#ifdef UNIFORM_COLOR
+  result *= color;
+#endif
+  frag_color = result;
+}
@@ -0,0 +1,54 @@
+#version 330 core
+
+// Permutations, chosen by the defines Resources::loadShader() adds:
+// TEXTURE            texture coords at location 1
+// VERTEX_COLOR       color per vertex (or per instance) at location 2
+// UNIFORM_COLOR      one color for the whole draw
+// INSTANCE_OFFSET    translation per instance at location 3
+// INSTANCE_SIZE      scale per instance at location 4
+// INSTANCE_TRANSFORM {x, y, cos(angle), sin(angle)} per instance at location 5
+
+layout (location = 0) in vec3 pos_in;
+#ifdef TEXTURE
+layout (location = 1) in vec2 tex_coord_in;
+out vec2 tex_coord;
+#endif
+#ifdef VERTEX_COLOR
+// vec3 colors get 1.0 as alpha
+layout (location = 2) in vec4 color_in;
+out vec4 vertex_color;
+#endif
+#ifdef INSTANCE_OFFSET
+layout (location = 3) in vec3 offset_in;
+#endif
+#ifdef INSTANCE_SIZE
+layout (location = 4) in float size_in;
+#endif
+#ifdef INSTANCE_TRANSFORM
+layout (location = 5) in vec4 transform_in;
+#endif
+
+uniform mat4 mvp;
+
+void main() {
+  vec3 pos = pos_in;
+#ifdef INSTANCE_SIZE
+  pos *= size_in;
+#endif
+#ifdef INSTANCE_OFFSET
+  pos += offset_in;
+#endif
+#ifdef INSTANCE_TRANSFORM
+  pos.xy = vec2(
+    pos.x * transform_in.z - pos.y * transform_in.w,
+    pos.x * transform_in.w + pos.y * transform_in.z
+  ) + transform_in.xy;
+#endif
+  gl_Position = mvp * vec4(pos, 1.0);
+#ifdef TEXTURE
+  tex_coord = tex_coord_in;
+#endif
+#ifdef VERTEX_COLOR
+  vertex_color = color_in;
+#endif
+}
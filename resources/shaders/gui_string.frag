@@ -2,10 +2,12 @@
 
 in vec2 tex_coord;
 
+uniform vec4 text_color;
 uniform sampler2D our_texture;
 
 out vec4 frag_color;
 
 void main() {
-  frag_color = texture(our_texture, tex_coord);
+  // the glyph atlas only stores coverage in the red channel
+  frag_color = vec4(text_color.rgb, text_color.a * texture(our_texture, tex_coord).r);
 }
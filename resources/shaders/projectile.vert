@@ -1,9 +0,0 @@
-#version 330 core
-
-layout (location = 0) in vec3 pos;
-
-uniform mat4 mvp;
-
-void main() {
-  gl_Position = mvp * vec4(pos, 1.0);
-}
@@ -0,0 +1,13 @@
+#version 330 core
+
+// the part of the texture to stretch over the screen, from the bottom left
+uniform vec2 uv_scale;
+
+out vec2 tex_coord;
+
+void main() {
+  // one triangle that covers the whole screen, no vertex buffer needed
+  const vec2 corners[3] = vec2[3](vec2(-1.0, -1.0), vec2(3.0, -1.0), vec2(-1.0, 3.0));
+  gl_Position = vec4(corners[gl_VertexID], 0.0, 1.0);
+  tex_coord = uv_scale * (0.5 * corners[gl_VertexID] + 0.5);
+}
@@ -1,14 +1,17 @@
 #version 330 core
 
 layout (location = 0) in vec3 pos_in;
-layout (location = 1) in vec2 offset_in;
+layout (location = 1) in vec3 star_in; // x, starting y, speed
 layout (location = 2) in vec4 color_in;
 
 uniform mat4 mvp;
+uniform float height;
+uniform float time;
 
 out vec4 color;
 
 void main() {
-  gl_Position = mvp * vec4(pos_in + vec3(offset_in, 0.0), 1.0);
+  vec2 offset = vec2(star_in.x, mod(star_in.y - star_in.z * time, height));
+  gl_Position = mvp * vec4(pos_in + vec3(offset, 0.0), 1.0);
   color = color_in;
 }
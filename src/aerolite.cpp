@@ -10,54 +10,34 @@
 
 /* GRAPHICS */
 
-ktp::AeroliteGraphicsComponent::AeroliteGraphicsComponent() {
-  shader_.use();
-  shader_.setFloat4("aerolite_color", glm::value_ptr(color_));
-}
-
 void ktp::AeroliteGraphicsComponent::update(const GameEntity& aerolite) {
-  shader_.use();
-  shader_.setMat4f("mvp", glm::value_ptr(mvp_));
-  texture_.bind();
-  vao_.bind();
-  glDrawElements(GL_TRIANGLES, (int)indices_count_, GL_UNSIGNED_INT, 0);
+  const auto position {interpolatedPosition()};
+  const auto angle {interpolatedAngle()};
+  AeroliteMeshArena::queue(mesh_, {position.x, position.y, SDL_cosf(angle), SDL_sinf(angle)});
 }
 
 /* PHYSICS */
 
-ktp::AerolitePhysicsComponent::AerolitePhysicsComponent(GameEntity* owner, AeroliteGraphicsComponent* graphics): graphics_(graphics) {
+ktp::AerolitePhysicsComponent::AerolitePhysicsComponent(GameEntity* owner, AeroliteGraphicsComponent* graphics):
+ AerolitePhysicsComponent(owner, graphics, ConfigParser::aerolites_config.size_.value_ * generateRand(ConfigParser::aerolites_config.size_.rand_min_, ConfigParser::aerolites_config.size_.rand_max_)) {}
+
+ktp::AerolitePhysicsComponent::AerolitePhysicsComponent(GameEntity* owner, AeroliteGraphicsComponent* graphics, float size): graphics_(graphics) {
   born_time_ = Game::gameplay_timer_.milliseconds();
   owner_ = owner;
-  size_ = ConfigParser::aerolites_config.size_.value_ * generateRand(ConfigParser::aerolites_config.size_.rand_min_, ConfigParser::aerolites_config.size_.rand_max_);
-  // shape is a vector of points: {[x,y], [x,y], ...} with center at [0,0]
-  const auto shape {generateAeroliteShape(size_)};
-  // triangulated_shape is a vector of floats: {x, y, z, x, y, z, x, y, ...}
-  GLfloatVector triangulated_shape {};
-  Geometry::triangulate(shape, triangulated_shape);
+  // the shape, its fixtures and its mesh, rounded to the size of a cached one
+  auto shape_template {AeroliteShapeCache::take(size)};
+  size_ = shape_template.size_;
   // Box2D
-  createB2Body(*this, triangulated_shape);
-  // generate a EBO based on the triangulated_shape
-  GLuintVector indices {};
-  EBO::generateEBO(triangulated_shape, indices);
-  // convert cartesian coords to UV coords and set up the uv VBO
-  const GLfloatVector texture_coords {convertToUV(triangulated_shape)};
-  graphics_->uv_.setup(texture_coords);
-  // convert box2d coords to pixels and set up the vertices VBO
-  std::transform(triangulated_shape.begin(), triangulated_shape.end(), triangulated_shape.begin(), [](auto coord){return coord * kMetersToPixels;});
-  graphics_->vertices_.setup(triangulated_shape);
-  // link the attributes
-  graphics_->vao_.linkAttrib(graphics_->vertices_, 0, 3, GL_FLOAT, 0, nullptr);
-  graphics_->vao_.linkAttrib(graphics_->uv_,       1, 2, GL_FLOAT, 0, nullptr);
-  // setup the EBO
-  graphics_->indices_count_ = indices.size();
-  graphics_->ebo_.setup(indices);
+  createB2Body(*this, shape_template);
+  // OpenGL
+  createMesh(shape_template);
   // the pointing arrow
   arrow_ = static_cast<AeroliteArrowPhysicsComponent*>(GameEntity::createEntity(EntityTypes::AeroliteArrow)->physics());
 }
 
 ktp::AerolitePhysicsComponent::~AerolitePhysicsComponent() {
   if (arrow_) arrow_->owner()->deactivate();
-  if (body_) world_->DestroyBody(body_);
+  BodyPool::release(BodyArchetype::Aerolite, body_);
 }
 
 ktp::AerolitePhysicsComponent& ktp::AerolitePhysicsComponent::operator=(AerolitePhysicsComponent&& other) {
@@ -98,33 +78,43 @@ ktp::GLfloatVector ktp::AerolitePhysicsComponent::convertToUV(const GLfloatVecto
   return result;
 }
 
-void ktp::AerolitePhysicsComponent::createB2Body(AerolitePhysicsComponent& aerolite, const GLfloatVector& triangulated_shape) {
-  if (aerolite.body_) world_->DestroyBody(aerolite.body_);
-
-  b2BodyDef body_def {};
-  body_def.type = b2_dynamicBody;
-  body_def.userData.pointer = reinterpret_cast<uintptr_t>(aerolite.owner_);
-  aerolite.body_ = world_->CreateBody(&body_def);
-
-  std::vector<B2Vec2Vector> fixtures_shapes {};
-  for (std::size_t i = 0; i < triangulated_shape.size(); i += 9) {
-    B2Vec2Vector vec;
-    vec.push_back(b2Vec2{triangulated_shape[i + 0], triangulated_shape[i + 1]});
-    vec.push_back(b2Vec2{triangulated_shape[i + 3], triangulated_shape[i + 4]});
-    vec.push_back(b2Vec2{triangulated_shape[i + 6], triangulated_shape[i + 7]});
-    fixtures_shapes.push_back(vec);
+void ktp::AerolitePhysicsComponent::createB2Body(AerolitePhysicsComponent& aerolite, const AeroliteTemplate& shape_template) {
+  if (!aerolite.body_) {
+    b2BodyDef body_def {};
+    body_def.type = b2_dynamicBody;
+    body_def.bullet = ConfigParser::aerolites_config.collision_.bullet_;
+    body_def.userData.pointer = reinterpret_cast<uintptr_t>(aerolite.owner_);
+    // enabled once it has its new fixtures, so the old ones don't get proxies
+    body_def.enabled = false;
+    aerolite.body_ = BodyPool::acquire(BodyArchetype::Aerolite, body_def);
   }
+  // a reshape, or a recycled body, swaps the fixtures of the body it already has.
+  // Disabled first, so all the old proxies and contacts go in one pass
+  aerolite.body_->SetEnabled(false);
+  while (const auto fixture {aerolite.body_->GetFixtureList()}) aerolite.body_->DestroyFixture(fixture);
 
-  for (const auto& shape: fixtures_shapes) {
-    b2PolygonShape fixture_shape {};
-    fixture_shape.Set(shape.data(), shape.size());
-
+  const auto density {ConfigParser::aerolites_config.density_};
+  for (const auto& piece: shape_template.pieces_) {
     b2FixtureDef fixture_def {};
-    fixture_def.shape = &fixture_shape;
-    fixture_def.density = ConfigParser::aerolites_config.density_;
+    fixture_def.shape = &piece;
+    // the density goes in afterwards so CreateFixture doesn't reset the mass every time
+    fixture_def.density = 0.f;
+    fixture_def.filter = collisionFilter(ConfigParser::aerolites_config.collision_);
     fixture_def.friction = ConfigParser::aerolites_config.friction_;
     fixture_def.restitution = ConfigParser::aerolites_config.restitution_;
-    aerolite.body_->CreateFixture(&fixture_def);
+    aerolite.body_->CreateFixture(&fixture_def)->SetDensity(density);
+  }
+  // the template already has the mass of all the pieces
+  aerolite.body_->SetMassData(&shape_template.mass_data_);
+  aerolite.body_->SetEnabled(true);
+}
+
+void ktp::AerolitePhysicsComponent::createMesh(AeroliteTemplate& shape_template) {
+  AeroliteMeshArena::release(graphics_->mesh_);
+  if (shape_template.mesh_.valid()) {
+    graphics_->mesh_ = std::exchange(shape_template.mesh_, MeshRange{});
+  } else {
+    graphics_->mesh_ = AeroliteMeshArena::allocate(shape_template.vertices_, shape_template.uv_, shape_template.indices_);
   }
 }
 
@@ -170,34 +160,14 @@ bool ktp::AerolitePhysicsComponent::intersectPoint(const glm::vec2& a, const glm
 }
 
 void ktp::AerolitePhysicsComponent::reshape(float size) {
-  size_ = size;
-  const auto new_shape {generateAeroliteShape(size_)};
-  GLfloatVector triangulated_shape {};
-  Geometry::triangulate(new_shape, triangulated_shape);
-  // Box2D
-  const auto old_angle   {body_->GetAngle()};
-  const auto old_angular {body_->GetAngularVelocity()};
-  const auto old_delta   {body_->GetLinearVelocity()};
-  const auto old_pos     {body_->GetPosition()};
-  createB2Body(*this, triangulated_shape);
-  body_->SetAngularVelocity(old_angular);
+  auto shape_template {AeroliteShapeCache::take(size)};
+  size_ = shape_template.size_;
+  // Box2D, same body with new fixtures. The new mass center would change the velocity
+  const auto old_delta {body_->GetLinearVelocity()};
+  createB2Body(*this, shape_template);
   body_->SetLinearVelocity(old_delta);
-  body_->SetTransform(old_pos, old_angle);
-  // generate a new EBO based on the triangulated_shape
-  GLuintVector indices {};
-  EBO::generateEBO(triangulated_shape, indices);
-  // normalize texture
-  const GLfloatVector texture_coords {convertToUV(triangulated_shape)};
-  graphics_->uv_.setup(texture_coords);
-  // convert box2d coords to pixels
-  std::transform(triangulated_shape.begin(), triangulated_shape.end(), triangulated_shape.begin(), [](auto& coord){return coord * kMetersToPixels;});
-  // setup VBO and link the attributes
-  graphics_->vertices_.setup(triangulated_shape);
-  graphics_->vao_.linkAttrib(graphics_->vertices_, 0, 3, GL_FLOAT, 0, nullptr);
-  graphics_->vao_.linkAttrib(graphics_->uv_, 1, 2, GL_FLOAT, 0, nullptr);
-  // setup the EBO
-  graphics_->indices_count_ = indices.size();
-  graphics_->ebo_.setup(indices);
+  // give back the old mesh and get a new one
+  createMesh(shape_template);
   // change the texture
   // graphics_->texture_ = Resources::getTexture("aerolite_01");
 }
@@ -337,13 +307,13 @@ void ktp::AerolitePhysicsComponent::split() {
     // the new Aerolite
     AerolitePhysicsComponent* aerolite {nullptr};
     for (std::size_t i = 0; i < pieces; ++i) {
-      aerolite = static_cast<AerolitePhysicsComponent*>(GameEntity::createEntity(EntityTypes::Aerolite)->physics());
-      if (!aerolite) return;
+      const auto entity {GameEntity::createAerolite(piece_size)};
+      if (!entity) return;
+      aerolite = static_cast<AerolitePhysicsComponent*>(entity->physics());
       aerolite->new_born_ = false;
       aerolite->arrow_needed_ = false;
       aerolite->arrow_->owner()->deactivate();
       aerolite->arrow_ = nullptr;
-      aerolite->reshape(piece_size); // need this until we can use the size constructor
       aerolite->body_->SetAngularVelocity(old_angular * generateRand(-1.5f, 1.5f));
       aerolite->body_->SetLinearVelocity({old_delta.x * generateRand(0.5f, 1.5f), old_delta.y * generateRand(0.5f, 1.5f)});
       where.x = perpendicular.end.x + kSpacer * (perpendicular.begin.x - perpendicular.end.x);
@@ -389,15 +359,13 @@ void ktp::AerolitePhysicsComponent::update(const GameEntity& aerolite, float del
   }
   if (new_born_ && Game::gameplay_timer_.milliseconds() - born_time_ > kNewBornTime_) new_born_ = false;
 
-  updateMVP();
+  updateTransform();
+  graphics_->setBounds({kMetersToPixels * aabb_.lowerBound, kMetersToPixels * aabb_.upperBound});
   if (arrow_needed_) positionArrow();
 }
 
-void ktp::AerolitePhysicsComponent::updateMVP() {
-  glm::mat4 model {1.f};
-  model = glm::translate(model, glm::vec3(body_->GetPosition().x * kMetersToPixels, body_->GetPosition().y * kMetersToPixels, 0.f));
-  model = glm::rotate(model, body_->GetAngle(), glm::vec3(0.f, 0.f, 1.f));
-  graphics_->mvp_ = camera_.projectionMatrix() * camera_.viewMatrix() * model;
+void ktp::AerolitePhysicsComponent::updateTransform() {
+  graphics_->setTransform({body_->GetPosition().x * kMetersToPixels, body_->GetPosition().y * kMetersToPixels}, body_->GetAngle());
 }
 
 // ARROW GRAPHICS
@@ -411,6 +379,8 @@ ktp::AeroliteArrowGraphicsComponent::AeroliteArrowGraphicsComponent() {
   vertices_.setup(arrow_shape);
   // shape
   vao_.linkAttrib(vertices_, 0, 3, GL_FLOAT, 3 * sizeof(GLfloat), nullptr);
+  vao_.label("aerolite arrow", MemoryCategory::Entities);
+  vertices_.label("aerolite arrow vertices", MemoryCategory::Entities);
 }
 
 void ktp::AeroliteArrowGraphicsComponent::update(const GameEntity& aerolite_arrow) {
@@ -468,6 +438,7 @@ ktp::AeroliteSpawnerPhysicsComponent::AeroliteSpawnerPhysicsComponent(GameEntity
 
   b2BodyDef body_def {};
   body_def.type = b2_staticBody;
+  body_def.bullet = ConfigParser::aerolites_config.spawner_collision_.bullet_;
   body_def.userData.pointer = reinterpret_cast<uintptr_t>(owner_);
   body_ = world_->CreateBody(&body_def);
 
@@ -475,6 +446,7 @@ ktp::AeroliteSpawnerPhysicsComponent::AeroliteSpawnerPhysicsComponent(GameEntity
   shape.m_radius = 4.f;
 
   b2FixtureDef fixture_def {};
+  fixture_def.filter = collisionFilter(ConfigParser::aerolites_config.spawner_collision_);
   fixture_def.shape = &shape;
   fixture_def.isSensor = true;
 
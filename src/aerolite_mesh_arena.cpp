@@ -0,0 +1,233 @@
+#include "include/aerolite_mesh_arena.hpp"
+#include "include/config_parser.hpp"
+#include "include/palette.hpp"
+#include "include/resources.hpp"
+#include "sdl2_wrappers/sdl2_log.hpp"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm> // std::lower_bound std::max std::sort
+#include <string> // std::to_string
+
+/* FREE LIST ALLOCATOR */
+
+GLint ktp::FreeListAllocator::allocate(GLsizei count) {
+  if (count <= 0) return -1;
+  for (auto it = free_blocks_.begin(); it != free_blocks_.end(); ++it) {
+    if (it->count_ >= count) {
+      const auto offset {it->offset_};
+      it->offset_ += count;
+      it->count_ -= count;
+      if (it->count_ == 0) free_blocks_.erase(it);
+      return offset;
+    }
+  }
+  return -1;
+}
+
+void ktp::FreeListAllocator::grow(GLsizei new_capacity) {
+  if (new_capacity <= capacity_) return;
+  const auto old_capacity {capacity_};
+  capacity_ = new_capacity;
+  release(old_capacity, new_capacity - old_capacity);
+}
+
+void ktp::FreeListAllocator::release(GLint offset, GLsizei count) {
+  if (offset < 0 || count <= 0) return;
+  auto it {std::lower_bound(free_blocks_.begin(), free_blocks_.end(), offset, [](const Block& block, GLint value) {
+    return block.offset_ < value;
+  })};
+  it = free_blocks_.insert(it, Block{offset, count});
+  // merge with the next block
+  const auto next {it + 1};
+  if (next != free_blocks_.end() && it->offset_ + it->count_ == next->offset_) {
+    it->count_ += next->count_;
+    free_blocks_.erase(next);
+  }
+  // merge with the previous block
+  if (it != free_blocks_.begin()) {
+    const auto prev {it - 1};
+    if (prev->offset_ + prev->count_ == it->offset_) {
+      prev->count_ += it->count_;
+      free_blocks_.erase(it);
+    }
+  }
+}
+
+void ktp::FreeListAllocator::reset() {
+  free_blocks_.clear();
+  capacity_ = 0;
+}
+
+/* AEROLITE MESH ARENA */
+
+std::unique_ptr<ktp::AeroliteMeshArena::Buffers>    ktp::AeroliteMeshArena::buffers_ {nullptr};
+GLsizei                                             ktp::AeroliteMeshArena::draw_calls_ {};
+ktp::FreeListAllocator                              ktp::AeroliteMeshArena::index_allocator_ {};
+std::vector<glm::vec4>                              ktp::AeroliteMeshArena::instances_data_ {};
+std::vector<ktp::AeroliteMeshArena::QueuedAerolite> ktp::AeroliteMeshArena::queue_ {};
+ktp::FreeListAllocator                              ktp::AeroliteMeshArena::vertex_allocator_ {};
+
+ktp::MeshRange ktp::AeroliteMeshArena::allocate(const GLfloatVector& vertices, const GLfloatVector& uv, const GLuintVector& indices) {
+  if (!buffers_) createBuffers();
+  MeshRange range {};
+  range.vertex_count_ = static_cast<GLsizei>(vertices.size() / 3u);
+  range.index_count_  = static_cast<GLsizei>(indices.size());
+  // vertices
+  range.base_vertex_ = vertex_allocator_.allocate(range.vertex_count_);
+  if (range.base_vertex_ < 0) {
+    growVertices(vertex_allocator_.capacity() + range.vertex_count_);
+    range.base_vertex_ = vertex_allocator_.allocate(range.vertex_count_);
+  }
+  // indices
+  range.first_index_ = index_allocator_.allocate(range.index_count_);
+  if (range.first_index_ < 0) {
+    growIndices(index_allocator_.capacity() + range.index_count_);
+    range.first_index_ = index_allocator_.allocate(range.index_count_);
+  }
+  // interleave positions and texture coords: {x, y, z, u, v, x, y, ...}
+  GLfloatVector interleaved {};
+  interleaved.reserve(range.vertex_count_ * kVertexComponents_);
+  for (std::size_t i = 0; i < static_cast<std::size_t>(range.vertex_count_); ++i) {
+    interleaved.push_back(vertices[i * 3u]);
+    interleaved.push_back(vertices[i * 3u + 1u]);
+    interleaved.push_back(vertices[i * 3u + 2u]);
+    interleaved.push_back(uv[i * 2u]);
+    interleaved.push_back(uv[i * 2u + 1u]);
+  }
+  buffers_->vertices_.setupSubData(interleaved, range.base_vertex_ * kVertexComponents_ * sizeof(GLfloat));
+  // the EBO binding is part of the VAO state, so bind ours first
+  buffers_->vao_.bind();
+  buffers_->indices_.setupSubData(indices, range.first_index_ * sizeof(GLuint));
+  return range;
+}
+
+void ktp::AeroliteMeshArena::clean() {
+  buffers_ = nullptr;
+  index_allocator_.reset();
+  vertex_allocator_.reset();
+  instances_data_.clear();
+  queue_.clear();
+}
+
+void ktp::AeroliteMeshArena::createBuffers() {
+  buffers_ = std::make_unique<Buffers>();
+  buffers_->shader_  = Resources::getShader("aerolite");
+  buffers_->texture_ = &Resources::getTexture("aerolite_00");
+  buffers_->vertices_.setup(nullptr, kInitialVertices_ * kVertexComponents_ * sizeof(GLfloat), GL_DYNAMIC_DRAW);
+  buffers_->vao_.bind();
+  buffers_->indices_.setup(nullptr, kInitialIndices_ * sizeof(GLuint), GL_DYNAMIC_DRAW);
+  buffers_->instances_.setup(nullptr, kInitialInstances_ * sizeof(glm::vec4), GL_STREAM_DRAW);
+  buffers_->instances_capacity_ = kInitialInstances_;
+  vertex_allocator_.reset();
+  vertex_allocator_.grow(kInitialVertices_);
+  index_allocator_.reset();
+  index_allocator_.grow(kInitialIndices_);
+  linkAttributes();
+  // all the aerolites share the same color
+  const glm::vec4 color {Palette::colorToGlmVec4(ConfigParser::aerolites_config.colors_[1])};
+  buffers_->shader_.use();
+  buffers_->shader_.setFloat4("color", glm::value_ptr(color));
+}
+
+void ktp::AeroliteMeshArena::draw(const glm::mat4& view_projection) {
+  draw_calls_ = 0;
+  if (!buffers_ || queue_.empty()) {
+    queue_.clear();
+    return;
+  }
+  // aerolites sharing a mesh end up together, so they can go in one instanced call
+  std::sort(queue_.begin(), queue_.end(), [](const QueuedAerolite& a, const QueuedAerolite& b) {
+    return a.range_.first_index_ < b.range_.first_index_;
+  });
+  instances_data_.clear();
+  for (const auto& queued: queue_) instances_data_.push_back(queued.transform_);
+  const auto instances_count {static_cast<GLsizei>(instances_data_.size())};
+  if (instances_count > buffers_->instances_capacity_) {
+    buffers_->instances_capacity_ = std::max(instances_count, buffers_->instances_capacity_ * 2);
+  }
+  // orphan the old store so we don't wait for the previous frame
+  buffers_->instances_.setup(nullptr, buffers_->instances_capacity_ * sizeof(glm::vec4), GL_STREAM_DRAW);
+  buffers_->instances_.setupSubData(instances_data_);
+
+  buffers_->shader_.use();
+  buffers_->shader_.setMat4f("mvp", glm::value_ptr(view_projection));
+  buffers_->texture_->bind();
+  buffers_->vao_.bind();
+
+  const bool base_instance {GLEW_ARB_base_instance == GL_TRUE};
+  std::size_t i {0};
+  while (i < queue_.size()) {
+    const auto& range {queue_[i].range_};
+    std::size_t j {i + 1u};
+    while (j < queue_.size() && queue_[j].range_.first_index_ == range.first_index_) ++j;
+    const auto instances {static_cast<GLsizei>(j - i)};
+    const auto indices_offset {reinterpret_cast<void*>(range.first_index_ * sizeof(GLuint))};
+    if (base_instance) {
+      glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, range.index_count_, GL_UNSIGNED_INT, indices_offset, instances, range.base_vertex_, static_cast<GLuint>(i));
+    } else {
+      // no base instance, so move the start of the instanced attribute instead
+      glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), reinterpret_cast<void*>(i * sizeof(glm::vec4)));
+      glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.index_count_, GL_UNSIGNED_INT, indices_offset, instances, range.base_vertex_);
+    }
+    ++draw_calls_;
+    i = j;
+  }
+  queue_.clear();
+}
+
+void ktp::AeroliteMeshArena::growIndices(GLsizei min_capacity) {
+  const auto old_capacity {index_allocator_.capacity()};
+  const auto new_capacity {std::max(min_capacity, old_capacity * 2)};
+  EBO new_indices {};
+  buffers_->vao_.bind();
+  new_indices.setup(nullptr, new_capacity * sizeof(GLuint), GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_COPY_READ_BUFFER, buffers_->indices_.id());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, new_indices.id());
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_capacity * sizeof(GLuint));
+  buffers_->indices_ = std::move(new_indices);
+  index_allocator_.grow(new_capacity);
+  linkAttributes();
+  logMessage("Aerolite mesh arena indices grown to " + std::to_string(new_capacity));
+}
+
+void ktp::AeroliteMeshArena::growVertices(GLsizei min_capacity) {
+  const auto old_capacity {vertex_allocator_.capacity()};
+  const auto new_capacity {std::max(min_capacity, old_capacity * 2)};
+  VBO new_vertices {};
+  new_vertices.setup(nullptr, new_capacity * kVertexComponents_ * sizeof(GLfloat), GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_COPY_READ_BUFFER, buffers_->vertices_.id());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, new_vertices.id());
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_capacity * kVertexComponents_ * sizeof(GLfloat));
+  buffers_->vertices_ = std::move(new_vertices);
+  vertex_allocator_.grow(new_capacity);
+  linkAttributes();
+  logMessage("Aerolite mesh arena vertices grown to " + std::to_string(new_capacity));
+}
+
+void ktp::AeroliteMeshArena::linkAttributes() {
+  constexpr auto kStride {kVertexComponents_ * sizeof(GLfloat)};
+  // position
+  buffers_->vao_.linkAttrib(buffers_->vertices_, 0, 3, GL_FLOAT, kStride, nullptr);
+  // texture coords
+  buffers_->vao_.linkAttrib(buffers_->vertices_, 1, 2, GL_FLOAT, kStride, (void*)(3 * sizeof(GLfloat)));
+  // per aerolite transform {x, y, cos, sin}
+  buffers_->vao_.linkAttrib(buffers_->instances_, 5, 4, GL_FLOAT, sizeof(glm::vec4), nullptr);
+  glVertexAttribDivisor(5, 1);
+  buffers_->indices_.bind();
+  // the buffers may have just grown into new ones
+  buffers_->vao_.label("aerolite arena", MemoryCategory::Aerolites);
+  buffers_->vertices_.label("aerolite arena vertices", MemoryCategory::Aerolites);
+  buffers_->indices_.label("aerolite arena indices", MemoryCategory::Aerolites);
+  buffers_->instances_.label("aerolite arena instances", MemoryCategory::Aerolites);
+}
+
+void ktp::AeroliteMeshArena::queue(const MeshRange& range, const glm::vec4& transform) {
+  if (range.valid()) queue_.push_back({range, transform});
+}
+
+void ktp::AeroliteMeshArena::release(MeshRange& range) {
+  if (range.valid() && buffers_) {
+    vertex_allocator_.release(range.base_vertex_, range.vertex_count_);
+    index_allocator_.release(range.first_index_, range.index_count_);
+  }
+  range = MeshRange{};
+}
@@ -0,0 +1,186 @@
+#include "include/aerolite.hpp"
+#include "include/aerolite_shape_cache.hpp"
+#include "sdl2_wrappers/sdl2_log.hpp"
+#include <algorithm> // std::max std::min std::transform
+#include <cmath>     // std::lround
+#include <random>
+#include <string>    // std::to_string
+
+std::vector<std::vector<ktp::AeroliteTemplate>> ktp::AeroliteShapeCache::buckets_ {};
+ktp::ConfigParser::AeroliteCacheConfig          ktp::AeroliteShapeCache::config_ {};
+unsigned int                                    ktp::AeroliteShapeCache::hits_ {};
+float                                           ktp::AeroliteShapeCache::min_size_ {};
+unsigned int                                    ktp::AeroliteShapeCache::misses_ {};
+SDL_Thread*                                     ktp::AeroliteShapeCache::thread_ {nullptr};
+SDL_mutex*                                      ktp::AeroliteShapeCache::mutex_ {nullptr};
+SDL_cond*                                       ktp::AeroliteShapeCache::condition_ {nullptr};
+bool                                            ktp::AeroliteShapeCache::quit_ {false};
+std::vector<ktp::AeroliteTemplate>              ktp::AeroliteShapeCache::finished_ {};
+std::vector<unsigned int>                       ktp::AeroliteShapeCache::stock_ {};
+
+int ktp::AeroliteShapeCache::bucket(float size) {
+  if (buckets_.empty()) return -1;
+  const auto index {std::lround((size - min_size_) / config_.bucket_size_)};
+  return index < 0 || index >= static_cast<long>(buckets_.size()) ? -1 : static_cast<int>(index);
+}
+
+float ktp::AeroliteShapeCache::bucketSize(std::size_t bucket) {
+  return min_size_ + static_cast<float>(bucket) * config_.bucket_size_;
+}
+
+ktp::AeroliteTemplate ktp::AeroliteShapeCache::build(const Geometry::Polygon& shape, float size) {
+  AeroliteTemplate result {};
+  result.size_ = size;
+  // Box2D, fewer and bigger fixtures mean fewer broadphase proxies and contacts
+  std::vector<Geometry::Polygon> pieces {};
+  if (!Geometry::convexPartition(shape, pieces, b2_maxPolygonVertices)) {
+    logError("Aerolite shape can't be partitioned. Using its triangles.");
+    pieces.clear();
+    Geometry::triangulate(shape, pieces);
+  }
+  const auto density {ConfigParser::aerolites_config.density_};
+  B2Vec2Vector points {};
+  result.pieces_.reserve(pieces.size());
+  for (const auto& piece: pieces) {
+    points.clear();
+    for (const auto& point: piece) points.push_back({point.x, point.y});
+    b2PolygonShape polygon_shape {};
+    polygon_shape.Set(points.data(), static_cast<int32>(points.size()));
+    b2MassData piece_mass {};
+    polygon_shape.ComputeMass(&piece_mass, density);
+    result.mass_data_.mass += piece_mass.mass;
+    result.mass_data_.center += piece_mass.mass * piece_mass.center;
+    result.mass_data_.I += piece_mass.I;
+    result.pieces_.push_back(polygon_shape);
+  }
+  if (result.mass_data_.mass > 0.f) result.mass_data_.center *= 1.f / result.mass_data_.mass;
+  // OpenGL, the shapes are star-shaped around the origin, so it's a fan
+  const Geometry::Point origin {0.f, 0.f};
+  const auto vertices {Geometry::triangulateIndices(shape, result.indices_, &origin)};
+  result.vertices_.reserve(vertices * 3u);
+  for (std::size_t i = 0; i < vertices; ++i) {
+    const auto& point {i < shape.size() ? shape[i] : origin};
+    result.vertices_.push_back(point.x);
+    result.vertices_.push_back(point.y);
+    result.vertices_.push_back(0.f);
+  }
+  // convert cartesian coords to UV coords
+  result.uv_ = AerolitePhysicsComponent::convertToUV(result.vertices_);
+  // convert box2d coords to pixels
+  std::transform(result.vertices_.begin(), result.vertices_.end(), result.vertices_.begin(), [](auto coord){return coord * kMetersToPixels;});
+  return result;
+}
+
+void ktp::AeroliteShapeCache::clean() {
+  if (thread_) {
+    SDL_LockMutex(mutex_);
+    quit_ = true;
+    SDL_CondSignal(condition_);
+    SDL_UnlockMutex(mutex_);
+    SDL_WaitThread(thread_, nullptr);
+    thread_ = nullptr;
+  }
+  if (condition_) SDL_DestroyCond(condition_);
+  if (mutex_) SDL_DestroyMutex(mutex_);
+  condition_ = nullptr;
+  mutex_ = nullptr;
+  quit_ = false;
+  for (auto& templates: buckets_) {
+    for (auto& shape_template: templates) AeroliteMeshArena::release(shape_template.mesh_);
+  }
+  buckets_.clear();
+  finished_.clear();
+  stock_.clear();
+}
+
+void ktp::AeroliteShapeCache::init(const ConfigParser::AeroliteCacheConfig& config, bool headless) {
+  config_ = config;
+  hits_ = misses_ = 0u;
+  if (!config_.enabled_ || headless) return;
+  // from the smallest piece of a split to the biggest spawn
+  const auto& size {ConfigParser::aerolites_config.size_};
+  min_size_ = AerolitePhysicsComponent::kMinSize_ * 0.5f;
+  const auto max_size {std::max(size.value_ * size.rand_max_, min_size_)};
+  const auto count {static_cast<std::size_t>((max_size - min_size_) / config_.bucket_size_) + 1u};
+  buckets_.resize(count);
+  stock_.assign(count, 0u);
+
+  mutex_ = SDL_CreateMutex();
+  condition_ = SDL_CreateCond();
+  if (mutex_ && condition_) thread_ = SDL_CreateThread(run, "aerolite shapes", nullptr);
+  if (!thread_) {
+    logSDL2Error("SDL_CreateThread");
+    logMessage("Warning! Aerolite shape cache not available. Building every shape when needed.");
+    clean();
+    return;
+  }
+  logMessage("Aerolite shape cache: " + std::to_string(count) + " buckets of " + std::to_string(config_.per_bucket_) + " templates");
+}
+
+unsigned int ktp::AeroliteShapeCache::ready() {
+  unsigned int count {};
+  for (const auto& templates: buckets_) count += static_cast<unsigned int>(templates.size());
+  return count;
+}
+
+int ktp::AeroliteShapeCache::run(void*) {
+  // rand() belongs to the main thread
+  std::mt19937 engine {std::random_device{}()};
+  SDL_LockMutex(mutex_);
+  while (!quit_) {
+    // the emptiest bucket first
+    auto wanted {stock_.size()};
+    for (std::size_t i = 0; i < stock_.size(); ++i) {
+      if (stock_[i] < config_.per_bucket_ && (wanted == stock_.size() || stock_[i] < stock_[wanted])) wanted = i;
+    }
+    if (wanted == stock_.size()) {
+      SDL_CondWait(condition_, mutex_);
+      continue;
+    }
+    // counted now, so it isn't built twice
+    ++stock_[wanted];
+    SDL_UnlockMutex(mutex_);
+    const auto size {bucketSize(wanted)};
+    auto shape_template {build(AerolitePhysicsComponent::generateAeroliteShape(size, engine), size)};
+    SDL_LockMutex(mutex_);
+    finished_.push_back(std::move(shape_template));
+  }
+  SDL_UnlockMutex(mutex_);
+  return 0;
+}
+
+ktp::AeroliteTemplate ktp::AeroliteShapeCache::take(float size) {
+  const auto index {bucket(size)};
+  if (index >= 0 && !buckets_[index].empty()) {
+    auto shape_template {std::move(buckets_[index].back())};
+    buckets_[index].pop_back();
+    ++hits_;
+    SDL_LockMutex(mutex_);
+    --stock_[index];
+    SDL_CondSignal(condition_);
+    SDL_UnlockMutex(mutex_);
+    return shape_template;
+  }
+  if (thread_) ++misses_;
+  return build(AerolitePhysicsComponent::generateAeroliteShape(size), size);
+}
+
+void ktp::AeroliteShapeCache::update() {
+  if (!thread_) return;
+  std::vector<AeroliteTemplate> finished {};
+  SDL_LockMutex(mutex_);
+  const auto uploads {std::min(finished_.size(), kMaxUploads_)};
+  for (std::size_t i = 0; i < uploads; ++i) {
+    finished.push_back(std::move(finished_.back()));
+    finished_.pop_back();
+  }
+  SDL_UnlockMutex(mutex_);
+  for (auto& shape_template: finished) {
+    shape_template.mesh_ = AeroliteMeshArena::allocate(shape_template.vertices_, shape_template.uv_, shape_template.indices_);
+    // the arena has them now
+    shape_template.vertices_ = {};
+    shape_template.uv_ = {};
+    shape_template.indices_ = {};
+    buckets_[bucket(shape_template.size_)].push_back(std::move(shape_template));
+  }
+}
@@ -1,6 +1,7 @@
 #include "include/background.hpp"
 #include "include/camera.hpp"
 #include "include/box2d_utils.hpp"
+#include <cmath> // std::fmod
 #include <ctime>
 #include <random>
 
@@ -20,10 +21,14 @@ ktp::BackgroundGraphicsComponent::BackgroundGraphicsComponent() {
   vao_.linkAttrib(vertices_, 0, 3, GL_FLOAT, 3 * sizeof(GLfloat), nullptr);
   // EBO
   indices_.setup(indices_data_);
+  vao_.label("background", MemoryCategory::Stars);
+  vertices_.label("background vertices", MemoryCategory::Stars);
+  indices_.label("background indices", MemoryCategory::Stars);
 }
 
 void ktp::BackgroundGraphicsComponent::update(const GameEntity& background) {
   shader_.use();
+  shader_.setFloat("time", static_cast<GLfloat>(scroll_time_));
   vao_.bind();
   glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indices_data_.size()), GL_UNSIGNED_INT, 0, stars_count_);
 }
@@ -34,15 +39,21 @@ ktp::BackgroundPhysicsComponent::BackgroundPhysicsComponent(GameEntity* owner, B
   owner_ = owner;
   generateStars();
   graphics_->stars_count_ = stars_.size();
-  // subdata
+  // every star is back where it started after this long
+  scroll_period_ = b2_screen_size_.y * kMetersToPixels / kSpeedStep_;
+  // subdata is uploaded only once, the vertex shader does the scrolling
   graphics_->vao_.bind();
-  graphics_->subdata_.setup(nullptr, subdata_.size() * sizeof(GLfloat), GL_STREAM_DRAW);
-  // subdata translations
-  graphics_->vao_.linkAttrib(graphics_->subdata_, 1, 2, GL_FLOAT, kComponents_ * sizeof(GLfloat), nullptr);
+  graphics_->subdata_.setup(subdata_.data(), subdata_.size() * sizeof(GLfloat), GL_STATIC_DRAW);
+  // subdata starting positions and speeds
+  graphics_->vao_.linkAttrib(graphics_->subdata_, 1, 3, GL_FLOAT, kComponents_ * sizeof(GLfloat), nullptr);
   glVertexAttribDivisor(1, 1);
   // subdata colors
-  graphics_->vao_.linkAttrib(graphics_->subdata_, 2, 4, GL_FLOAT, kComponents_ * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
+  graphics_->vao_.linkAttrib(graphics_->subdata_, 2, 4, GL_FLOAT, kComponents_ * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
   glVertexAttribDivisor(2, 1);
+  graphics_->subdata_.label("background stars", MemoryCategory::Stars);
+  graphics_->shader_.use();
+  graphics_->shader_.setFloat("height", b2_screen_size_.y * kMetersToPixels);
+  updateMVP();
 }
 
 ktp::BackgroundPhysicsComponent& ktp::BackgroundPhysicsComponent::operator=(BackgroundPhysicsComponent&& other) {
@@ -53,9 +64,10 @@ ktp::BackgroundPhysicsComponent& ktp::BackgroundPhysicsComponent::operator=(Back
     owner_    = std::exchange(other.owner_, nullptr);
     size_     = other.size_;
     // own members
-    graphics_ = std::exchange(other.graphics_, nullptr);
-    stars_    = std::move(other.stars_);
-    subdata_  = std::move(other.subdata_);
+    graphics_      = std::exchange(other.graphics_, nullptr);
+    scroll_period_ = other.scroll_period_;
+    stars_         = std::move(other.stars_);
+    subdata_       = std::move(other.subdata_);
   }
   return *this;
 }
@@ -69,7 +81,8 @@ void ktp::BackgroundPhysicsComponent::generateStars() {
   #endif
   std::uniform_int_distribution<unsigned int> distribution_stars(0u, 6000u);
   std::uniform_int_distribution<unsigned int> distribution_colors(0u, graphics_->star_colors_.size() - 1u);
-  std::uniform_real_distribution<float> distribution_delta(0.001f, 0.1f);
+  // from 0.001 to 0.1, in steps of kSpeedStep_
+  std::uniform_int_distribution<unsigned int> distribution_delta(1u, 100u);
   Star star {};
 
   for (auto i = 0; i < (int)(b2_screen_size_.x * kMetersToPixels); ++i) {
@@ -78,9 +91,10 @@ void ktp::BackgroundPhysicsComponent::generateStars() {
         star.position_.x = (float)i;
         star.position_.y = (float)j;
         star.position_.z = 0.f;
+        star.delta_ = {0.f, -kSpeedStep_ * static_cast<float>(distribution_delta(generator))};
         subdata_.push_back(star.position_.x);
         subdata_.push_back(star.position_.y);
-        star.delta_ = {0.f, -distribution_delta(generator)};
+        subdata_.push_back(-star.delta_.y);
         if (stars_.size() % 2 == 0 && stars_.size() % 3 == 0) {
           star.color_ = Palette::colorToGlmVec4(graphics_->star_colors_.data()[distribution_colors(generator)]);
         } else {
@@ -97,17 +111,9 @@ void ktp::BackgroundPhysicsComponent::generateStars() {
 }
 
 void ktp::BackgroundPhysicsComponent::update(const GameEntity& background, float delta_time) {
-  for (std::size_t i = 0; i < stars_.size(); ++i) {
-    if (stars_[i].position_.y < 0.f) {
-      stars_[i].position_.y = b2_screen_size_.y * kMetersToPixels;
-      subdata_[i * kComponents_ + 1] = stars_[i].position_.y;
-    } else {
-      stars_[i].position_.y += stars_[i].delta_.y * delta_time;
-      subdata_[i * kComponents_ + 1] = stars_[i].position_.y;
-    }
-  }
-  graphics_->subdata_.setupSubData(subdata_.data(), subdata_.size() * sizeof(GLfloat));
-  updateMVP();
+  // the title state scales delta_time, so the speed factor comes along for free.
+  // Wrapped, so the shader's speed * time doesn't lose precision in long sessions
+  graphics_->scroll_time_ = std::fmod(graphics_->scroll_time_ + delta_time, scroll_period_);
 }
 
 void ktp::BackgroundPhysicsComponent::updateMVP() {
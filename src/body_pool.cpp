@@ -0,0 +1,80 @@
+#include "include/body_pool.hpp"
+
+namespace {
+
+// out of any view, but not so far that the floats lose the shapes
+const b2Vec2 kParkingSpot {-1.e5f, -1.e5f};
+
+} // namespace
+
+ktp::BodyPool::Counters                                       ktp::BodyPool::frame_ {};
+ktp::BodyPool::Counters                                       ktp::BodyPool::last_frame_ {};
+std::array<std::vector<b2Body*>, ktp::BodyPool::kArchetypes_> ktp::BodyPool::parked_ {};
+b2World*                                                      ktp::BodyPool::world_ {nullptr};
+
+b2Body* ktp::BodyPool::acquire(BodyArchetype archetype, const b2BodyDef& body_def) {
+  auto& parked {parked_[static_cast<std::size_t>(archetype)]};
+  if (parked.empty()) {
+    ++frame_.created_;
+    return world_->CreateBody(&body_def);
+  }
+  const auto body {parked.back()};
+  parked.pop_back();
+  ++frame_.reused_;
+  // still disabled, so nothing here touches the broadphase
+  if (body->GetType() != body_def.type) body->SetType(body_def.type);
+  body->SetTransform(body_def.position, body_def.angle);
+  body->SetLinearVelocity(body_def.linearVelocity);
+  body->SetAngularVelocity(body_def.angularVelocity);
+  body->SetLinearDamping(body_def.linearDamping);
+  body->SetAngularDamping(body_def.angularDamping);
+  body->SetBullet(body_def.bullet);
+  body->SetFixedRotation(body_def.fixedRotation);
+  body->SetGravityScale(body_def.gravityScale);
+  body->SetSleepingAllowed(body_def.allowSleep);
+  body->SetAwake(body_def.awake);
+  body->GetUserData().pointer = body_def.userData.pointer;
+  // the proxies are made once, where the body is now
+  if (body_def.enabled) body->SetEnabled(true);
+  return body;
+}
+
+void ktp::BodyPool::clear() {
+  for (auto& parked: parked_) parked.clear();
+}
+
+void ktp::BodyPool::endFrame() {
+  last_frame_ = frame_;
+  frame_ = {};
+}
+
+void ktp::BodyPool::init(b2World* world) {
+  world_ = world;
+  clear();
+  frame_ = last_frame_ = {};
+}
+
+std::size_t ktp::BodyPool::parked() {
+  std::size_t count {};
+  for (const auto& parked: parked_) count += parked.size();
+  return count;
+}
+
+void ktp::BodyPool::release(BodyArchetype archetype, b2Body* body) {
+  if (!body) return;
+  auto& parked {parked_[static_cast<std::size_t>(archetype)]};
+  if (parked.size() >= kMaxParked_) {
+    ++frame_.destroyed_;
+    world_->DestroyBody(body);
+    return;
+  }
+  ++frame_.parked_;
+  // no proxies and no contacts while it waits
+  body->SetEnabled(false);
+  // disabled bodies are still debug drawn, this one where nobody looks
+  body->SetTransform(kParkingSpot, 0.f);
+  body->SetLinearVelocity(b2Vec2_zero);
+  body->SetAngularVelocity(0.f);
+  body->GetUserData().pointer = 0;
+  parked.push_back(body);
+}
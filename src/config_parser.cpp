@@ -2,8 +2,11 @@
 #include "include/emitter.hpp"
 #include "include/resources.hpp"
 #include "sdl2_wrappers/sdl2_log.hpp"
-#include <algorithm> // std::transform
-#include <sstream> // std::ostringstream
+#include <algorithm> // std::find_if std::transform
+#include <cstdlib> // std::atof std::atoi
+#include <limits> // std::numeric_limits
+#include <sstream> // std::istringstream std::ostringstream std::stringstream
+#include <utility> // std::pair
 
 void ktp::ConfigParser::loadConfigFiles() {
   loadAerolitesConfig();
@@ -13,6 +16,39 @@ void ktp::ConfigParser::loadConfigFiles() {
   loadProjectilesConfig();
 }
 
+// COLLISIONS
+
+void ktp::ConfigParser::loadCollisionConfig(const pugi::xml_node& collision, const std::string& name, CollisionConfig& config) {
+  static const std::pair<std::string, CollisionLayer> layers[] {
+    {"aerolite",   kAeroliteLayer},
+    {"explosion",  kExplosionLayer},
+    {"player",     kPlayerLayer},
+    {"projectile", kProjectileLayer},
+    {"spawner",    kSpawnerLayer}
+  };
+  if (!collision) {
+    logMessage("Warning! " + name + " collision not set. Using default collision.");
+    return;
+  }
+  // Bullet
+  if (collision.attribute("bullet")) config.bullet_ = collision.attribute("bullet").as_bool();
+  // Collides with
+  if (collision.attribute("collidesWith")) {
+    std::uint16_t mask {};
+    std::istringstream names {collision.attribute("collidesWith").as_string()};
+    std::string layer_name {};
+    while (names >> layer_name) {
+      const auto layer {std::find_if(std::begin(layers), std::end(layers), [&layer_name](const auto& entry) { return entry.first == layer_name; })};
+      if (layer != std::end(layers)) {
+        mask |= layer->second;
+      } else {
+        logMessage("Warning! " + name + " collides with unknown layer \"" + layer_name + "\". Ignoring it.");
+      }
+    }
+    config.mask_ = mask;
+  }
+}
+
 // AEROLITES
 
 ktp::ConfigParser::AerolitesConfig ktp::ConfigParser::aerolites_config {};
@@ -41,6 +77,9 @@ void ktp::ConfigParser::loadAerolitesConfig() {
       }
       aerolites_config.colors_.shrink_to_fit();
     }
+    // Collision
+    loadCollisionConfig(aerolites.child("Box2D").child("collision"), "Aerolites", aerolites_config.collision_);
+    loadCollisionConfig(aerolites.child("Box2D").child("spawnerCollision"), "Aerolites spawner", aerolites_config.spawner_collision_);
     // Density
     if (aerolites.child("Box2D").child("density")) {
       const auto density {aerolites.child("Box2D").child("density").attribute("value").as_float()};
@@ -129,6 +168,10 @@ void ktp::ConfigParser::loadAerolitesConfig() {
   }
 }
 
+// BENCHMARK
+
+ktp::ConfigParser::BenchmarkConfig ktp::ConfigParser::benchmark_config {};
+
 // EMITTERS
 
 std::vector<ktp::EmitterType> ktp::ConfigParser::emitter_types {};
@@ -360,6 +403,93 @@ void ktp::ConfigParser::loadGameConfig() {
   const auto result {doc.load_file(path.c_str())};
   if (result) {
     const auto game {doc.child("game")};
+    // Aerolite shape cache
+    if (game.child("aeroliteCache")) {
+      const auto aerolite_cache {game.child("aeroliteCache")};
+      auto& config {game_config.aerolite_cache_};
+      config.enabled_ = aerolite_cache.attribute("enabled").as_bool(config.enabled_);
+      const auto bucket_size {aerolite_cache.attribute("bucketSize").as_float(config.bucket_size_)};
+      if (checkWithinRange(bucket_size, 0.05f, 1.f)) {
+        config.bucket_size_ = bucket_size;
+      } else {
+        logMessage("Warning! Aerolite cache bucket size out of range. Using default value.");
+      }
+      config.per_bucket_ = aerolite_cache.attribute("perBucket").as_uint(config.per_bucket_);
+    } else {
+      logMessage("Warning! Aerolite cache not set. Using default values.");
+    }
+    // Dynamic resolution
+    if (game.child("dynamicResolution")) {
+      const auto dynamic_resolution {game.child("dynamicResolution")};
+      auto& config {game_config.dynamic_resolution_};
+      config.enabled_ = dynamic_resolution.attribute("enabled").as_bool(config.enabled_);
+      const auto min_scale {dynamic_resolution.attribute("minScale").as_float(config.min_scale_)};
+      const auto max_scale {dynamic_resolution.attribute("maxScale").as_float(config.max_scale_)};
+      if (checkWithinRange(min_scale, 0.1f, 1.f) && checkWithinRange(max_scale, min_scale, 1.f)) {
+        config.min_scale_ = min_scale;
+        config.max_scale_ = max_scale;
+      } else {
+        logMessage("Warning! Dynamic resolution scales out of range. Using default scales.");
+      }
+      const auto target_frame_time {dynamic_resolution.attribute("targetFrameTime").as_float(config.target_frame_time_)};
+      if (target_frame_time > 0.f) {
+        config.target_frame_time_ = target_frame_time;
+      } else {
+        logMessage("Warning! Dynamic resolution target frame time less or equal than 0. Using default value.");
+      }
+    } else {
+      logMessage("Warning! Dynamic resolution not set. Using default values.");
+    }
+    // Fixed step
+    if (game.child("fixedStep")) {
+      const auto fixed_step {game.child("fixedStep")};
+      auto& config {game_config.fixed_step_};
+      const auto tick_rate {fixed_step.attribute("tickRate").as_uint(config.tick_rate_)};
+      if (checkWithinRange(tick_rate, 10u, 1000u)) {
+        config.tick_rate_ = tick_rate;
+      } else {
+        logMessage("Warning! Fixed step tick rate out of range. Using default value.");
+      }
+      const auto max_steps {fixed_step.attribute("maxSteps").as_uint(config.max_steps_)};
+      if (max_steps > 0u) {
+        config.max_steps_ = max_steps;
+      } else {
+        logMessage("Warning! Fixed step max steps equal to 0. Using default value.");
+      }
+    } else {
+      logMessage("Warning! Fixed step not set. Using default values.");
+    }
+    // Frame pacing
+    if (game.child("framePacing")) {
+      const auto frame_pacing {game.child("framePacing")};
+      auto& config {game_config.frame_pacing_};
+      config.target_fps_ = frame_pacing.attribute("targetFps").as_uint(config.target_fps_);
+      config.vsync_ = frame_pacing.attribute("vsync").as_string(config.vsync_.c_str());
+      const auto spin_time {frame_pacing.attribute("spinTime").as_float(config.spin_time_)};
+      if (checkWithinRange(spin_time, 0.f, 10.f)) {
+        config.spin_time_ = spin_time;
+      } else {
+        logMessage("Warning! Frame pacing spin time out of range. Using default value.");
+      }
+    } else {
+      logMessage("Warning! Frame pacing not set. Using default values.");
+    }
+    // OpenGL debug output, the defaults depend on the build type so it's optional
+    if (game.child("glDebug")) {
+      const auto gl_debug {game.child("glDebug")};
+      auto& config {game_config.gl_debug_};
+      config.enabled_ = gl_debug.attribute("enabled").as_bool(config.enabled_);
+      config.min_severity_ = gl_debug.attribute("minSeverity").as_string(config.min_severity_.c_str());
+    }
+    // Idle frame rates
+    if (game.child("idleFrameRate")) {
+      const auto idle_frame_rate {game.child("idleFrameRate")};
+      auto& config {game_config.idle_frame_rate_};
+      config.paused_ = idle_frame_rate.attribute("paused").as_uint(config.paused_);
+      config.title_ = idle_frame_rate.attribute("title").as_uint(config.title_);
+    } else {
+      logMessage("Warning! Idle frame rate not set. Using default values.");
+    }
     // Output system
     if (game.child("output")) {
       const auto output {game.child("output").attribute("value").as_bool()};
@@ -367,6 +497,12 @@ void ktp::ConfigParser::loadGameConfig() {
     } else {
       logMessage("Warning! Output system not set. Using default value (true).");
     }
+    // Physics thread
+    if (game.child("physicsThread")) {
+      game_config.physics_thread_ = game.child("physicsThread").attribute("enabled").as_bool(game_config.physics_thread_);
+    } else {
+      logMessage("Warning! Physics thread not set. Using default value (true).");
+    }
     // Screen size
     if (game.child("screenSize")) {
       const SDL_Point size {game.child("screenSize").attribute("x").as_int(), game.child("screenSize").attribute("y").as_int()};
@@ -380,6 +516,12 @@ void ktp::ConfigParser::loadGameConfig() {
     } else {
       logMessage("Warning! Screen size not set. Using default size.");
     }
+    // Shader binary cache
+    if (game.child("shaderCache")) {
+      game_config.shader_cache_ = game.child("shaderCache").attribute("enabled").as_bool(game_config.shader_cache_);
+    } else {
+      logMessage("Warning! Shader cache not set. Using default value (true).");
+    }
   } else {
     const std::string error_msg {
             "WARNING! " + kGameFile + " parsed with errors\n"
@@ -389,6 +531,72 @@ void ktp::ConfigParser::loadGameConfig() {
   }
 }
 
+// HEADLESS
+
+ktp::ConfigParser::HeadlessConfig ktp::ConfigParser::headless_config {};
+
+void ktp::ConfigParser::parseCommandLine(int argc, char* argv[]) {
+  // a positive number or the default
+  const auto positive = [](const char* arg, unsigned int default_value, const std::string& name) {
+    const auto value {std::atoi(arg)};
+    if (value > 0) return static_cast<unsigned int>(value);
+    logMessage("Warning! " + name + " must be greater than 0. Using default value.");
+    return default_value;
+  };
+  bool frames_set {false};
+  bool state_set {false};
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg {argv[i]};
+    const bool has_value {i + 1 < argc};
+    // headless
+    if (arg == "--headless") {
+      headless_config.enabled_ = true;
+    } else if (arg == "--frames" && has_value) {
+      headless_config.frames_ = positive(argv[++i], headless_config.frames_, "Headless frames");
+      frames_set = true;
+    } else if (arg == "--capture" && has_value) {
+      std::stringstream list {argv[++i]};
+      std::string frame {};
+      while (std::getline(list, frame, ',')) {
+        if (!frame.empty()) headless_config.capture_frames_.insert(static_cast<unsigned int>(std::atoi(frame.c_str())));
+      }
+    } else if (arg == "--output" && has_value) {
+      headless_config.output_path_ = argv[++i];
+    } else if (arg == "--state" && has_value) {
+      headless_config.state_ = argv[++i];
+      state_set = true;
+    // benchmark
+    } else if (arg == "--benchmark" && has_value) {
+      benchmark_config.enabled_ = true;
+      benchmark_config.scenario_ = argv[++i];
+    } else if (arg == "--count" && has_value) {
+      benchmark_config.count_ = positive(argv[++i], benchmark_config.count_, "Benchmark count");
+    } else if (arg == "--expect" && has_value) {
+      benchmark_config.expect_ = positive(argv[++i], benchmark_config.expect_, "Benchmark expected count");
+    } else if (arg == "--particles" && has_value) {
+      benchmark_config.particles_per_emitter_ = positive(argv[++i], benchmark_config.particles_per_emitter_, "Benchmark particles per emitter");
+    } else if (arg == "--ramp") {
+      benchmark_config.ramp_ = true;
+    } else if (arg == "--ramp-step" && has_value) {
+      benchmark_config.ramp_step_ = positive(argv[++i], benchmark_config.ramp_step_, "Benchmark ramp step");
+    } else if (arg == "--threshold" && has_value) {
+      const auto threshold {static_cast<float>(std::atof(argv[++i]))};
+      if (threshold > 0.f) {
+        benchmark_config.threshold_ = threshold;
+      } else {
+        logMessage("Warning! Benchmark threshold must be greater than 0. Using default value.");
+      }
+    } else {
+      logMessage("Warning! Unknown command line argument: " + arg);
+    }
+  }
+  // a benchmark ends by itself
+  if (benchmark_config.enabled_) {
+    if (!frames_set) headless_config.frames_ = std::numeric_limits<unsigned int>::max();
+    if (!state_set) headless_config.state_ = "testing";
+  }
+}
+
 // PLAYER
 
 ktp::ConfigParser::PlayerConfig ktp::ConfigParser::player_config {};
@@ -411,6 +619,8 @@ void ktp::ConfigParser::loadPlayerConfig() {
     } else {
       logMessage("Warning! Player color not set. Using default color.");
     }
+    // Collision
+    loadCollisionConfig(player.child("Box2D").child("collision"), "Player", player_config.collision_);
     // Density
     if (player.child("Box2D").child("density")) {
       const auto density {player.child("Box2D").child("density").attribute("value").as_float()};
@@ -531,6 +741,8 @@ void ktp::ConfigParser::loadProjectilesConfig() {
     } else {
       logMessage("Warning! Projectiles color not set. Using default color.");
     }
+    // Collision
+    loadCollisionConfig(projectiles.child("Box2D").child("collision"), "Projectiles", projectiles_config.collision_);
     // Density
     if (projectiles.child("Box2D").child("density")) {
       const auto density {projectiles.child("Box2D").child("density").attribute("value").as_float()};
@@ -553,6 +765,12 @@ void ktp::ConfigParser::loadProjectilesConfig() {
     } else {
       logMessage("Warning! Projectiles friction not set. Using default friction.");
     }
+    // Ray cast
+    if (projectiles.child("rayCast")) {
+      projectiles_config.ray_cast_ = projectiles.child("rayCast").attribute("value").as_bool();
+    } else {
+      logMessage("Warning! Projectiles ray cast not set. Using bodies.");
+    }
     // Restitution
     if (projectiles.child("Box2D").child("restitution")) {
       const auto restitution {projectiles.child("Box2D").child("restitution").attribute("value").as_float()};
@@ -609,6 +827,8 @@ void ktp::ConfigParser::loadProjectilesConfig() {
     } else {
       logMessage("Warning! Explosion color not set. Using default color.");
     }
+    // Explosion collision
+    loadCollisionConfig(projectiles.child("explosion").child("collision"), "Projectiles explosion", explosion_config.collision_);
     // Explosion density
     if (projectiles.child("explosion").child("density")) {
       const auto density {projectiles.child("explosion").child("density").attribute("value").as_float()};
@@ -686,6 +906,12 @@ void ktp::ConfigParser::loadProjectilesConfig() {
     } else {
       logMessage("Warning! Projectiles explosion restitution not set. Using default restitution.");
     }
+    // Explosion shrapnel
+    if (projectiles.child("explosion").child("shrapnel")) {
+      explosion_config.shrapnel_ = projectiles.child("explosion").child("shrapnel").attribute("value").as_bool();
+    } else {
+      logMessage("Warning! Projectiles explosion shrapnel not set. Using bodies for the rays.");
+    }
     projectiles_config.explosion_config_ = explosion_config;
   } else {
     const std::string error_msg {
@@ -2,6 +2,22 @@
 #include "include/contact_listener.hpp"
 #include "include/game_entity.hpp"
 
+void ktp::ContactFilter::endStep(const b2World& world) {
+  last_step_ = step_;
+  last_step_.contacts_ = world.GetContactCount();
+  step_ = {};
+}
+
+bool ktp::ContactFilter::ShouldCollide(b2Fixture* fixture_a, b2Fixture* fixture_b) {
+  const auto should_collide {b2ContactFilter::ShouldCollide(fixture_a, fixture_b)};
+  if (should_collide) {
+    ++step_.accepted_;
+  } else {
+    ++step_.filtered_;
+  }
+  return should_collide;
+}
+
 void ktp::ContactListener::BeginContact(b2Contact* contact) {
   if (!contact->GetFixtureA()->GetBody()->GetUserData().pointer
    || !contact->GetFixtureB()->GetBody()->GetUserData().pointer) return;
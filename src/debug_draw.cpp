@@ -2,167 +2,181 @@
 #include "include/debug_draw.hpp"
 #include "include/game.hpp"
 #include <glm/gtc/type_ptr.hpp>
+#include <cstddef> // offsetof
 
 // GLRenderLines
 
 ktp::GLRenderLines::GLRenderLines() {
-  vao_.bind();
-
-  vertices_attr_.setup(nullptr, sizeof(vertices_), GL_DYNAMIC_DRAW);
-  vao_.linkAttrib(vertices_attr_, 0, 2, GL_FLOAT, 0, nullptr);
-
-  colors_attr_.setup(nullptr, sizeof(colors_), GL_DYNAMIC_DRAW);
-  vao_.linkAttrib(colors_attr_, 1, 4, GL_FLOAT, 0, nullptr);
-}
-
-void ktp::GLRenderLines::addVertex(const b2Vec2& vertex, const b2Color& color) {
-  if (count_ == kMaxVertices * 2) update();
-
-  vertices_[count_] = vertex;
-  colors_[count_] = color;
-  ++count_;
+  vao_.linkAttrib(vertices_attr_, 0, 2, GL_FLOAT, sizeof(DebugVertex), (void*)offsetof(DebugVertex, position_));
+  vao_.linkAttrib(vertices_attr_, 1, 4, GL_FLOAT, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color_));
+  vao_.label("debug lines", MemoryCategory::Debug);
+  vertices_attr_.label("debug lines vertices", MemoryCategory::Debug);
 }
 
-void ktp::GLRenderLines::update() {
-  if (!count_) return;
+void ktp::GLRenderLines::update(const glm::mat4& mvp) {
+  if (vertices_.empty()) return;
 
-  updateMVP();
   shader_.use();
-  shader_.setMat4f("mvp", glm::value_ptr(mvp_));
+  shader_.setMat4f("mvp", glm::value_ptr(mvp));
 
   vao_.bind();
-  vertices_attr_.setupSubData(vertices_, count_ * sizeof(b2Vec2));
-  colors_attr_.setupSubData(colors_, count_ * sizeof(b2Color));
-
-  glDrawArrays(GL_LINES, 0, count_);
+  streamData(vertices_attr_, capacity_, vertices_);
+  glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(vertices_.size()));
 
-  count_ = 0;
-}
-
-void ktp::GLRenderLines::updateMVP() {
-  const glm::mat4 model {1.f};
-  mvp_ = Game::camera_.projectionMatrix() * Game::camera_.viewMatrix() * model;
+  vertices_.clear();
 }
 
 // GLRenderPoints
 
 ktp::GLRenderPoints::GLRenderPoints() {
-  vao_.bind();
-
-  vertices_attr_.setup(nullptr, sizeof(vertices_), GL_DYNAMIC_DRAW);
-  vao_.linkAttrib(vertices_attr_, 0, 2, GL_FLOAT, 0, nullptr);
-
-  colors_attr_.setup(nullptr, sizeof(colors_), GL_DYNAMIC_DRAW);
-  vao_.linkAttrib(colors_attr_, 1, 4, GL_FLOAT, 0, nullptr);
-
-  sizes_attr_.setup(nullptr, sizeof(sizes_), GL_DYNAMIC_DRAW);
-  vao_.linkAttrib(sizes_attr_, 2, 1, GL_FLOAT, 0, nullptr);
-}
-
-void ktp::GLRenderPoints::addVertex(const b2Vec2& vertex, const b2Color& color, float size) {
-  if (count_ == kMaxVertices) update();
-
-  vertices_[count_] = vertex;
-  colors_[count_] = color;
-  sizes_[count_] = size;
-  ++count_;
+  vao_.linkAttrib(points_attr_, 0, 2, GL_FLOAT, sizeof(DebugPoint), (void*)offsetof(DebugPoint, position_));
+  vao_.linkAttrib(points_attr_, 1, 4, GL_FLOAT, sizeof(DebugPoint), (void*)offsetof(DebugPoint, color_));
+  vao_.linkAttrib(points_attr_, 2, 1, GL_FLOAT, sizeof(DebugPoint), (void*)offsetof(DebugPoint, size_));
+  vao_.label("debug points", MemoryCategory::Debug);
+  points_attr_.label("debug points vertices", MemoryCategory::Debug);
 }
 
-void ktp::GLRenderPoints::update() {
-  if (!count_) return;
+void ktp::GLRenderPoints::update(const glm::mat4& mvp) {
+  if (points_.empty()) return;
 
-  updateMVP();
   shader_.use();
-  shader_.setMat4f("mvp", glm::value_ptr(mvp_));
+  shader_.setMat4f("mvp", glm::value_ptr(mvp));
 
   vao_.bind();
-  vertices_attr_.setupSubData(vertices_, count_ * sizeof(b2Vec2));
-  colors_attr_.setupSubData(colors_, count_ * sizeof(b2Color));
-  sizes_attr_.setupSubData(sizes_, count_ * sizeof(float));
+  streamData(points_attr_, capacity_, points_);
 
   glEnable(GL_PROGRAM_POINT_SIZE);
-	glDrawArrays(GL_POINTS, 0, count_);
-	glDisable(GL_PROGRAM_POINT_SIZE);
-
-  count_ = 0;
-}
+  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(points_.size()));
+  glDisable(GL_PROGRAM_POINT_SIZE);
 
-void ktp::GLRenderPoints::updateMVP() {
-  const glm::mat4 model {1.f};
-  mvp_ = Game::camera_.projectionMatrix() * Game::camera_.viewMatrix() * model;
+  points_.clear();
 }
 
 // GLRenderTriangles
 
 ktp::GLRenderTriangles::GLRenderTriangles() {
+  vao_.linkAttrib(vertices_attr_, 0, 2, GL_FLOAT, sizeof(DebugVertex), (void*)offsetof(DebugVertex, position_));
+  vao_.linkAttrib(vertices_attr_, 1, 4, GL_FLOAT, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color_));
+  vao_.label("debug triangles", MemoryCategory::Debug);
+  vertices_attr_.label("debug triangles vertices", MemoryCategory::Debug);
+}
+
+void ktp::GLRenderTriangles::update(const glm::mat4& mvp) {
+  if (vertices_.empty()) return;
+
+  shader_.use();
+  shader_.setMat4f("mvp", glm::value_ptr(mvp));
+
   vao_.bind();
+  streamData(vertices_attr_, capacity_, vertices_);
+  glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices_.size()));
 
-  vertices_attr_.setup(nullptr, sizeof(vertices_), GL_DYNAMIC_DRAW);
-  vao_.linkAttrib(vertices_attr_, 0, 2, GL_FLOAT, 0, nullptr);
+  vertices_.clear();
+}
 
-  colors_attr_.setup(nullptr, sizeof(colors_), GL_DYNAMIC_DRAW);
-  vao_.linkAttrib(colors_attr_, 1, 4, GL_FLOAT, 0, nullptr);
+// GLRenderCircles
+
+ktp::GLRenderCircles::GLRenderCircles() {
+  // unit circle: the center, the segments and the first point again to close the fan
+  GLfloatVector circle {0.f, 0.f};
+  for (auto i = 0u; i <= kSegments_; ++i) {
+    const auto angle {2.f * b2_pi * static_cast<float>(i % kSegments_) / static_cast<float>(kSegments_)};
+    circle.push_back(cosf(angle));
+    circle.push_back(sinf(angle));
+  }
+  mesh_.setup(circle);
+  // fills and outlines share the mesh but have their own instances
+  const auto link_attributes {[this](const VAO& vao, const VBO& instances) {
+    vao.linkAttrib(mesh_, 0, 2, GL_FLOAT, 2 * sizeof(GLfloat), nullptr);
+    vao.linkAttrib(instances, 1, 2, GL_FLOAT, sizeof(DebugCircle), (void*)offsetof(DebugCircle, center_));
+    glVertexAttribDivisor(1, 1);
+    vao.linkAttrib(instances, 2, 1, GL_FLOAT, sizeof(DebugCircle), (void*)offsetof(DebugCircle, radius_));
+    glVertexAttribDivisor(2, 1);
+    vao.linkAttrib(instances, 3, 4, GL_FLOAT, sizeof(DebugCircle), (void*)offsetof(DebugCircle, color_));
+    glVertexAttribDivisor(3, 1);
+  }};
+  link_attributes(fills_vao_, fills_attr_);
+  link_attributes(outlines_vao_, outlines_attr_);
+  mesh_.label("debug circle mesh", MemoryCategory::Debug);
+  fills_vao_.label("debug circle fills", MemoryCategory::Debug);
+  fills_attr_.label("debug circle fills instances", MemoryCategory::Debug);
+  outlines_vao_.label("debug circle outlines", MemoryCategory::Debug);
+  outlines_attr_.label("debug circle outlines instances", MemoryCategory::Debug);
 }
 
-void ktp::GLRenderTriangles::addVertex(const b2Vec2& vertex, const b2Color& color) {
-  if (count_ == kMaxVertices * 3) update();
+void ktp::GLRenderCircles::update(const glm::mat4& mvp) {
+  if (fills_.empty() && outlines_.empty()) return;
+
+  shader_.use();
+  shader_.setMat4f("mvp", glm::value_ptr(mvp));
+
+  if (!fills_.empty()) {
+    fills_vao_.bind();
+    streamData(fills_attr_, fills_capacity_, fills_);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, static_cast<GLsizei>(kSegments_ + 2u), static_cast<GLsizei>(fills_.size()));
+    fills_.clear();
+  }
+  if (!outlines_.empty()) {
+    outlines_vao_.bind();
+    streamData(outlines_attr_, outlines_capacity_, outlines_);
+    glDrawArraysInstanced(GL_LINE_LOOP, 1, static_cast<GLsizei>(kSegments_), static_cast<GLsizei>(outlines_.size()));
+    outlines_.clear();
+  }
+}
 
-  vertices_[count_] = vertex;
-  colors_[count_] = color;
-  ++count_;
+// GLRenderAABBs
+
+ktp::GLRenderAABBs::GLRenderAABBs() {
+  const GLfloatVector quad {
+    0.f, 0.f, // lower left
+    1.f, 0.f, // lower right
+    1.f, 1.f, // upper right
+    0.f, 1.f  // upper left
+  };
+  mesh_.setup(quad);
+  vao_.linkAttrib(mesh_, 0, 2, GL_FLOAT, 2 * sizeof(GLfloat), nullptr);
+  vao_.linkAttrib(aabbs_attr_, 1, 2, GL_FLOAT, sizeof(DebugAABB), (void*)offsetof(DebugAABB, lower_));
+  glVertexAttribDivisor(1, 1);
+  vao_.linkAttrib(aabbs_attr_, 2, 2, GL_FLOAT, sizeof(DebugAABB), (void*)offsetof(DebugAABB, upper_));
+  glVertexAttribDivisor(2, 1);
+  vao_.linkAttrib(aabbs_attr_, 3, 4, GL_FLOAT, sizeof(DebugAABB), (void*)offsetof(DebugAABB, color_));
+  glVertexAttribDivisor(3, 1);
+  mesh_.label("debug AABB mesh", MemoryCategory::Debug);
+  vao_.label("debug AABBs", MemoryCategory::Debug);
+  aabbs_attr_.label("debug AABBs instances", MemoryCategory::Debug);
 }
 
-void ktp::GLRenderTriangles::update() {
-  if (!count_) return;
+void ktp::GLRenderAABBs::update(const glm::mat4& mvp) {
+  if (aabbs_.empty()) return;
 
-  updateMVP();
   shader_.use();
-  shader_.setMat4f("mvp", glm::value_ptr(mvp_));
+  shader_.setMat4f("mvp", glm::value_ptr(mvp));
 
   vao_.bind();
-  vertices_attr_.setupSubData(vertices_, count_ * sizeof(b2Vec2));
-  colors_attr_.setupSubData(colors_, count_ * sizeof(b2Color));
-
-  // glEnable(GL_BLEND);
-  // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glDrawArrays(GL_TRIANGLES, 0, count_);
-  // glDisable(GL_BLEND);
-
-  count_ = 0;
-}
+  streamData(aabbs_attr_, capacity_, aabbs_);
+  glDrawArraysInstanced(GL_LINE_LOOP, 0, 4, static_cast<GLsizei>(aabbs_.size()));
 
-void ktp::GLRenderTriangles::updateMVP() {
-  const glm::mat4 model {1.f};
-  mvp_ = Game::camera_.projectionMatrix() * Game::camera_.viewMatrix() * model;
+  aabbs_.clear();
 }
 
 // DebugDraw
 
 void ktp::DebugDraw::Draw() {
-  lines_->update();
-  points_->update();
-  triangles_->update();
+  const glm::mat4 mvp {Game::camera_.projectionMatrix() * Game::camera_.viewMatrix()};
+  // fills first, so the outlines stay on top
+  triangles_->update(mvp);
+  circles_->update(mvp);
+  lines_->update(mvp);
+  aabbs_->update(mvp);
+  points_->update(mvp);
+}
+
+void ktp::DebugDraw::DrawAABB(const b2AABB& aabb, const b2Color& color) {
+  aabbs_->addAABB(kMetersToPixels * aabb.lowerBound, kMetersToPixels * aabb.upperBound, color);
 }
 
 void ktp::DebugDraw::DrawCircle(const b2Vec2& center, float radius, const b2Color& color) {
-  constexpr float segments {16.f};
-	constexpr float increment {2.f * b2_pi / segments};
-	const float sin_inc {sinf(increment)};
-	const float cos_inc {cosf(increment)};
-	b2Vec2 r1 {1.f, 0.f};
-	b2Vec2 v1 {center + radius * r1};
-	for (int32 i = 0; i < segments; ++i) {
-		// Perform rotation to avoid additional trigonometry.
-		const b2Vec2 r2 {
-		  cos_inc * r1.x - sin_inc * r1.y,
-		  sin_inc * r1.x + cos_inc * r1.y
-    };
-		const b2Vec2 v2 {center + radius * r2};
-		lines_->addVertex(kMetersToPixels * v1, color);
-		lines_->addVertex(kMetersToPixels * v2, color);
-		r1 = r2;
-		v1 = v2;
-	}
+  circles_->addOutline(kMetersToPixels * center, kMetersToPixels * radius, color);
 }
 
 void ktp::DebugDraw::DrawPoint(const b2Vec2& point, float size, const b2Color& color) {
@@ -180,44 +194,13 @@ void ktp::DebugDraw::DrawPolygon(const b2Vec2* vertices, int32 vertex_count, con
 }
 
 void ktp::DebugDraw::DrawSolidCircle(const b2Vec2& center, float radius, const b2Vec2& axis, const b2Color& color) {
-  constexpr float segments {16.f};
-	constexpr float increment {2.f * b2_pi / segments};
-	const float sin_inc {sinf(increment)};
-	const float cos_inc {cosf(increment)};
-	const b2Vec2 v0 {center};
-	b2Vec2 r1 {cos_inc, sin_inc};
-	b2Vec2 v1 {center + radius * r1};
-	const b2Color fill_color {0.5f * color.r, 0.5f * color.g, 0.5f * color.b, 0.5f};
-	for (int32 i = 0; i < segments; ++i) {
-		// Perform rotation to avoid additional trigonometry.
-		const b2Vec2 r2 {
-		  cos_inc * r1.x - sin_inc * r1.y,
-		  sin_inc * r1.x + cos_inc * r1.y
-    };
-		const b2Vec2 v2 {center + radius * r2};
-		triangles_->addVertex(kMetersToPixels * v0, fill_color);
-		triangles_->addVertex(kMetersToPixels * v1, fill_color);
-		triangles_->addVertex(kMetersToPixels * v2, fill_color);
-		r1 = r2;
-		v1 = v2;
-	}
-	r1.Set(1.f, 0.f);
-	v1 = center + radius * r1;
-	for (int32 i = 0; i < segments; ++i) {
-		const b2Vec2 r2 {
-		  cos_inc * r1.x - sin_inc * r1.y,
-		  sin_inc * r1.x + cos_inc * r1.y
-    };
-		const b2Vec2 v2 {center + radius * r2};
-		lines_->addVertex(kMetersToPixels * v1, color);
-		lines_->addVertex(kMetersToPixels * v2, color);
-		r1 = r2;
-		v1 = v2;
-	}
-	// Draw a line fixed in the circle to animate rotation.
-	const b2Vec2 p {center + radius * axis};
-	lines_->addVertex(kMetersToPixels * center, color);
-	lines_->addVertex(kMetersToPixels * p, color);
+  const b2Color fill_color {0.5f * color.r, 0.5f * color.g, 0.5f * color.b, 0.5f};
+  circles_->addFill(kMetersToPixels * center, kMetersToPixels * radius, fill_color);
+  circles_->addOutline(kMetersToPixels * center, kMetersToPixels * radius, color);
+  // Draw a line fixed in the circle to animate rotation.
+  const b2Vec2 p {center + radius * axis};
+  lines_->addVertex(kMetersToPixels * center, color);
+  lines_->addVertex(kMetersToPixels * p, color);
 }
 
 void ktp::DebugDraw::DrawSolidPolygon(const b2Vec2* vertices, int32 vertex_count, const b2Color& color) {
@@ -243,6 +226,23 @@ void ktp::DebugDraw::DrawSegment(const b2Vec2& start, const b2Vec2& end, const b
 	lines_->addVertex(kMetersToPixels * end, color);
 }
 
+void ktp::DebugDraw::DrawWorld(b2World& world) {
+  const auto flags {GetFlags()};
+  // b2World::DebugDraw() sends the AABBs as polygons, they go instanced from here instead
+  SetFlags(flags & ~e_aabbBit);
+  world.DebugDraw();
+  SetFlags(flags);
+  if (!(flags & e_aabbBit)) return;
+  // the same fat AABBs and color Box2D uses
+  const b2Color color {0.9f, 0.3f, 0.9f};
+  for (auto body {world.GetBodyList()}; body; body = body->GetNext()) {
+    if (!body->IsEnabled()) continue;
+    for (auto fixture {body->GetFixtureList()}; fixture; fixture = fixture->GetNext()) {
+      for (int32 i = 0; i < fixture->GetShape()->GetChildCount(); ++i) DrawAABB(fixture->GetAABB(i), color);
+    }
+  }
+}
+
 void ktp::DebugDraw::DrawTransform(const b2Transform& xf) {
   constexpr auto axis_scale {0.4f};
 	const b2Color red {1.f, 0.f, 0.f};
@@ -258,7 +258,17 @@ void ktp::DebugDraw::DrawTransform(const b2Transform& xf) {
 	lines_->addVertex(kMetersToPixels * p2, green);
 }
 
+void ktp::DebugDraw::Clean() {
+  aabbs_.reset();
+  circles_.reset();
+  lines_.reset();
+  points_.reset();
+  triangles_.reset();
+}
+
 void ktp::DebugDraw::Init() {
+  aabbs_ = std::make_unique<GLRenderAABBs>();
+  circles_ = std::make_unique<GLRenderCircles>();
   lines_ = std::make_unique<GLRenderLines>();
   points_ = std::make_unique<GLRenderPoints>();
   triangles_ = std::make_unique<GLRenderTriangles>();
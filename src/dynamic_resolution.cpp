@@ -0,0 +1,95 @@
+#include "include/config_parser.hpp"
+#include "include/dynamic_resolution.hpp"
+#include "include/resources.hpp"
+#include "sdl2_wrappers/sdl2_log.hpp"
+#include <algorithm> // std::clamp
+#include <cmath> // std::abs
+#include <string> // std::to_string
+
+void ktp::DynamicResolution::begin() const {
+  if (enabled_) {
+    fbo_.bind();
+    glViewport(0, 0, scaledWidth(), scaledHeight());
+  } else {
+    glBindFramebuffer(GL_FRAMEBUFFER, output_);
+  }
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void ktp::DynamicResolution::clean() {
+  fbo_ = FBO{};
+  screen_vao_ = nullptr;
+  enabled_ = false;
+}
+
+void ktp::DynamicResolution::end() const {
+  if (!enabled_) return;
+  // a fullscreen triangle instead of a blit, so the output can have any sample count
+  const GLboolean blend {glIsEnabled(GL_BLEND)};
+  const GLboolean cull_face {glIsEnabled(GL_CULL_FACE)};
+  const GLboolean depth_test {glIsEnabled(GL_DEPTH_TEST)};
+  GLint polygon_mode[2] {};
+  glGetIntegerv(GL_POLYGON_MODE, polygon_mode);
+  glBindFramebuffer(GL_FRAMEBUFFER, output_);
+  glViewport(0, 0, screen_size_.x, screen_size_.y);
+  // the triangle covers all the color, but the GUI may want a clean depth
+  glClear(GL_DEPTH_BUFFER_BIT);
+  glDisable(GL_BLEND);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_DEPTH_TEST);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  const auto shader {Resources::getShader("screen")};
+  shader.use();
+  shader.setInt("screen_texture", 0);
+  // only the scaled viewport of the target has the scene
+  shader.setVec2("uv_scale",
+    static_cast<GLfloat>(scaledWidth()) / static_cast<GLfloat>(fbo_.width()),
+    static_cast<GLfloat>(scaledHeight()) / static_cast<GLfloat>(fbo_.height())
+  );
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, fbo_.colorTexture());
+  screen_vao_->bind();
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  // back to what the state had
+  if (blend) glEnable(GL_BLEND);
+  if (cull_face) glEnable(GL_CULL_FACE);
+  if (depth_test) glEnable(GL_DEPTH_TEST);
+  glPolygonMode(GL_FRONT_AND_BACK, static_cast<GLenum>(polygon_mode[0]));
+}
+
+void ktp::DynamicResolution::init(const SDL_Point& screen_size) {
+  const auto& config {ConfigParser::game_config.dynamic_resolution_};
+  screen_size_ = screen_size;
+  min_scale_ = config.min_scale_;
+  max_scale_ = config.max_scale_;
+  scale_ = max_scale_;
+  target_frame_time_ = config.target_frame_time_;
+  average_frame_time_ = target_frame_time_;
+  frames_since_change_ = 0u;
+  enabled_ = config.enabled_;
+  if (!enabled_) return;
+  fbo_ = FBO{static_cast<GLsizei>(screen_size_.x * max_scale_), static_cast<GLsizei>(screen_size_.y * max_scale_)};
+  fbo_.label("dynamic resolution");
+  // the fullscreen triangle makes its vertices from gl_VertexID
+  screen_vao_ = std::make_unique<VAO>();
+  logMessage("Dynamic resolution enabled. Scale: " + std::to_string(min_scale_) + " - " + std::to_string(max_scale_));
+}
+
+void ktp::DynamicResolution::update(double frame_time) {
+  if (!enabled_) return;
+  // a moving average so single spikes don't change the scale
+  average_frame_time_ += (frame_time * 1000.0 - average_frame_time_) * kSmoothing_;
+  if (++frames_since_change_ < kCooldownFrames_) return;
+  auto new_scale {scale_};
+  if (average_frame_time_ > target_frame_time_ * kUpperTolerance_) {
+    new_scale -= kScaleStep_;
+  } else if (average_frame_time_ < target_frame_time_ * kLowerTolerance_) {
+    new_scale += kScaleStep_;
+  }
+  new_scale = std::clamp(new_scale, min_scale_, max_scale_);
+  // the scale moves in whole steps, so anything under half a step is no change
+  if (std::abs(new_scale - scale_) > 0.5f * kScaleStep_) {
+    scale_ = new_scale;
+    frames_since_change_ = 0u;
+  }
+}
@@ -21,6 +21,9 @@ ktp::EmitterGraphicsComponent::EmitterGraphicsComponent() {
   vao_.linkAttrib(vertices_, 1, 2, GL_FLOAT, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
   // EBO
   indices_.setup(indices_data_);
+  vao_.label("emitter", MemoryCategory::Particles);
+  vertices_.label("emitter vertices", MemoryCategory::Particles);
+  indices_.label("emitter indices", MemoryCategory::Particles);
 }
 
 ktp::EmitterGraphicsComponent& ktp::EmitterGraphicsComponent::operator=(EmitterGraphicsComponent&& other) {
@@ -43,7 +46,7 @@ ktp::EmitterGraphicsComponent& ktp::EmitterGraphicsComponent::operator=(EmitterG
 void ktp::EmitterGraphicsComponent::update(const GameEntity& emitter) {
   shader_.use();
   shader_.setMat4f("mvp", glm::value_ptr(mvp_));
-  texture_.bind();
+  texture_->bind();
   vao_.bind();
   glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indices_data_.size()), GL_UNSIGNED_INT, 0, *particles_pool_size_);
 }
@@ -173,14 +176,15 @@ void ktp::EmitterPhysicsComponent::setupOpenGL() {
   subdata_.resize(particles_pool_size_ * kComponents);
   graphics_->subdata_.setup(nullptr, subdata_.size() * sizeof(GLfloat), GL_STREAM_DRAW);
   // subdata translations
-  graphics_->vao_.linkAttrib(graphics_->subdata_, 2, 3, GL_FLOAT, kComponents * sizeof(GLfloat), nullptr);
-  glVertexAttribDivisor(2, 1);
-  // subdata colors
-  graphics_->vao_.linkAttrib(graphics_->subdata_, 3, 4, GL_FLOAT, kComponents * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+  graphics_->vao_.linkAttrib(graphics_->subdata_, 3, 3, GL_FLOAT, kComponents * sizeof(GLfloat), nullptr);
   glVertexAttribDivisor(3, 1);
+  // subdata colors
+  graphics_->vao_.linkAttrib(graphics_->subdata_, 2, 4, GL_FLOAT, kComponents * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+  glVertexAttribDivisor(2, 1);
   // subdata size
   graphics_->vao_.linkAttrib(graphics_->subdata_, 4, 1, GL_FLOAT, kComponents * sizeof(GLfloat), (void*)(7 * sizeof(GLfloat)));
   glVertexAttribDivisor(4, 1);
+  graphics_->subdata_.label("emitter particles", MemoryCategory::Particles);
 }
 
 void ktp::EmitterPhysicsComponent::update(const GameEntity& emitter, float delta_time) {
@@ -188,20 +192,29 @@ void ktp::EmitterPhysicsComponent::update(const GameEntity& emitter, float delta
     owner_->deactivate();
     return;
   }
+  // the extents of the alive particles, in pixels. Inverted if there are none, so it's culled
+  b2AABB bounds {{b2_maxFloat, b2_maxFloat}, {-b2_maxFloat, -b2_maxFloat}};
   for (auto i = 0u; i < particles_pool_size_; ++i) {
     if (particles_pool_[i].inUse()) {
+      const auto particle {&subdata_[i * kComponents]};
       // particle alive!
-      if (particles_pool_[i].update(delta_time, &subdata_[i * kComponents])) {
+      if (particles_pool_[i].update(delta_time, particle)) {
         // particle is no more, so we change the Z axis to 10
-        subdata_[i * kComponents + 0] = 0.f;
-        subdata_[i * kComponents + 1] = 0.f;
-        subdata_[i * kComponents + 2] = 10.f;
+        particle[0] = 0.f;
+        particle[1] = 0.f;
+        particle[2] = 10.f;
         particles_pool_[i].setNext(first_available_);
         first_available_ = &particles_pool_[i];
         --alive_particles_count_;
+      } else {
+        // the quad is size pixels wide
+        const auto half_size {0.5f * particle[7]};
+        bounds.lowerBound = b2Min(bounds.lowerBound, {particle[0] - half_size, particle[1] - half_size});
+        bounds.upperBound = b2Max(bounds.upperBound, {particle[0] + half_size, particle[1] + half_size});
       }
     }
   }
+  graphics_->setBounds(bounds);
   graphics_->subdata_.setupSubData(subdata_.data(), subdata_.size() * sizeof(GLfloat));
   // update the mvp matrix
   graphics_->mvp_ = camera_.projectionMatrix() * camera_.viewMatrix() * glm::mat4(1.f);
@@ -1,6 +1,9 @@
+#include "include/aerolite.hpp"
+#include "include/circle_sweep.hpp"
 #include "include/explosion.hpp"
 #include "include/game.hpp" // gameplay timer
 #include "include/game_entity.hpp"
+#include <algorithm> // std::find std::max std::min
 
 // GRAPHICS
 
@@ -19,9 +22,9 @@ void ktp::ExplosionGraphicsComponent::generateOpenGLStuff(float size) {
   // vertices
   vao_.linkAttrib(vertices_, 0, 3, GL_FLOAT, 8 * sizeof(GLfloat), nullptr);
   // colors
-  vao_.linkAttrib(vertices_, 1, 3, GL_FLOAT, 8 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+  vao_.linkAttrib(vertices_, 2, 3, GL_FLOAT, 8 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
   // texture
-  vao_.linkAttrib(vertices_, 2, 2, GL_FLOAT, 8 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
+  vao_.linkAttrib(vertices_, 1, 2, GL_FLOAT, 8 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
   // EBO
   indices_data_ = { 0, 1, 2, 0, 2, 3 };
   indices_.setup(indices_data_);
@@ -29,12 +32,20 @@ void ktp::ExplosionGraphicsComponent::generateOpenGLStuff(float size) {
   translations_.setup(nullptr, rays_ * sizeof(glm::vec3), GL_STREAM_DRAW);
   vao_.linkAttrib(translations_, 3, 3, GL_FLOAT, 0, nullptr);
   glVertexAttribDivisor(3, 1);
+  vao_.label("explosion", MemoryCategory::Particles);
+  vertices_.label("explosion vertices", MemoryCategory::Particles);
+  indices_.label("explosion indices", MemoryCategory::Particles);
+  translations_.label("explosion translations", MemoryCategory::Particles);
 }
 
 void ktp::ExplosionGraphicsComponent::update(const GameEntity& explosion) {
   if (render_) {
+    // the program is shared with the emitters, so the mvp goes in every draw
     shader_.use();
-    texture_.bind();
+    shader_.setMat4f("mvp", glm::value_ptr(mvp_));
+    // no sizes array here, every ray has the same one
+    glVertexAttrib1f(4, 1.f);
+    texture_->bind();
     vao_.bind();
     glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indices_data_.size()), GL_UNSIGNED_INT, 0, rays_);
   }
@@ -42,9 +53,47 @@ void ktp::ExplosionGraphicsComponent::update(const GameEntity& explosion) {
 
 // PHYSICS
 
+namespace {
+
+/**
+ * @brief Collects the fixtures the shrapnel of an explosion may hit this tick.
+ */
+class ShrapnelQuery: public b2QueryCallback {
+ public:
+  bool ReportFixture(b2Fixture* fixture) override {
+    // only what a ray's body would pair with
+    if (!ktp::shouldCollide(filter_, fixture->GetFilterData())) return true;
+    const auto entity {reinterpret_cast<ktp::GameEntity*>(fixture->GetBody()->GetUserData().pointer)};
+    // and not what is going away, like their projectile
+    if (entity && !entity->canBeDeactivated()) fixtures_.push_back(fixture);
+    return true;
+  }
+  b2Filter                filter_ {};
+  std::vector<b2Fixture*> fixtures_ {};
+};
+
+// scratch for the shrapnel of one explosion, main thread only
+ShrapnelQuery           shrapnel_query {};
+std::vector<float>      hit_fraction {};
+std::vector<b2Fixture*> hit_fixture {};
+std::vector<b2Vec2>     hit_normal {};
+
+} // namespace
+
 ktp::ExplosionPhysicsComponent::ExplosionPhysicsComponent(GameEntity* owner, ExplosionGraphicsComponent* graphics):
  graphics_(graphics) {
   owner_ = owner;
+  translations_data_.resize(explosion_config_.rays_);
+  if (explosion_config_.shrapnel_) {
+    shrapnel_.x_.resize(explosion_config_.rays_);
+    shrapnel_.y_.resize(explosion_config_.rays_);
+    shrapnel_.vx_.resize(explosion_config_.rays_);
+    shrapnel_.vy_.resize(explosion_config_.rays_);
+    shrapnel_.radius_ = explosion_config_.particle_radius_;
+    // what the fixture of a ray would weigh
+    shrapnel_.mass_ = explosion_config_.density_ * b2_pi * shrapnel_.radius_ * shrapnel_.radius_;
+    return;
+  }
   explosion_rays_.reserve(explosion_config_.rays_);
   b2Body* current_body {nullptr};
   for (std::size_t i = 0; i < explosion_config_.rays_; ++i) {
@@ -53,29 +102,31 @@ ktp::ExplosionPhysicsComponent::ExplosionPhysicsComponent(GameEntity* owner, Exp
     const b2Vec2 ray_dir {SDL_sinf(angle), SDL_cosf(angle)};
 
     b2BodyDef bd;
-    bd.bullet = true;
+    bd.bullet = explosion_config_.collision_.bullet_;
+    // disabled until it detonates
+    bd.enabled = false;
     bd.fixedRotation = true;
     bd.linearDamping = explosion_config_.linear_damping_;
     bd.linearVelocity = explosion_config_.blast_power_ * ray_dir;
     bd.type = b2_dynamicBody;
     bd.userData.pointer = reinterpret_cast<uintptr_t>(owner_);
-    current_body = world_->CreateBody(&bd);
+    current_body = BodyPool::acquire(BodyArchetype::ExplosionRay, bd);
 
-    b2CircleShape circle_shape;
-    circle_shape.m_radius = explosion_config_.particle_radius_;
+    // a recycled ray already has its fixture
+    if (!current_body->GetFixtureList()) {
+      b2CircleShape circle_shape;
+      circle_shape.m_radius = explosion_config_.particle_radius_;
 
-    b2FixtureDef fd;
-    fd.density = explosion_config_.density_;
-    fd.filter.groupIndex = -1;
-    fd.friction = explosion_config_.friction_;
-    fd.restitution = explosion_config_.restitution_;
-    fd.shape = &circle_shape;
+      b2FixtureDef fd;
+      fd.density = explosion_config_.density_;
+      fd.filter = collisionFilter(explosion_config_.collision_);
+      fd.friction = explosion_config_.friction_;
+      fd.restitution = explosion_config_.restitution_;
+      fd.shape = &circle_shape;
 
-    current_body->CreateFixture(&fd);
-    current_body->SetEnabled(false);
+      current_body->CreateFixture(&fd);
+    }
     explosion_rays_.push_back(current_body);
-
-    translations_data_.resize(explosion_config_.rays_);
   }
 }
 
@@ -92,6 +143,7 @@ ktp::ExplosionPhysicsComponent& ktp::ExplosionPhysicsComponent::operator=(Explos
     explosion_config_ = std::move(other.explosion_config_);
     explosion_rays_   = std::move(other.explosion_rays_);
     graphics_         = std::exchange(other.graphics_, nullptr);
+    shrapnel_         = std::move(other.shrapnel_);
   }
   return *this;
 }
@@ -99,6 +151,19 @@ ktp::ExplosionPhysicsComponent& ktp::ExplosionPhysicsComponent::operator=(Explos
 void ktp::ExplosionPhysicsComponent::detonate(Uint32 time, const b2Vec2& position) {
   detonated_ = true;
   detonation_time_ = time;
+  if (explosion_config_.shrapnel_) {
+    const auto rays {shrapnel_.x_.size()};
+    for (std::size_t i = 0; i < rays; ++i) {
+      // the same directions and speed the bodies get
+      const float angle {(i / (float)rays) * 360.f * (b2_pi / 180.f)};
+      shrapnel_.x_[i] = position.x;
+      shrapnel_.y_[i] = position.y;
+      shrapnel_.vx_[i] = explosion_config_.blast_power_ * SDL_sinf(angle);
+      shrapnel_.vy_[i] = explosion_config_.blast_power_ * SDL_cosf(angle);
+    }
+    shrapnel_.overlapped_.clear();
+    return;
+  }
   for (auto& body: explosion_rays_) {
     body->SetTransform(position, 0);
     body->SetEnabled(true);
@@ -112,11 +177,27 @@ void ktp::ExplosionPhysicsComponent::update(const GameEntity& explosion, float d
       return;
     } else {
       graphics_->render_ = true;
-      for (std::size_t i = 0; i < explosion_rays_.size(); ++i) {
-        translations_data_[i].x = explosion_rays_[i]->GetPosition().x * kMetersToPixels;
-        translations_data_[i].y = explosion_rays_[i]->GetPosition().y * kMetersToPixels;
+      if (explosion_config_.shrapnel_) {
+        updateShrapnel(delta_time);
+        for (std::size_t i = 0; i < shrapnel_.x_.size(); ++i) {
+          translations_data_[i].x = shrapnel_.x_[i] * kMetersToPixels;
+          translations_data_[i].y = shrapnel_.y_[i] * kMetersToPixels;
+        }
+      } else {
+        for (std::size_t i = 0; i < explosion_rays_.size(); ++i) {
+          translations_data_[i].x = explosion_rays_[i]->GetPosition().x * kMetersToPixels;
+          translations_data_[i].y = explosion_rays_[i]->GetPosition().y * kMetersToPixels;
+        }
       }
       graphics_->translations_.setupSubData(translations_data_.data(), translations_data_.size() * sizeof(glm::vec3));
+      // the extents of the particles, in pixels
+      const auto radius {explosion_config_.particle_radius_ * kMetersToPixels};
+      b2AABB bounds {{b2_maxFloat, b2_maxFloat}, {-b2_maxFloat, -b2_maxFloat}};
+      for (const auto& translation: translations_data_) {
+        bounds.lowerBound = b2Min(bounds.lowerBound, {translation.x - radius, translation.y - radius});
+        bounds.upperBound = b2Max(bounds.upperBound, {translation.x + radius, translation.y + radius});
+      }
+      graphics_->setBounds(bounds);
       updateMVP();
     }
   }
@@ -124,7 +205,122 @@ void ktp::ExplosionPhysicsComponent::update(const GameEntity& explosion, float d
 
 void ktp::ExplosionPhysicsComponent::updateMVP() {
   glm::mat4 model {1.f};
-  const glm::mat4 mvp {camera_.projectionMatrix() * camera_.viewMatrix() * model};
-  graphics_->shader_.use();
-  graphics_->shader_.setMat4f("mvp", glm::value_ptr(mvp));
+  graphics_->mvp_ = camera_.projectionMatrix() * camera_.viewMatrix() * model;
+}
+
+void ktp::ExplosionPhysicsComponent::shrapnelHit(GameEntity* other, const b2Vec2& point, const b2Vec2& normal) {
+  // what the contact listener does when a ray body touches them
+  switch (other->type()) {
+    case EntityTypes::Aerolite: {
+      const auto manifold {static_cast<AerolitePhysicsComponent*>(other->physics())->worldManifold()};
+      manifold->normal = normal;
+      manifold->points[0] = point;
+      other->physics()->collide(owner_);
+      collide(other);
+      break;
+    }
+    case EntityTypes::AeroliteSpawner:
+      other->physics()->collide(owner_);
+      break;
+    case EntityTypes::Projectile:
+      collide(other);
+      other->physics()->collide(owner_);
+      break;
+    default:
+      break;
+  }
+}
+
+void ktp::ExplosionPhysicsComponent::updateShrapnel(float delta_time) {
+  auto& x {shrapnel_.x_};
+  auto& y {shrapnel_.y_};
+  auto& vx {shrapnel_.vx_};
+  auto& vy {shrapnel_.vy_};
+  const auto count {x.size()};
+  const auto radius {shrapnel_.radius_};
+  // Box2D's damping, plain loops over plain arrays so the compiler can vectorize them
+  const auto damping {1.f / (1.f + delta_time * explosion_config_.linear_damping_)};
+  for (std::size_t i = 0; i < count; ++i) {
+    vx[i] *= damping;
+    vy[i] *= damping;
+  }
+  // everything the shrapnel sweeps this tick
+  b2AABB bounds {{b2_maxFloat, b2_maxFloat}, {-b2_maxFloat, -b2_maxFloat}};
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto end_x {x[i] + vx[i] * delta_time};
+    const auto end_y {y[i] + vy[i] * delta_time};
+    bounds.lowerBound.x = std::min(bounds.lowerBound.x, std::min(x[i], end_x));
+    bounds.lowerBound.y = std::min(bounds.lowerBound.y, std::min(y[i], end_y));
+    bounds.upperBound.x = std::max(bounds.upperBound.x, std::max(x[i], end_x));
+    bounds.upperBound.y = std::max(bounds.upperBound.y, std::max(y[i], end_y));
+  }
+  bounds.lowerBound -= b2Vec2{radius, radius};
+  bounds.upperBound += b2Vec2{radius, radius};
+  shrapnel_query.filter_ = collisionFilter(explosion_config_.collision_);
+  shrapnel_query.fixtures_.clear();
+  world_->QueryAABB(&shrapnel_query, bounds);
+
+  // every candidate against all the shrapnel, keeping the first hit of each one
+  hit_fraction.assign(count, 2.f);
+  hit_fixture.assign(count, nullptr);
+  hit_normal.resize(count);
+  for (const auto fixture: shrapnel_query.fixtures_) {
+    const auto shape_type {fixture->GetType()};
+    if (shape_type != b2Shape::e_circle && shape_type != b2Shape::e_polygon) continue;
+    const auto& transform {fixture->GetBody()->GetTransform()};
+    auto aabb {fixture->GetAABB(0)};
+    aabb.lowerBound -= b2Vec2{radius, radius};
+    aabb.upperBound += b2Vec2{radius, radius};
+    for (std::size_t i = 0; i < count; ++i) {
+      const b2Vec2 start {x[i], y[i]};
+      const b2Vec2 sweep {vx[i] * delta_time, vy[i] * delta_time};
+      const auto end {start + sweep};
+      if (std::max(start.x, end.x) < aabb.lowerBound.x || std::min(start.x, end.x) > aabb.upperBound.x
+       || std::max(start.y, end.y) < aabb.lowerBound.y || std::min(start.y, end.y) > aabb.upperBound.y) continue;
+      // in the frame of the body
+      const auto local_start {b2MulT(transform, start)};
+      const auto local_sweep {b2MulT(transform.q, sweep)};
+      float fraction {};
+      b2Vec2 normal {};
+      const auto hit {shape_type == b2Shape::e_circle
+        ? sweepCircle(*static_cast<const b2CircleShape*>(fixture->GetShape()), local_start, local_sweep, radius, fraction, normal)
+        : sweepPolygon(*static_cast<const b2PolygonShape*>(fixture->GetShape()), local_start, local_sweep, radius, fraction, normal)};
+      if (hit == SweepHit::Inside) {
+        // it doesn't stop it, and its entity is told once, like a ray body gets one BeginContact
+        const auto entity {reinterpret_cast<GameEntity*>(fixture->GetBody()->GetUserData().pointer)};
+        auto& overlapped {shrapnel_.overlapped_};
+        if (std::find(overlapped.begin(), overlapped.end(), entity) == overlapped.end()) {
+          overlapped.push_back(entity);
+          const auto world_normal {b2Mul(transform.q, normal)};
+          shrapnelHit(entity, start - radius * world_normal, world_normal);
+        }
+      } else if (hit == SweepHit::Enters && fraction < hit_fraction[i]) {
+        hit_fraction[i] = fraction;
+        hit_fixture[i] = fixture;
+        hit_normal[i] = b2Mul(transform.q, normal);
+      }
+    }
+  }
+
+  const auto restitution {explosion_config_.restitution_};
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto fixture {hit_fixture[i]};
+    // sensors are told, but don't stop anything
+    const auto fraction {fixture && !fixture->IsSensor() ? hit_fraction[i] : 1.f};
+    x[i] += vx[i] * delta_time * fraction;
+    y[i] += vy[i] * delta_time * fraction;
+    if (!fixture) continue;
+    const auto& normal {hit_normal[i]};
+    const b2Vec2 point {x[i] - radius * normal.x, y[i] - radius * normal.y};
+    shrapnelHit(reinterpret_cast<GameEntity*>(fixture->GetBody()->GetUserData().pointer), point, normal);
+    if (fixture->IsSensor()) continue;
+    // bounce, and the body gets the opposite impulse
+    const auto body {fixture->GetBody()};
+    const auto approach {b2Dot(b2Vec2{vx[i], vy[i]} - body->GetLinearVelocityFromWorldPoint(point), normal)};
+    if (approach >= 0.f) continue;
+    const auto delta_v {-(1.f + restitution) * approach};
+    vx[i] += delta_v * normal.x;
+    vy[i] += delta_v * normal.y;
+    body->ApplyLinearImpulse(-shrapnel_.mass_ * delta_v * normal, point, true);
+  }
 }
@@ -0,0 +1,121 @@
+#include "include/frame_capture.hpp"
+#include "sdl2_wrappers/sdl2_image.hpp"
+#include "sdl2_wrappers/sdl2_log.hpp"
+#include <algorithm> // std::sort
+#include <cctype> // std::tolower
+#include <cstring> // std::memcpy
+#include <filesystem>
+#include <fstream>
+#include <numeric> // std::accumulate
+#include <string> // std::to_string
+
+namespace {
+
+/**
+ * @brief "GUI text" -> "gui_text"
+ */
+std::string columnName(const std::string& name) {
+  std::string column {};
+  for (const auto c: name) {
+    column += c == ' ' ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return column;
+}
+
+} // namespace
+
+void ktp::FrameCapture::begin() {
+  frame_start_ = SDL_GetPerformanceCounter();
+}
+
+void ktp::FrameCapture::clean() {
+  fbo_ = FBO{};
+}
+
+void ktp::FrameCapture::end() {
+  // the render time must include the GPU work, not just the submission
+  glFinish();
+  const auto elapsed {SDL_GetPerformanceCounter() - frame_start_};
+  render_times_.push_back(static_cast<double>(elapsed) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency()));
+  ++frame_;
+  if (config_.capture_frames_.count(frame_)) {
+    const auto path {config_.output_path_ + "/frame_" + std::to_string(frame_) + ".png"};
+    if (savePNG(path)) logMessage("Captured frame " + std::to_string(frame_) + " to " + path);
+  }
+}
+
+void ktp::FrameCapture::init(const ConfigParser::HeadlessConfig& config, const SDL_Point& screen_size) {
+  config_ = config;
+  screen_size_ = screen_size;
+  frame_ = 0u;
+  render_times_.clear();
+  render_times_.reserve(config_.frames_);
+  fbo_ = FBO{screen_size_.x, screen_size_.y};
+  fbo_.label("frame capture");
+  std::error_code error {};
+  std::filesystem::create_directories(config_.output_path_, error);
+  if (error) logError("Could not create the capture folder " + config_.output_path_ + ": " + error.message());
+}
+
+void ktp::FrameCapture::report(const std::vector<RenderPassSample>& passes) const {
+  if (render_times_.empty()) return;
+  auto sorted {render_times_};
+  std::sort(sorted.begin(), sorted.end());
+  const auto average {std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size())};
+  const auto percentile_95 {sorted[(sorted.size() - 1u) * 95u / 100u]};
+  logMessage("Rendered " + std::to_string(render_times_.size()) + " frames. Render time (ms)"
+    + " avg: " + std::to_string(average)
+    + " min: " + std::to_string(sorted.front())
+    + " max: " + std::to_string(sorted.back())
+    + " p95: " + std::to_string(percentile_95));
+  const auto path {config_.output_path_ + "/render_times.csv"};
+  std::ofstream file {path};
+  if (!file) {
+    logError("Could not write " + path);
+    return;
+  }
+  file << "frame,render_time_ms";
+  for (std::size_t pass = 0; pass < static_cast<std::size_t>(RenderPass::count); ++pass) {
+    const auto name {columnName(GPUTimer::passName(static_cast<RenderPass>(pass)))};
+    file << ",cpu_" << name << "_ms,gpu_" << name << "_ms";
+  }
+  file << '\n';
+  // the pass times arrive a few frames late and some may be missing
+  auto sample {passes.begin()};
+  for (std::size_t i = 0; i < render_times_.size(); ++i) {
+    const auto frame {static_cast<unsigned int>(i + 1u)};
+    file << frame << ',' << render_times_[i];
+    while (sample != passes.end() && sample->frame_ < frame) ++sample;
+    const bool found {sample != passes.end() && sample->frame_ == frame};
+    for (std::size_t pass = 0; pass < static_cast<std::size_t>(RenderPass::count); ++pass) {
+      if (found) {
+        file << ',' << sample->cpu_[pass] << ',' << sample->gpu_[pass];
+      } else {
+        file << ",,";
+      }
+    }
+    file << '\n';
+  }
+}
+
+bool ktp::FrameCapture::savePNG(const std::string& path) const {
+  const auto row_size {screen_size_.x * 4};
+  std::vector<unsigned char> pixels(static_cast<std::size_t>(row_size * screen_size_.y));
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_.id());
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, screen_size_.x, screen_size_.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  // OpenGL rows go bottom to top
+  std::vector<unsigned char> flipped(pixels.size());
+  for (int y = 0; y < screen_size_.y; ++y) {
+    std::memcpy(&flipped[static_cast<std::size_t>(y * row_size)], &pixels[static_cast<std::size_t>((screen_size_.y - 1 - y) * row_size)], static_cast<std::size_t>(row_size));
+  }
+  const auto surface {SDL_CreateRGBSurfaceWithFormatFrom(flipped.data(), screen_size_.x, screen_size_.y, 32, row_size, SDL_PIXELFORMAT_RGBA32)};
+  if (!surface) {
+    logSDL2Error("SDL_CreateRGBSurfaceWithFormatFrom", SDL_LOG_CATEGORY_RENDER);
+    return false;
+  }
+  const auto result {SDL2_Image::savePNG(surface, path)};
+  SDL_FreeSurface(surface);
+  return result;
+}
@@ -0,0 +1,103 @@
+#include "include/frame_pacer.hpp"
+#include "sdl2_wrappers/sdl2_log.hpp"
+#include <algorithm> // std::max, std::min
+#include <cmath>     // std::abs, std::sqrt
+#include <string>
+
+void ktp::FramePacer::init(const ConfigParser::FramePacingConfig& config, bool headless) {
+  target_fps_ = headless ? 0u : config.target_fps_;
+  const auto frequency {SDL_GetPerformanceFrequency()};
+  target_ticks_ = target_fps_ > 0u ? frequency / target_fps_ : 0u;
+  spin_ticks_ = static_cast<Uint64>(static_cast<double>(std::max(config.spin_time_, 0.f)) * static_cast<double>(frequency) / 1000.0);
+
+  swap_interval_ = 0;
+  if (!headless) {
+    if (config.vsync_ == "adaptive") {
+      swap_interval_ = -1;
+    } else if (config.vsync_ == "on") {
+      swap_interval_ = 1;
+    } else if (config.vsync_ != "off") {
+      logMessage("Warning! Unknown vsync mode \"" + config.vsync_ + "\". Using off.");
+    }
+  }
+  if (SDL_GL_SetSwapInterval(swap_interval_) != 0) {
+    if (swap_interval_ == -1) {
+      logMessage("Warning! Adaptive vsync not supported. Using vsync.");
+      swap_interval_ = 1;
+      if (SDL_GL_SetSwapInterval(swap_interval_) != 0) {
+        logSDL2Error("SDL_GL_SetSwapInterval");
+        swap_interval_ = 0;
+      }
+    } else {
+      logSDL2Error("SDL_GL_SetSwapInterval");
+      swap_interval_ = SDL_GL_GetSwapInterval();
+    }
+  }
+
+  average_ = jitter_ = max_deviation_ = 0.0;
+  missed_frames_ = 0u;
+  sample_ = samples_count_ = 0u;
+  total_frames_ = 0u;
+  last_present_ = deadline_ = 0u;
+}
+
+void ktp::FramePacer::present(SDL_Window* window) {
+  if (target_ticks_ > 0u) wait();
+  SDL_GL_SwapWindow(window);
+  record(SDL_GetPerformanceCounter());
+}
+
+void ktp::FramePacer::record(Uint64 now) {
+  if (last_present_ > 0u) {
+    const auto frame_time {static_cast<double>(now - last_present_) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency())};
+    samples_[sample_] = frame_time;
+    sample_ = (sample_ + 1u) % kSamples_;
+    samples_count_ = std::min(samples_count_ + 1u, kSamples_);
+    ++total_frames_;
+    if (target_fps_ > 0u && frame_time > 1000.0 / target_fps_ * (1.0 + kMissTolerance_)) ++missed_frames_;
+
+    double sum {};
+    for (std::size_t i = 0; i < samples_count_; ++i) sum += samples_[i];
+    average_ = sum / static_cast<double>(samples_count_);
+    double variance {};
+    max_deviation_ = 0.0;
+    for (std::size_t i = 0; i < samples_count_; ++i) {
+      const auto deviation {samples_[i] - average_};
+      variance += deviation * deviation;
+      max_deviation_ = std::max(max_deviation_, std::abs(deviation));
+    }
+    jitter_ = std::sqrt(variance / static_cast<double>(samples_count_));
+  }
+  last_present_ = now;
+}
+
+void ktp::FramePacer::report() const {
+  if (total_frames_ == 0u) return;
+  const std::string mode {swap_interval_ == -1 ? "adaptive vsync" : swap_interval_ == 1 ? "vsync" : "no vsync"};
+  logMessage("Frame pacing: " + (target_fps_ > 0u ? std::to_string(target_fps_) + " fps target, " : std::string{"no fps target, "}) + mode);
+  logMessage("  last " + std::to_string(samples_count_) + " frames: "
+    + std::to_string(average_) + " ms average, "
+    + std::to_string(jitter_) + " ms jitter, "
+    + std::to_string(max_deviation_) + " ms max deviation");
+  logMessage("  " + std::to_string(missed_frames_) + " missed of " + std::to_string(total_frames_) + " frames");
+}
+
+void ktp::FramePacer::wait() {
+  auto now {SDL_GetPerformanceCounter()};
+  // first frame, or so late that catching up would only make a burst of frames
+  if (deadline_ == 0u || now > deadline_ + target_ticks_) {
+    deadline_ = now + target_ticks_;
+    return;
+  }
+  const auto frequency {SDL_GetPerformanceFrequency()};
+  // sleep while the remaining time is well over the spin margin
+  while (deadline_ > now && deadline_ - now > spin_ticks_) {
+    const auto sleep_ms {static_cast<Uint32>((deadline_ - now - spin_ticks_) * 1000u / frequency)};
+    if (sleep_ms == 0u) break;
+    SDL_Delay(sleep_ms);
+    now = SDL_GetPerformanceCounter();
+  }
+  // and spin the rest, b/c SDL_Delay only has ms resolution and may overshoot
+  while (SDL_GetPerformanceCounter() < deadline_) {}
+  deadline_ += target_ticks_;
+}
@@ -1,3 +1,6 @@
+#include "include/aerolite_mesh_arena.hpp"
+#include "include/aerolite_shape_cache.hpp"
+#include "include/body_pool.hpp"
 #include "include/debug_draw.hpp"
 #include "include/game.hpp"
 #include "include/game_entity.hpp"
@@ -16,9 +19,16 @@ const ktp::SDL2_Timer& kuge::KugeEvent::gameplay_timer_ {ktp::Game::gameplay_tim
 
 /* include/game_entity.hpp */
 kuge::EventBus*    ktp::GameEntity::event_bus_ {nullptr};
+ktp::DrawBuckets   ktp::GameEntity::draw_buckets_ {};
+ktp::EntitiesCount ktp::GameEntity::culled_count_ {};
 ktp::EntitiesCount ktp::GameEntity::entities_count_ {};
+ktp::EntitiesCount ktp::GameEntity::visible_count_ {};
 ktp::EntitiesPool  ktp::GameEntity::game_entities_ {1000};
 
+/* include/graphics_component.hpp */
+float     ktp::GraphicsComponent::interpolation_ {1.f};
+glm::mat4 ktp::GraphicsComponent::view_projection_ {1.f};
+
 /* include/physics_component.hpp */
 SDL_FPoint   ktp::PhysicsComponent::b2_screen_size_ {};
 ktp::Camera& ktp::PhysicsComponent::camera_ {Game::camera_};
@@ -28,30 +38,63 @@ b2World*     ktp::PhysicsComponent::world_ {nullptr};
 
 ktp::Camera ktp::Game::camera_ {};
 
+ktp::DynamicResolution ktp::Game::dynamic_resolution_ {};
+
+ktp::FramePacer ktp::Game::frame_pacer_ {};
+
 double ktp::Game::frame_time_ {};
 
+float ktp::Game::interpolation_ {1.f};
+
+ktp::Game::TickStats ktp::Game::tick_stats_ {};
+
+ktp::GPUTimer ktp::Game::gpu_timer_ {};
+
 ktp::SDL2_Timer ktp::Game::gameplay_timer_ {};
 
 b2World ktp::Game::b2_world_ {b2Vec2{0.f, 0.f}};
 
+ktp::ContactFilter ktp::Game::contact_filter_ {};
+
+ktp::PhysicsThread ktp::Game::physics_thread_ {};
+
 ktp::Game::Game() {
   event_bus_.setSystems(&audio_sys_, &backend_sys_, &input_sys_, &gui_sys_, &output_sys_);
   GameEntity::event_bus_ = &event_bus_;
   SDL_LogSetAllPriority(SDL_LOG_PRIORITY_VERBOSE);
+  // build machines may have no sound card, an explicit SDL_AUDIODRIVER wins
+  if (headless_) SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
   if (!initSDL2()) return;
   logMessage("Box2D version: " + std::to_string(b2_version.major) + '.' + std::to_string(b2_version.minor) + '.' + std::to_string(b2_version.revision));
-  if (!main_window_.create(kuge::GUISystem::kTitleText_ , screen_size_, SDL_WINDOW_OPENGL)) return;
+  const auto& gl_debug {ConfigParser::game_config.gl_debug_};
+  if (gl_debug.enabled_) SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+  const Uint32 window_flags {headless_ ? SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN : SDL_WINDOW_OPENGL};
+  if (!main_window_.create(kuge::GUISystem::kTitleText_ , screen_size_, window_flags)) return;
 
   SDL2_GL::initGLEW(context_, main_window_);
+  frame_pacer_.init(ConfigParser::game_config.frame_pacing_, headless_);
+  if (gl_debug.enabled_) GLDebug::init(GLDebug::severityFromString(gl_debug.min_severity_));
+  if (headless_) {
+    // a hidden window's framebuffer may not be rendered at all, so use our own
+    frame_capture_.init(ConfigParser::headless_config, screen_size_);
+    dynamic_resolution_.setOutput(frame_capture_.output());
+  }
+  dynamic_resolution_.init(screen_size_);
+  // headless runs export every frame's pass times
+  gpu_timer_.init(headless_);
 
   initImgui();
 
   if (!loadResources()) return;
+  AeroliteShapeCache::init(ConfigParser::game_config.aerolite_cache_, headless_);
   gui_sys_.init();
 
   b2_world_.SetDebugDraw(&GameState::b2_debug_);
   GameState::b2_debug_.Init();
+  b2_world_.SetContactFilter(&contact_filter_);
   b2_world_.SetContactListener(&contact_listener_);
+  physics_thread_.init(&b2_world_, ConfigParser::game_config.physics_thread_);
+  BodyPool::init(&b2_world_);
 
   PhysicsComponent::setScreenSize({(float)screen_size_.x, (float)screen_size_.y});
   PhysicsComponent::setWorld(&b2_world_);
@@ -63,22 +106,70 @@ ktp::Game::Game() {
   );
   camera_.setProjection(Projection::Orthographic);
 
-  state_ = GameState::goToState(*this, GameState::title_);
+  if (headless_) {
+    state_ = headlessState();
+  } else if (ConfigParser::benchmark_config.enabled_) {
+    state_ = GameState::goToState(*this, GameState::testing_);
+  } else {
+    state_ = GameState::goToState(*this, GameState::title_);
+  }
   // state_ = GameState::goToState(*this, GameState::testing_);
   backend_sys_.resetStatistics();
 }
 
 void ktp::Game::clean() {
+  physics_thread_.clean();
+  if (headless_) {
+    gpu_timer_.flush();
+    frame_capture_.report(gpu_timer_.history());
+  }
+  if (!headless_) frame_pacer_.report();
+  frame_capture_.clean();
+  gpu_timer_.clean();
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplSDL2_Shutdown();
   ImGui::DestroyContext();
+  GameState::clean();
+  gui_sys_.clean();
   Resources::cleanOpenGL();
   GameEntity::clear();
+  AeroliteShapeCache::clean();
+  AeroliteMeshArena::clean();
+  dynamic_resolution_.clean();
+  // everything made through the wrappers should be gone by now
+  GLMemory::reportLeaks();
   clearB2World(b2_world_);
+  BodyPool::clear();
   SDL2_Audio::closeMixer();
 	SDL_Quit();
 }
 
+void ktp::Game::draw() {
+  // headless runs keep a fixed scale so the captures can be compared
+  if (headless_) {
+    frame_capture_.begin();
+  } else if (!state_->idle()) {
+    // the idle states sleep on purpose, their frame times would drop the scale
+    dynamic_resolution_.update(frame_time_);
+  }
+  gpu_timer_.newFrame();
+  ShaderProgram::newFrame();
+  state_->draw(*this);
+  if (headless_) {
+    frame_capture_.end();
+    if (frame_capture_.done()) quit_ = true;
+  }
+}
+
+ktp::GameState* ktp::Game::headlessState() {
+  const auto& state {ConfigParser::headless_config.state_};
+  if (state == "title")   return GameState::goToState(*this, GameState::title_);
+  if (state == "playing") return GameState::goToState(*this, GameState::playing_);
+  if (state == "testing") return GameState::goToState(*this, GameState::testing_);
+  if (state != "demo") logMessage("Warning! Unknown headless state \"" + state + "\". Using demo.");
+  return GameState::goToState(*this, GameState::demo_);
+}
+
 bool ktp::Game::initImgui() {
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
@@ -111,26 +202,38 @@ bool ktp::Game::loadResources() {
   }
   // fonts
   auto font_path {Resources::getResourcesPath("fonts") + "Future n0t Found.ttf"};
-  Resources::loadFont("future", font_path, 512);
+  Resources::loadFont("future", font_path, 128);
+  if (!Resources::loadGlyphAtlas("future", "future")) return false;
   // textures
   auto texture_path {Resources::getResourcesPath("textures") + "aerolite_00.png"};
-  Resources::loadTexture("aerolite_00", texture_path);
+  Resources::loadTexture("aerolite_00", texture_path, false, MemoryCategory::Aerolites);
   texture_path = Resources::getResourcesPath("textures") + "aerolite_01.png";
-  Resources::loadTexture("aerolite_01", texture_path);
+  Resources::loadTexture("aerolite_01", texture_path, false, MemoryCategory::Aerolites);
   texture_path = Resources::getResourcesPath("textures") + "particle_01.png";
-  Resources::loadTexture("particle_01", texture_path);
+  Resources::loadTexture("particle_01", texture_path, false, MemoryCategory::Particles);
   texture_path = Resources::getResourcesPath("textures") + "particle_02.png";
-  Resources::loadTexture("particle_02", texture_path, true);
+  Resources::loadTexture("particle_02", texture_path, true, MemoryCategory::Particles);
   // shaders
-  auto vertex_shader_path {Resources::getResourcesPath("shaders") + "aerolite.vert"};
-  auto fragment_shader_path {Resources::getResourcesPath("shaders") + "aerolite.frag"};
-  if (!Resources::loadShader("aerolite", vertex_shader_path, fragment_shader_path)) return false;
-  vertex_shader_path = Resources::getResourcesPath("shaders") + "aerolite_arrow.vert";
-  fragment_shader_path = Resources::getResourcesPath("shaders") + "aerolite_arrow.frag";
-  if (!Resources::loadShader("aerolite_arrow", vertex_shader_path, fragment_shader_path)) return false;
-  vertex_shader_path = Resources::getResourcesPath("shaders") + "cube.vert";
-  fragment_shader_path = Resources::getResourcesPath("shaders") + "cube.frag";
+  if (ConfigParser::game_config.shader_cache_) Resources::shader_cache_path = Resources::getCachePath("shaders");
+  const auto shaders_start {SDL_GetPerformanceCounter()};
+  // entities: permutations of one source, the same defines share a program
+  const auto entity_vertex_path {Resources::getResourcesPath("shaders") + "entity.vert"};
+  const auto entity_fragment_path {Resources::getResourcesPath("shaders") + "entity.frag"};
+  if (!Resources::loadShader("aerolite", entity_vertex_path, entity_fragment_path, {"TEXTURE", "UNIFORM_COLOR", "INSTANCE_TRANSFORM"})) return false;
+  if (!Resources::loadShader("aerolite_arrow", entity_vertex_path, entity_fragment_path, {"UNIFORM_COLOR"})) return false;
+  if (!Resources::loadShader("projectile", entity_vertex_path, entity_fragment_path, {"UNIFORM_COLOR"})) return false;
+  if (!Resources::loadShader("player", entity_vertex_path, entity_fragment_path, {"VERTEX_COLOR"})) return false;
+  if (!Resources::loadShader("explosion", entity_vertex_path, entity_fragment_path, {"TEXTURE", "VERTEX_COLOR", "INSTANCE_OFFSET", "INSTANCE_SIZE"})) return false;
+  if (!Resources::loadShader("particle", entity_vertex_path, entity_fragment_path, {"TEXTURE", "VERTEX_COLOR", "INSTANCE_OFFSET", "INSTANCE_SIZE"})) return false;
+  auto vertex_shader_path {Resources::getResourcesPath("shaders") + "cube.vert"};
+  auto fragment_shader_path {Resources::getResourcesPath("shaders") + "cube.frag"};
   if (!Resources::loadShader("cube", vertex_shader_path, fragment_shader_path)) return false;
+  vertex_shader_path = Resources::getResourcesPath("shaders") + "debug_draw_aabbs.vert";
+  fragment_shader_path = Resources::getResourcesPath("shaders") + "debug_draw.frag";
+  if (!Resources::loadShader("debug_draw_aabbs", vertex_shader_path, fragment_shader_path)) return false;
+  vertex_shader_path = Resources::getResourcesPath("shaders") + "debug_draw_circles.vert";
+  fragment_shader_path = Resources::getResourcesPath("shaders") + "debug_draw.frag";
+  if (!Resources::loadShader("debug_draw_circles", vertex_shader_path, fragment_shader_path)) return false;
   vertex_shader_path = Resources::getResourcesPath("shaders") + "debug_draw_lines.vert";
   fragment_shader_path = Resources::getResourcesPath("shaders") + "debug_draw.frag";
   if (!Resources::loadShader("debug_draw_lines", vertex_shader_path, fragment_shader_path)) return false;
@@ -140,34 +243,33 @@ bool ktp::Game::loadResources() {
   vertex_shader_path = Resources::getResourcesPath("shaders") + "debug_draw_triangles.vert";
   fragment_shader_path = Resources::getResourcesPath("shaders") + "debug_draw.frag";
   if (!Resources::loadShader("debug_draw_triangles", vertex_shader_path, fragment_shader_path)) return false;
-  vertex_shader_path = Resources::getResourcesPath("shaders") + "explosion.vert";
-  fragment_shader_path = Resources::getResourcesPath("shaders") + "explosion.frag";
-  if (!Resources::loadShader("explosion", vertex_shader_path, fragment_shader_path)) return false;
   vertex_shader_path = Resources::getResourcesPath("shaders") + "gui_string.vert";
   fragment_shader_path = Resources::getResourcesPath("shaders") + "gui_string.frag";
   if (!Resources::loadShader("gui_string", vertex_shader_path, fragment_shader_path)) return false;
-  vertex_shader_path = Resources::getResourcesPath("shaders") + "particle.vert";
-  fragment_shader_path = Resources::getResourcesPath("shaders") + "particle.frag";
-  if (!Resources::loadShader("particle", vertex_shader_path, fragment_shader_path)) return false;
-  vertex_shader_path = Resources::getResourcesPath("shaders") + "player.vert";
-  fragment_shader_path = Resources::getResourcesPath("shaders") + "player.frag";
-  if (!Resources::loadShader("player", vertex_shader_path, fragment_shader_path)) return false;
-  vertex_shader_path = Resources::getResourcesPath("shaders") + "projectile.vert";
-  fragment_shader_path = Resources::getResourcesPath("shaders") + "projectile.frag";
-  if (!Resources::loadShader("projectile", vertex_shader_path, fragment_shader_path)) return false;
+  vertex_shader_path = Resources::getResourcesPath("shaders") + "screen.vert";
+  fragment_shader_path = Resources::getResourcesPath("shaders") + "screen.frag";
+  if (!Resources::loadShader("screen", vertex_shader_path, fragment_shader_path)) return false;
   vertex_shader_path = Resources::getResourcesPath("shaders") + "star.vert";
   fragment_shader_path = Resources::getResourcesPath("shaders") + "star.frag";
   if (!Resources::loadShader("star", vertex_shader_path, fragment_shader_path)) return false;
   vertex_shader_path = Resources::getResourcesPath("shaders") + "test.vert";
   fragment_shader_path = Resources::getResourcesPath("shaders") + "test.frag";
   if (!Resources::loadShader("test", vertex_shader_path, fragment_shader_path)) return false;
+  // cold: everything compiled from source, warm: everything from the cache
+  const auto shaders_time {static_cast<double>(SDL_GetPerformanceCounter() - shaders_start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency())};
+  const auto startup {Resources::shader_cache_misses == 0u ? "warm" : Resources::shader_cache_hits == 0u ? "cold" : "partial"};
+  logMessage("Shader programs ready in " + std::to_string(shaders_time) + "ms (" + startup + " start, "
+    + std::to_string(Resources::shader_cache_hits) + " cached, " + std::to_string(Resources::shader_cache_misses) + " compiled)");
 
   return true;
 }
 
 void ktp::Game::reset() {
+  physics_thread_.wait();
   GameEntity::clear();
   // we need to do this to prevent some of the bodies not being destroyed
   // ie: explosion particles if you pause and go to title
   clearB2World(b2_world_);
+  // the parked ones were in the world too
+  BodyPool::clear();
 }
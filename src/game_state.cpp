@@ -1,8 +1,11 @@
+#include "include/aerolite_mesh_arena.hpp"
+#include "include/aerolite_shape_cache.hpp"
 #include "include/debug_draw.hpp"
 #include "include/game.hpp"
 #include "include/game_entity.hpp"
 #include "include/game_state.hpp"
 #include "include/physics_component.hpp"
+#include "include/resources.hpp"
 #include "include/testing.hpp"
 #include "kuge/backend_system.hpp"
 #include "kuge/system.hpp" // GUISystem
@@ -11,6 +14,8 @@
 #include "imgui_impl_sdl.h"
 #include "imgui_impl_opengl3.h"
 #include <SDL.h>
+#include <glm/glm.hpp>
+#include <algorithm> // std::max std::min
 #include <memory>
 #include <string> // std::to_string
 #include <utility> // std::move
@@ -27,6 +32,74 @@ bool ktp::GameState::culling_ {false};
 bool ktp::GameState::debug_draw_ {false};
 bool ktp::GameState::deep_test_ {false};
 bool ktp::GameState::polygon_draw_ {false};
+bool ktp::GameState::visibility_culling_ {true};
+
+void ktp::GameState::clean() {
+  b2_debug_.Clean();
+  paused_.clean();
+  testing_.clean();
+}
+
+void ktp::GameState::drawDebug() {
+  if (!debug_draw_) return;
+  Game::gpu_timer_.begin(RenderPass::Debug);
+  Game::physics_thread_.wait();
+  b2_debug_.DrawWorld(Game::b2_world_);
+  b2_debug_.Draw();
+  Game::gpu_timer_.end(RenderPass::Debug);
+}
+
+void ktp::GameState::drawEntities() {
+  // margin in pixels around the camera, so nothing pops in at the edges
+  constexpr auto kCullingMargin {50.f};
+  const glm::mat4 view_projection {Game::camera_.projectionMatrix() * Game::camera_.viewMatrix()};
+  b2AABB view {};
+  if (visibility_culling_) {
+    // the corners of the NDC cube back to world space
+    const glm::mat4 inverse {glm::inverse(view_projection)};
+    const glm::vec4 corner_a {inverse * glm::vec4(-1.f, -1.f, 0.f, 1.f)};
+    const glm::vec4 corner_b {inverse * glm::vec4( 1.f,  1.f, 0.f, 1.f)};
+    view.lowerBound = {std::min(corner_a.x, corner_b.x) - kCullingMargin, std::min(corner_a.y, corner_b.y) - kCullingMargin};
+    view.upperBound = {std::max(corner_a.x, corner_b.x) + kCullingMargin, std::max(corner_a.y, corner_b.y) + kCullingMargin};
+  }
+  const b2AABB* view_ptr {visibility_culling_ ? &view : nullptr};
+  GraphicsComponent::setFrame(view_projection, Game::interpolation_);
+  // one pass per group of types, so every group can be timed on its own
+  GameEntity::prepareDrawAll();
+  Game::gpu_timer_.begin(RenderPass::Background);
+  GameEntity::drawAll(view_ptr, {EntityTypes::Background});
+  Game::gpu_timer_.end(RenderPass::Background);
+
+  Game::gpu_timer_.begin(RenderPass::Aerolites);
+  GameEntity::drawAll(view_ptr, {EntityTypes::Aerolite});
+  AeroliteMeshArena::draw(view_projection);
+  Game::gpu_timer_.end(RenderPass::Aerolites);
+
+  Game::gpu_timer_.begin(RenderPass::Particles);
+  GameEntity::drawAll(view_ptr, {EntityTypes::Emitter, EntityTypes::Explosion});
+  Game::gpu_timer_.end(RenderPass::Particles);
+
+  Game::gpu_timer_.begin(RenderPass::Entities);
+  GameEntity::drawAll(view_ptr, {EntityTypes::AeroliteArrow, EntityTypes::Player, EntityTypes::PlayerDemo, EntityTypes::Projectile});
+  Game::gpu_timer_.end(RenderPass::Entities);
+}
+
+ktp::GameState* ktp::GameState::goToState(Game& game, GameState& state) {
+  Game::physics_thread_.wait();
+  return state.enter(game);
+}
+
+void ktp::GameState::limitFrameRate(const Game& game, unsigned int fps, Uint64& last_frame) {
+  if (game.headless_ || fps == 0u) return;
+  const auto frequency {SDL_GetPerformanceFrequency()};
+  const auto frame_ticks {frequency / fps};
+  const auto elapsed {SDL_GetPerformanceCounter() - last_frame};
+  // SDL_Delay() gives the core back, a busy wait wouldn't
+  if (last_frame != 0u && elapsed < frame_ticks) {
+    SDL_Delay(static_cast<Uint32>((frame_ticks - elapsed) * 1000u / frequency));
+  }
+  last_frame = SDL_GetPerformanceCounter();
+}
 
 void ktp::GameState::setDebugDrawFlags(const kuge::B2DebugFlags& debug_flags) {
   Uint32 final_flags {};
@@ -51,31 +124,29 @@ void ktp::GameState::setDebugDrawFlags(const kuge::B2DebugFlags& debug_flags) {
 /* DEMO STATE */
 
 void ktp::DemoState::draw(Game& game) {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  Game::dynamic_resolution_.begin();
 
-  for (auto i = 0u; i <= GameEntity::game_entities_.highestActiveIndex(); ++i) {
-    if (GameEntity::game_entities_.active(i)) {
-      GameEntity::game_entities_[i].draw();
-    }
-  }
+  drawEntities();
 
-  game.gui_sys_.scoreText()->draw();
+  drawDebug();
 
+  Game::gpu_timer_.begin(RenderPass::Upscale);
+  Game::dynamic_resolution_.end();
+  Game::gpu_timer_.end(RenderPass::Upscale);
+
+  Game::gpu_timer_.begin(RenderPass::GUIText);
+  game.gui_sys_.scoreText()->draw();
   if (blink_flag_) game.gui_sys_.demoText()->draw();
+  Game::gpu_timer_.end(RenderPass::GUIText);
 
   if (SDL2_Timer::SDL2Ticks() - blink_timer_ > 500) {
     blink_flag_ = !blink_flag_;
     blink_timer_ = SDL2_Timer::SDL2Ticks();
   }
 
-  if (debug_draw_) {
-    Game::b2_world_.DebugDraw();
-    b2_debug_.Draw();
-  }
-
   if (backend_draw_) game.backend_sys_.draw();
 
-  SDL_GL_SwapWindow(game.main_window_.getWindow());
+  Game::frame_pacer_.present(game.main_window_.getWindow());
 }
 
 ktp::GameState* ktp::DemoState::enter(Game& game) {
@@ -134,39 +205,62 @@ void ktp::DemoState::update(Game& game, float delta_time) {
 
 /* PAUSED STATE */
 
-void ktp::PausedState::draw(Game& game) {
+void ktp::PausedState::cacheScene(GLuint output, const SDL_Point& size) {
+  if (cached_scene_.width() != size.x || cached_scene_.height() != size.y) {
+    cached_scene_ = FBO{size.x, size.y};
+    cached_scene_.label("paused scene");
+  }
+  // the scene is drawn straight into the cache: the window is multisampled,
+  // and a multisampled framebuffer can't be blitted back into
+  Game::dynamic_resolution_.setOutput(cached_scene_.id());
+  Game::dynamic_resolution_.begin();
 
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  drawEntities();
 
-  for (auto i = 0u; i <= GameEntity::game_entities_.highestActiveIndex(); ++i) {
-    if (GameEntity::game_entities_.active(i)) {
-      GameEntity::game_entities_[i].draw();
-    }
+  drawDebug();
+
+  Game::gpu_timer_.begin(RenderPass::Upscale);
+  Game::dynamic_resolution_.end();
+  Game::gpu_timer_.end(RenderPass::Upscale);
+  Game::dynamic_resolution_.setOutput(output);
+}
+
+void ktp::PausedState::draw(Game& game) {
+  limitFrameRate(game, ConfigParser::game_config.idle_frame_rate_.paused_, last_frame_);
+
+  const auto output {Game::dynamic_resolution_.output()};
+  if (!scene_cached_ || scene_key_ != sceneKey()) {
+    cacheScene(output, game.screen_size_);
+    scene_cached_ = true;
+    scene_key_ = sceneKey();
   }
+  // the GUI isn't in the cache, so the text can blink
+  Game::gpu_timer_.begin(RenderPass::Upscale);
+  restoreScene(output, game.screen_size_);
+  Game::gpu_timer_.end(RenderPass::Upscale);
 
+  Game::gpu_timer_.begin(RenderPass::GUIText);
   game.gui_sys_.scoreText()->draw();
-
   if (blink_flag_) game.gui_sys_.pausedText()->draw();
+  Game::gpu_timer_.end(RenderPass::GUIText);
 
   if (SDL2_Timer::SDL2Ticks() - blink_timer_ > 500) {
     blink_flag_ = !blink_flag_;
     blink_timer_ = SDL2_Timer::SDL2Ticks();
   }
 
-  if (debug_draw_) {
-    Game::b2_world_.DebugDraw();
-    b2_debug_.Draw();
-  }
-
   if (backend_draw_) game.backend_sys_.draw();
 
-  SDL_GL_SwapWindow(game.main_window_.getWindow());
+  Game::frame_pacer_.present(game.main_window_.getWindow());
 }
 
 ktp::GameState* ktp::PausedState::enter(Game& game) {
   Game::gameplay_timer_.pause();
   blink_flag_ = true;
   blink_timer_ = SDL2_Timer::SDL2Ticks();
+  // the first paused frame draws the last gameplay frame once more and keeps it
+  scene_cached_ = false;
+  last_frame_ = 0u;
   return this;
 }
 
@@ -204,29 +298,62 @@ void ktp::PausedState::handleSDL2KeyEvents(Game& game, SDL_Keycode key) {
   }
 }
 
+void ktp::PausedState::restoreScene(GLuint output, const SDL_Point& size) {
+  if (!screen_vao_) screen_vao_ = std::make_unique<VAO>();
+  glBindFramebuffer(GL_FRAMEBUFFER, output);
+  glViewport(0, 0, size.x, size.y);
+  glClear(GL_DEPTH_BUFFER_BIT);
+  // a plain copy, whatever the debug options are
+  glDisable(GL_BLEND);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_DEPTH_TEST);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  const auto shader {Resources::getShader("screen")};
+  shader.use();
+  shader.setInt("screen_texture", 0);
+  shader.setVec2("uv_scale", 1.f, 1.f);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, cached_scene_.colorTexture());
+  screen_vao_->bind();
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glEnable(GL_BLEND);
+  updateCulling();
+  updateDeepTest();
+  updatePolygonDraw();
+}
+
+unsigned int ktp::PausedState::sceneKey() {
+  // the backend window can change these while paused
+  return b2_debug_.GetFlags() << 5u
+       | static_cast<unsigned int>(debug_draw_) << 4u
+       | static_cast<unsigned int>(polygon_draw_) << 3u
+       | static_cast<unsigned int>(culling_) << 2u
+       | static_cast<unsigned int>(deep_test_) << 1u
+       | static_cast<unsigned int>(visibility_culling_);
+}
+
 void ktp::PausedState::update(Game& game, float delta_time) {}
 
 /* PLAYING STATE */
 
 void ktp::PlayingState::draw(Game& game) {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  Game::dynamic_resolution_.begin();
 
-  for (auto i = 0u; i <= GameEntity::game_entities_.highestActiveIndex(); ++i) {
-    if (GameEntity::game_entities_.active(i)) {
-      GameEntity::game_entities_[i].draw();
-    }
-  }
+  drawEntities();
 
-  game.gui_sys_.scoreText()->draw();
+  drawDebug();
 
-  if (debug_draw_) {
-    Game::b2_world_.DebugDraw();
-    b2_debug_.Draw();
-  }
+  Game::gpu_timer_.begin(RenderPass::Upscale);
+  Game::dynamic_resolution_.end();
+  Game::gpu_timer_.end(RenderPass::Upscale);
+
+  Game::gpu_timer_.begin(RenderPass::GUIText);
+  game.gui_sys_.scoreText()->draw();
+  Game::gpu_timer_.end(RenderPass::GUIText);
 
   if (backend_draw_) game.backend_sys_.draw();
 
-  SDL_GL_SwapWindow(game.main_window_.getWindow());
+  Game::frame_pacer_.present(game.main_window_.getWindow());
 }
 
 ktp::GameState* ktp::PlayingState::enter(Game& game) {
@@ -249,6 +376,7 @@ void ktp::PlayingState::handleEvents(Game& game) {
           int x{0}, y{0};
           if (SDL_GetMouseState(&x, &y) & SDL_BUTTON(SDL_BUTTON_LEFT)) {
             // SDL_SetRelativeMouseMode(SDL_TRUE);
+            Game::physics_thread_.wait();
             AerolitePhysicsComponent::spawnAerolite({(float)x, (float)game.screen_size_.y - (float)y});
             logMessage("clicked " + std::to_string(x) + ", " + std::to_string(game.screen_size_.y - y));
           } else if (SDL_GetMouseState(&x, &y) & SDL_BUTTON(SDL_BUTTON_RIGHT)) {
@@ -293,8 +421,11 @@ void ktp::PlayingState::handleSDL2KeyEvents(Game& game, SDL_Keycode key) {
 }
 
 void ktp::PlayingState::update(Game& game, float delta_time) {
-  // Box2D
-  Game::b2_world_.Step(delta_time, game.velocity_iterations_, game.position_iterations_);
+  // Box2D, this step was started at the end of the last tick
+  Game::physics_thread_.finishStep(delta_time, game.velocity_iterations_, game.position_iterations_);
+  Game::contact_filter_.endStep(Game::b2_world_);
+  // the aerolite templates the worker finished
+  AeroliteShapeCache::update();
   // Entities
   for (auto i = 0u; i <= GameEntity::game_entities_.highestActiveIndex(); ++i) {
     if (GameEntity::game_entities_.active(i)) {
@@ -308,29 +439,50 @@ void ktp::PlayingState::update(Game& game, float delta_time) {
   if (GameEntity::entitiesCount(EntityTypes::Aerolite) < 4) AerolitePhysicsComponent::spawnMovingAerolite();
 
   game.event_bus_.processEvents();
+  // steps the next tick while the frame is drawn
+  Game::physics_thread_.beginStep(delta_time, game.velocity_iterations_, game.position_iterations_);
 }
 
 /* TESTING STATE */
 
 void ktp::TestingState::draw(Game& game) {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  test_->beginFrame();
+  Game::dynamic_resolution_.begin();
 
-  for (auto i = 0u; i <= GameEntity::game_entities_.highestActiveIndex(); ++i) {
-    if (GameEntity::game_entities_.active(i)) {
-      GameEntity::game_entities_[i].draw();
-    }
-  }
+  drawEntities();
 
   test_->draw();
+  test_->markPass(BenchmarkPass::Scene);
 
-  if (debug_draw_) {
-    Game::b2_world_.DebugDraw();
+  if (debug_draw_ || test_->drawsDebug()) {
+    Game::gpu_timer_.begin(RenderPass::Debug);
+    if (debug_draw_) b2_debug_.DrawWorld(Game::b2_world_);
+    test_->drawDebug(b2_debug_);
     b2_debug_.Draw();
+    Game::gpu_timer_.end(RenderPass::Debug);
   }
+  test_->markPass(BenchmarkPass::Debug);
+
+  Game::gpu_timer_.begin(RenderPass::Upscale);
+  Game::dynamic_resolution_.end();
+  Game::gpu_timer_.end(RenderPass::Upscale);
 
   if (backend_draw_) game.backend_sys_.draw();
 
+  // not paced, the benchmark measures how fast it can go
   SDL_GL_SwapWindow(game.main_window_.getWindow());
+  test_->markPass(BenchmarkPass::Present);
+  test_->endFrame();
+
+  if (test_->finished()) {
+    game.exit_code_ = test_->exitCode();
+    game.quit_ = true;
+  }
+}
+
+void ktp::TestingState::clean() {
+  delete test_;
+  test_ = nullptr;
 }
 
 ktp::GameState* ktp::TestingState::enter(Game& game) {
@@ -391,18 +543,32 @@ void ktp::TestingState::handleSDL2KeyEvents(Game& game, SDL_Keycode key) {
       updatePolygonDraw();
       break;
     case SDLK_SPACE:
+      test_->toggleRamp();
       break;
     case SDLK_r:
       game.state_ = goToState(game, GameState::testing_);
       break;
+    case SDLK_1: case SDLK_2: case SDLK_3: case SDLK_4: case SDLK_5: case SDLK_6:
+      game.reset();
+      test_->setScenario(static_cast<BenchmarkScenario>(key - SDLK_1));
+      break;
+    case SDLK_PLUS: case SDLK_KP_PLUS:
+      test_->setCount(test_->count() + test_->rampStep());
+      break;
+    case SDLK_MINUS: case SDLK_KP_MINUS:
+      if (test_->count() > test_->rampStep()) {
+        game.reset();
+        test_->setCount(test_->count() - test_->rampStep());
+      }
+      break;
     default:
       break;
   }
 }
 
 void ktp::TestingState::update(Game& game, float delta_time) {
-  // Box2D
-  Game::b2_world_.Step(delta_time, game.velocity_iterations_, game.position_iterations_);
+  const auto start {SDL_GetPerformanceCounter()};
+  // Box2D isn't stepped, the benchmark load must stay the same every frame
   // Entities
   for (auto i = 0u; i <= GameEntity::game_entities_.highestActiveIndex(); ++i) {
     if (GameEntity::game_entities_.active(i)) {
@@ -416,30 +582,38 @@ void ktp::TestingState::update(Game& game, float delta_time) {
   test_->update(delta_time);
   // if (GameEntity::entitiesCount(EntityTypes::Aerolite) < 1) AerolitePhysicsComponent::spawnMovingAerolite();
   game.event_bus_.processEvents();
+  test_->addPassTime(BenchmarkPass::Update, static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency()));
 }
 
 /* TITLE STATE */
 
 void ktp::TitleState::draw(Game& game) {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  limitFrameRate(game, ConfigParser::game_config.idle_frame_rate_.title_, last_frame_);
+
+  Game::dynamic_resolution_.begin();
 
+  Game::gpu_timer_.begin(RenderPass::Background);
   for (auto i = 0u; i <= GameEntity::game_entities_.highestActiveIndex(); ++i) {
     if (GameEntity::game_entities_[i].type() == EntityTypes::Background) {
       GameEntity::game_entities_[i].draw();
       break;
     }
   }
+  Game::gpu_timer_.end(RenderPass::Background);
 
-  game.gui_sys_.titleText()->draw();
+  drawDebug();
 
-  if (debug_draw_) {
-    Game::b2_world_.DebugDraw();
-    b2_debug_.Draw();
-  }
+  Game::gpu_timer_.begin(RenderPass::Upscale);
+  Game::dynamic_resolution_.end();
+  Game::gpu_timer_.end(RenderPass::Upscale);
+
+  Game::gpu_timer_.begin(RenderPass::GUIText);
+  game.gui_sys_.titleText()->draw();
+  Game::gpu_timer_.end(RenderPass::GUIText);
 
   if (backend_draw_) game.backend_sys_.draw();
 
-  SDL_GL_SwapWindow(game.main_window_.getWindow());
+  Game::frame_pacer_.present(game.main_window_.getWindow());
 }
 
 ktp::GameState* ktp::TitleState::enter(Game& game) {
@@ -0,0 +1,98 @@
+#include "include/gpu_timer.hpp"
+#include "sdl2_wrappers/sdl2_log.hpp"
+
+void ktp::GPUTimer::begin(RenderPass pass) {
+  GLDebug::pushGroup(passName(pass));
+  pass_start_ = SDL_GetPerformanceCounter();
+  auto& set {sets_[set_]};
+  // a pass drawn twice in a frame would overwrite its own query
+  if (!initialized_ || set.issued_[index(pass)]) return;
+  glBeginQuery(GL_TIME_ELAPSED, set.ids_[index(pass)]);
+}
+
+void ktp::GPUTimer::clean() {
+  if (!initialized_) return;
+  for (auto& set: sets_) {
+    glDeleteQueries(static_cast<GLsizei>(kPasses_), set.ids_.data());
+    set = QuerySet{};
+  }
+  initialized_ = false;
+}
+
+void ktp::GPUTimer::end(RenderPass pass) {
+  const auto elapsed {static_cast<double>(SDL_GetPerformanceCounter() - pass_start_) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency())};
+  auto& set {sets_[set_]};
+  set.cpu_[index(pass)] += elapsed;
+  cpu_average_[index(pass)] += (elapsed - cpu_average_[index(pass)]) * kSmoothing_;
+  if (initialized_ && !set.issued_[index(pass)]) {
+    glEndQuery(GL_TIME_ELAPSED);
+    set.issued_[index(pass)] = true;
+  }
+  GLDebug::popGroup();
+}
+
+void ktp::GPUTimer::flush() {
+  // oldest first, so the history stays in order
+  for (std::size_t i = 1; i <= kFrames_; ++i) read((set_ + i) % kFrames_, true);
+}
+
+void ktp::GPUTimer::init(bool record_history) {
+  record_history_ = record_history;
+  history_.clear();
+  frame_ = 0u;
+  set_ = 0u;
+  cpu_average_ = {};
+  gpu_average_ = {};
+  if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) {
+    logMessage("Warning! No timer queries available. Only CPU pass times will be measured.");
+    return;
+  }
+  for (auto& set: sets_) {
+    set = QuerySet{};
+    glGenQueries(static_cast<GLsizei>(kPasses_), set.ids_.data());
+  }
+  initialized_ = true;
+}
+
+void ktp::GPUTimer::newFrame() {
+  set_ = (set_ + 1u) % kFrames_;
+  // this set was used kFrames_ frames ago, its results should be there by now
+  read(set_, false);
+  sets_[set_].frame_ = ++frame_;
+}
+
+const char* ktp::GPUTimer::passName(RenderPass pass) {
+  switch (pass) {
+    case RenderPass::Background: return "Background";
+    case RenderPass::Aerolites:  return "Aerolites";
+    case RenderPass::Particles:  return "Particles";
+    case RenderPass::Entities:   return "Entities";
+    case RenderPass::Debug:      return "Debug draw";
+    case RenderPass::Upscale:    return "Upscale";
+    case RenderPass::GUIText:    return "GUI text";
+    case RenderPass::ImGui:      return "ImGui";
+    default:                     return "Unknown";
+  }
+}
+
+void ktp::GPUTimer::read(std::size_t set_index, bool wait) {
+  auto& set {sets_[set_index]};
+  RenderPassSample sample {set.frame_, set.cpu_, {}};
+  for (std::size_t i = 0; i < kPasses_; ++i) {
+    if (!set.issued_[i]) continue;
+    set.issued_[i] = false;
+    if (!wait) {
+      GLint available {};
+      glGetQueryObjectiv(set.ids_[i], GL_QUERY_RESULT_AVAILABLE, &available);
+      // never stall the frame, the result is just lost
+      if (!available) continue;
+    }
+    GLuint64 elapsed {};
+    glGetQueryObjectui64v(set.ids_[i], GL_QUERY_RESULT, &elapsed);
+    sample.gpu_[i] = static_cast<double>(elapsed) / 1000000.0;
+    gpu_average_[i] += (sample.gpu_[i] - gpu_average_[i]) * kSmoothing_;
+  }
+  if (record_history_ && set.frame_ > 0u) history_.push_back(sample);
+  set.cpu_ = {};
+  set.frame_ = 0u;
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "aerolite_mesh_arena.hpp"
+#include "aerolite_shape_cache.hpp"
+#include "body_pool.hpp"
 #include "config_parser.hpp"
 #include "graphics_component.hpp"
 #include "opengl.hpp"
@@ -7,6 +10,7 @@
 #include "resources.hpp"
 #include "../sdl2_wrappers/sdl2_geometry.hpp"
 #include <cmath> // atan2f
+#include <random>
 #include <utility> // std::move std::exchange
 
 namespace ktp {
@@ -20,25 +24,30 @@ struct AeroliteSpawnData;
 class AeroliteGraphicsComponent: public GraphicsComponent {
   friend class AerolitePhysicsComponent;
  public:
-  AeroliteGraphicsComponent();
+  AeroliteGraphicsComponent() = default;
+  AeroliteGraphicsComponent(const AeroliteGraphicsComponent& other) = delete;
+  ~AeroliteGraphicsComponent() { AeroliteMeshArena::release(mesh_); }
+  AeroliteGraphicsComponent& operator=(const AeroliteGraphicsComponent& other) = delete;
   void update(const GameEntity& aerolite) override;
  private:
-  const glm::vec4 color_ {Palette::colorToGlmVec4(ConfigParser::aerolites_config.colors_[1])};
-  VAO vao_ {};
-  VBO vertices_ {};
-  VBO uv_ {};
-  EBO ebo_ {};
-  ShaderProgram shader_ {Resources::getShader("aerolite")};
-  Texture2D texture_ {Resources::getTexture("aerolite_00")};
-  std::size_t indices_count_ {};
-  glm::mat4 mvp_ {};
+  /**
+   * @brief Where the mesh of the aerolite lives in the AeroliteMeshArena.
+   */
+  MeshRange mesh_ {};
 };
 
 class AerolitePhysicsComponent: public PhysicsComponent {
 
+  friend class AeroliteShapeCache;
+
  public:
 
   AerolitePhysicsComponent(GameEntity* owner, AeroliteGraphicsComponent* graphics);
+  /**
+   * @brief An aerolite of the given size instead of a random one from the config.
+   * @param size The size, rounded to the one of a cached shape.
+   */
+  AerolitePhysicsComponent(GameEntity* owner, AeroliteGraphicsComponent* graphics, float size);
   AerolitePhysicsComponent(const AerolitePhysicsComponent& other) = delete;
   AerolitePhysicsComponent(AerolitePhysicsComponent&& other) { *this = std::move(other); }
   ~AerolitePhysicsComponent();
@@ -61,12 +70,30 @@ class AerolitePhysicsComponent: public PhysicsComponent {
 
  private:
 
-  static void createB2Body(AerolitePhysicsComponent& aerolite, const GLfloatVector& triangulated_shape);
+  static void createB2Body(AerolitePhysicsComponent& aerolite, const AeroliteTemplate& shape_template);
+  void createMesh(AeroliteTemplate& shape_template);
   static Geometry::Polygon generateAeroliteShape(float size, SDL_FPoint offset = {0.f, 0.f});
   static Geometry::Polygon generateAeroliteShape(float size, unsigned int sides, SDL_FPoint offset = {0.f, 0.f});
+  /**
+   * @brief Same as generateAeroliteShape(size) but with its own random engine,
+   *  so it can be used out of the main thread.
+   */
+  template<typename Engine>
+  static Geometry::Polygon generateAeroliteShape(float size, Engine& engine) {
+    std::uniform_int_distribution<unsigned int> sides_distribution {kMinSides_, kMaxSides_};
+    std::uniform_real_distribution<float> size_distribution {0.82f, 1.f};
+    const auto sides {sides_distribution(engine)};
+    Geometry::Polygon shape {};
+    shape.reserve(sides);
+    for (auto i = 0u; i < sides; ++i) {
+      const auto f_size {size * size_distribution(engine)};
+      shape.push_back({f_size * SDL_cosf(2.f * b2_pi * (float)i / (float)sides), f_size * SDL_sinf(2.f * b2_pi * (float)i / (float)sides)});
+    }
+    return shape;
+  }
   void positionArrow();
   void split();
-  void updateMVP();
+  void updateTransform();
 
   static constexpr float kMinSize_ {1.4f};
   static constexpr unsigned int kMaxSides_ {40u};
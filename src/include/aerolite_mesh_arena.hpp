@@ -0,0 +1,157 @@
+#pragma once
+
+#include "opengl.hpp"
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief A first-fit free list that hands out contiguous ranges of elements
+ *  (vertices, indices...) from a linear store. Released ranges are merged with
+ *  their free neighbours so the store doesn't fragment when aerolites split.
+ */
+class FreeListAllocator {
+
+ public:
+
+  /**
+   * @brief Tries to reserve a contiguous range of elements.
+   * @param count The number of elements needed.
+   * @return The offset of the range or -1 if there is no room for it.
+   */
+  GLint allocate(GLsizei count);
+
+  /**
+   * @return The number of elements the allocator manages.
+   */
+  auto capacity() const { return capacity_; }
+
+  /**
+   * @brief Enlarges the managed store. The new space is added at the end.
+   * @param new_capacity The total number of elements after growing.
+   */
+  void grow(GLsizei new_capacity);
+
+  /**
+   * @brief Gives a range back to the allocator.
+   * @param offset The offset returned by allocate().
+   * @param count The number of elements of the range.
+   */
+  void release(GLint offset, GLsizei count);
+
+  /**
+   * @brief Forgets all the blocks. Capacity goes back to 0.
+   */
+  void reset();
+
+ private:
+
+  struct Block {
+    GLint   offset_ {};
+    GLsizei count_ {};
+  };
+  /**
+   * @brief Free blocks sorted by offset.
+   */
+  std::vector<Block> free_blocks_ {};
+  GLsizei capacity_ {};
+};
+
+/**
+ * @brief The portion of the arena used by one aerolite mesh.
+ */
+struct MeshRange {
+  GLint   base_vertex_ {-1};
+  GLsizei vertex_count_ {};
+  GLint   first_index_ {-1};
+  GLsizei index_count_ {};
+  bool valid() const { return base_vertex_ >= 0 && first_index_ >= 0; }
+};
+
+/**
+ * @brief All the aerolites' geometry lives in one big interleaved vertex
+ *  buffer {x, y, z, u, v} and one index buffer. Every aerolite holds a
+ *  MeshRange inside them and queues its transform each frame, then the whole
+ *  batch is drawn with one VAO bind and base vertex draws.
+ */
+class AeroliteMeshArena {
+
+ public:
+
+  /**
+   * @brief Reserves space for a mesh and uploads it.
+   * @param vertices The vertices of the mesh {x, y, z, x, y, z, ...} in pixels.
+   * @param uv The texture coordinates {u, v, u, v, ...}.
+   * @param indices The indices of the mesh, relative to its first vertex.
+   * @return The range where the mesh has been stored.
+   */
+  static MeshRange allocate(const GLfloatVector& vertices, const GLfloatVector& uv, const GLuintVector& indices);
+
+  /**
+   * @brief Deletes the OpenGL objects of the arena. Call it before the
+   *  context is destroyed.
+   */
+  static void clean();
+
+  /**
+   * @brief Draws all the queued aerolites and empties the queue.
+   * @param view_projection The projection * view matrix of the camera.
+   */
+  static void draw(const glm::mat4& view_projection);
+
+  /**
+   * @return The draw calls issued by the last draw().
+   */
+  static auto drawCalls() { return draw_calls_; }
+
+  /**
+   * @brief Queues an aerolite to be drawn in the next draw().
+   * @param range The mesh of the aerolite.
+   * @param transform {x, y, cos(angle), sin(angle)} in pixels.
+   */
+  static void queue(const MeshRange& range, const glm::vec4& transform);
+
+  /**
+   * @brief Gives back the space used by a mesh. The range is invalidated.
+   * @param range The range to release.
+   */
+  static void release(MeshRange& range);
+
+ private:
+
+  struct Buffers {
+    VAO           vao_ {};
+    VBO           vertices_ {};
+    EBO           indices_ {};
+    VBO           instances_ {};
+    GLsizei       instances_capacity_ {};
+    ShaderProgram shader_ {};
+    const Texture2D* texture_ {};
+  };
+
+  struct QueuedAerolite {
+    MeshRange range_ {};
+    glm::vec4 transform_ {};
+  };
+
+  static void createBuffers();
+  static void growIndices(GLsizei min_capacity);
+  static void growVertices(GLsizei min_capacity);
+  static void linkAttributes();
+
+  static constexpr GLsizei kInitialIndices_ {64 * 1024};
+  static constexpr GLsizei kInitialInstances_ {64};
+  static constexpr GLsizei kInitialVertices_ {16 * 1024};
+  static constexpr GLsizei kVertexComponents_ {5};
+
+  static std::unique_ptr<Buffers>    buffers_;
+  static GLsizei                     draw_calls_;
+  static FreeListAllocator           index_allocator_;
+  static std::vector<glm::vec4>      instances_data_;
+  static std::vector<QueuedAerolite> queue_;
+  static FreeListAllocator           vertex_allocator_;
+};
+
+} // namespace ktp
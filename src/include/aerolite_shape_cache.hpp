@@ -0,0 +1,116 @@
+#pragma once
+
+#include "aerolite_mesh_arena.hpp"
+#include "config_parser.hpp"
+#include "opengl.hpp"
+#include "../sdl2_wrappers/sdl2_geometry.hpp"
+#include <box2d/box2d.h>
+#include <SDL.h>
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief Everything an aerolite needs from its shape, made ahead of time.
+ */
+struct AeroliteTemplate {
+  float                       size_ {};
+  // Box2D, in meters
+  std::vector<b2PolygonShape> pieces_ {};
+  b2MassData                  mass_data_ {};
+  // OpenGL, vertices in pixels and without duplicates
+  GLfloatVector               vertices_ {};
+  GLfloatVector               uv_ {};
+  GLuintVector                indices_ {};
+  // already in the arena if valid, the aerolite that takes it owns it
+  MeshRange                   mesh_ {};
+};
+
+/**
+ * @brief Keeps some aerolite templates ready for every size bucket, so a spawn
+ *  or a split only costs a lookup and the fixtures creation. A worker thread
+ *  refills the buckets with new random shapes, and the meshes are uploaded to
+ *  the arena in update(), out of the collisions. Sizes are rounded to their
+ *  bucket. Headless runs don't use it, b/c the shapes taken would depend on
+ *  the worker's timing.
+ */
+class AeroliteShapeCache {
+
+ public:
+
+  /**
+   * @brief Builds a template from a shape, without uploading the mesh. It
+   *  doesn't touch anything shared, so the worker can use it.
+   * @param shape The shape of the aerolite, in meters.
+   * @param size The size the shape was made for.
+   * @return The template.
+   */
+  static AeroliteTemplate build(const Geometry::Polygon& shape, float size);
+
+  /**
+   * @brief Stops the worker and gives back the meshes of the templates not
+   *  taken. Call it before the arena is cleaned.
+   */
+  static void clean();
+
+  /**
+   * @return The templates taken from the cache.
+   */
+  static auto hits() { return hits_; }
+
+  /**
+   * @brief Starts the worker.
+   * @param config The cache options.
+   * @param headless True to build every template when it's needed.
+   */
+  static void init(const ConfigParser::AeroliteCacheConfig& config, bool headless);
+
+  /**
+   * @return The templates built when they were needed, b/c the bucket was
+   *  empty or the size out of range.
+   */
+  static auto misses() { return misses_; }
+
+  /**
+   * @return The templates ready to be taken.
+   */
+  static unsigned int ready();
+
+  /**
+   * @brief Gets a template for an aerolite. Main thread only.
+   * @param size The size wanted.
+   * @return A template from the bucket of the size, or a new one of the exact
+   *  size if there's none.
+   */
+  static AeroliteTemplate take(float size);
+
+  /**
+   * @brief Uploads the meshes of the templates the worker finished and puts
+   *  them in their buckets. Call it once per tick from the main thread.
+   */
+  static void update();
+
+ private:
+
+  static int bucket(float size);
+  static float bucketSize(std::size_t bucket);
+  static int run(void* data);
+
+  // uploads per update(), so a refill is spread over some ticks
+  static constexpr std::size_t kMaxUploads_ {4u};
+
+  static std::vector<std::vector<AeroliteTemplate>> buckets_;
+  static ConfigParser::AeroliteCacheConfig          config_;
+  static unsigned int                               hits_;
+  static float                                      min_size_;
+  static unsigned int                               misses_;
+  static SDL_Thread*                                thread_;
+  // shared with the worker, behind mutex_
+  static SDL_mutex*                                 mutex_;
+  static SDL_cond*                                  condition_;
+  static bool                                       quit_;
+  static std::vector<AeroliteTemplate>              finished_;
+  static std::vector<unsigned int>                  stock_;
+};
+
+} // namespace ktp
@@ -23,6 +23,7 @@ class BackgroundGraphicsComponent: public GraphicsComponent {
 
   BackgroundGraphicsComponent();
 
+  auto starsCount() const { return stars_count_; }
   virtual void update(const GameEntity& background) override;
 
  private:
@@ -38,6 +39,12 @@ class BackgroundGraphicsComponent: public GraphicsComponent {
   ShaderProgram shader_ {Resources::getShader("star")};
   VBO           subdata_ {};
   glm::mat4     mvp_ {};
+  /**
+   * @brief Scroll time, wrapped to the period of the stars. The stars'
+   *  positions are computed in the vertex shader from it, so nothing gets
+   *  uploaded each tick.
+   */
+  double        scroll_time_ {};
   GLuint        stars_count_ {};
 };
 
@@ -59,8 +66,12 @@ class BackgroundPhysicsComponent: public PhysicsComponent {
 
   void generateStars();
   void updateMVP();
-  static constexpr auto kComponents_ {6u};
+  // x, y, speed, r, g, b, a
+  static constexpr auto kComponents_ {7u};
+  // the speeds are multiples of this, so they all loop after height / kSpeedStep_
+  static constexpr auto kSpeedStep_ {0.001f};
   BackgroundGraphicsComponent* graphics_ {nullptr};
+  double                       scroll_period_ {};
   std::vector<Star>            stars_ {};
   GLfloatVector                subdata_ {};
 };
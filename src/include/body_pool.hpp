@@ -0,0 +1,98 @@
+#pragma once
+
+#include <box2d/box2d.h>
+#include <array>
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief The kinds of bodies that are recycled. Bodies of the same archetype
+ *  have the same fixtures, except aerolites, which swap them on every use.
+ */
+enum class BodyArchetype {
+  Aerolite,
+  ExplosionRay,
+  Projectile,
+  count
+};
+
+/**
+ * @brief Keeps the bodies of the entities that come and go all the time, so
+ *  they don't go through CreateBody/DestroyBody and Box2D's block allocator
+ *  every time. A released body is parked disabled, without broadphase proxies
+ *  or contacts, far from the play area so b2World::DebugDraw() doesn't show it
+ *  on screen, and acquire() resets it like a new one. clearB2World() destroys
+ *  the parked bodies too, so clear() must follow it.
+ */
+class BodyPool {
+
+ public:
+
+  struct Counters {
+    unsigned int created_ {};   // CreateBody calls
+    unsigned int destroyed_ {}; // DestroyBody calls, the pool was full
+    unsigned int reused_ {};    // bodies taken from the pool
+    unsigned int parked_ {};    // bodies given back to the pool
+  };
+
+  /**
+   * @brief Gets a body, parked or new.
+   * @param archetype The kind of body.
+   * @param body_def What CreateBody would be given. A parked body is set to it.
+   * @return The body. If it has no fixtures it's new, a parked one keeps them.
+   */
+  static b2Body* acquire(BodyArchetype archetype, const b2BodyDef& body_def);
+
+  /**
+   * @brief Forgets the parked bodies. Call it after the world is cleared.
+   */
+  static void clear();
+
+  /**
+   * @brief Moves the counters of this frame to lastFrame().
+   */
+  static void endFrame();
+
+  /**
+   * @brief Sets the world the bodies belong to.
+   * @param world The Box2D world.
+   */
+  static void init(b2World* world);
+
+  /**
+   * @return The counters of the last whole frame.
+   */
+  static const auto& lastFrame() { return last_frame_; }
+
+  /**
+   * @return How many bodies are parked, of all kinds.
+   */
+  static std::size_t parked();
+
+  /**
+   * @param archetype The kind of body.
+   * @return How many bodies of that kind are parked.
+   */
+  static auto parked(BodyArchetype archetype) { return parked_[static_cast<std::size_t>(archetype)].size(); }
+
+  /**
+   * @brief Parks a body, or destroys it if there are enough of its kind.
+   * @param archetype The kind of body.
+   * @param body The body, nullptr is ignored.
+   */
+  static void release(BodyArchetype archetype, b2Body* body);
+
+ private:
+
+  static constexpr auto        kArchetypes_ {static_cast<std::size_t>(BodyArchetype::count)};
+  // an explosion has some tens of rays, so a few of them in a row still fit
+  static constexpr std::size_t kMaxParked_ {512u};
+
+  static Counters                                       frame_;
+  static Counters                                       last_frame_;
+  static std::array<std::vector<b2Body*>, kArchetypes_> parked_;
+  static b2World*                                       world_;
+};
+
+} // namespace ktp
@@ -1,6 +1,7 @@
 #ifndef AEROLITS_SRC_INCLUDE_BOX2D_UTILS_HPP_
 #define AEROLITS_SRC_INCLUDE_BOX2D_UTILS_HPP_
 
+#include "config_parser.hpp"
 #include <box2d/box2d.h>
 
 namespace ktp {
@@ -24,6 +25,30 @@ inline void clearB2World(b2World& world) {
   }
 }
 
+/**
+ * @brief Makes the filter of the fixtures of an entity type.
+ * @param collision The layer and mask of the type.
+ * @return The filter for its b2FixtureDef.
+ */
+inline b2Filter collisionFilter(const ConfigParser::CollisionConfig& collision) {
+  b2Filter filter {};
+  filter.categoryBits = collision.layer_;
+  filter.maskBits = collision.mask_;
+  return filter;
+}
+
+/**
+ * @brief The test b2ContactFilter does, groups first, for what moves without
+ *  a body.
+ * @param filter The filter its body would have.
+ * @param other The filter of a fixture it finds.
+ * @return True if its body would make a pair with the fixture.
+ */
+inline bool shouldCollide(const b2Filter& filter, const b2Filter& other) {
+  if (filter.groupIndex == other.groupIndex && filter.groupIndex != 0) return filter.groupIndex > 0;
+  return (filter.maskBits & other.categoryBits) != 0 && (filter.categoryBits & other.maskBits) != 0;
+}
+
 } // namespace ktp
 
 #endif // AEROLITS_SRC_INCLUDE_BOX2D_UTILS_HPP_
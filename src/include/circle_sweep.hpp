@@ -0,0 +1,98 @@
+#pragma once
+
+#include <box2d/box2d.h>
+#include <cmath> // std::abs
+
+namespace ktp {
+
+/**
+ * @brief What a moving circle does with a shape during a sweep.
+ */
+enum class SweepHit {
+  None,   // they don't touch
+  Enters, // it touches the shape from outside
+  Inside  // it already overlapped the shape at the start
+};
+
+/**
+ * @brief Swept circle against a circle.
+ * @param circle The shape, in its body's frame.
+ * @param start Where the circle starts, in the same frame.
+ * @param sweep How much it moves.
+ * @param radius The radius of the moving circle.
+ * @param fraction The fraction of the sweep where they touch, 0 if Inside.
+ * @param normal The normal of the shape where they touch, or the way out if
+ *  Inside.
+ * @return What happened.
+ */
+inline SweepHit sweepCircle(const b2CircleShape& circle, const b2Vec2& start, const b2Vec2& sweep, float radius, float& fraction, b2Vec2& normal) {
+  const auto s {start - circle.m_p};
+  const auto r {circle.m_radius + radius};
+  const auto c {b2Dot(s, s) - r * r};
+  if (c <= 0.f) {
+    fraction = 0.f;
+    normal = s;
+    // right at the center any way is out
+    if (normal.Normalize() < b2_epsilon) normal.Set(1.f, 0.f);
+    return SweepHit::Inside;
+  }
+  const auto b {b2Dot(s, sweep)};
+  const auto rr {b2Dot(sweep, sweep)};
+  const auto sigma {b * b - rr * c};
+  if (b >= 0.f || sigma < 0.f || rr < b2_epsilon) return SweepHit::None;
+  const auto t {-(b + b2Sqrt(sigma)) / rr};
+  if (t > 1.f) return SweepHit::None;
+  fraction = t;
+  normal = s + t * sweep;
+  normal.Normalize();
+  return SweepHit::Enters;
+}
+
+/**
+ * @brief Swept circle against a polygon, as a ray against the polygon pushed
+ *  out by the radius along its normals. Its corners end up square instead of
+ *  round, close enough for shrapnel.
+ * @param polygon The shape, in its body's frame.
+ * @param start Where the circle starts, in the same frame.
+ * @param sweep How much it moves.
+ * @param radius The radius of the moving circle.
+ * @param fraction The fraction of the sweep where they touch, 0 if Inside.
+ * @param normal The normal of the face they touch, or of the nearest face if
+ *  Inside.
+ * @return What happened.
+ */
+inline SweepHit sweepPolygon(const b2PolygonShape& polygon, const b2Vec2& start, const b2Vec2& sweep, float radius, float& fraction, b2Vec2& normal) {
+  float lower {0.f}, upper {1.f}, separation {-b2_maxFloat};
+  int32 index {-1}, nearest {0};
+  for (int32 i = 0; i < polygon.m_count; ++i) {
+    // the same clipping as b2PolygonShape::RayCast, with the faces moved out
+    const auto numerator {b2Dot(polygon.m_normals[i], polygon.m_vertices[i] - start) + radius};
+    const auto denominator {b2Dot(polygon.m_normals[i], sweep)};
+    if (-numerator > separation) {
+      separation = -numerator;
+      nearest = i;
+    }
+    // parallel, or so close to it that the division would blow up
+    if (std::abs(denominator) < b2_epsilon) {
+      if (numerator < 0.f) return SweepHit::None;
+    } else if (denominator < 0.f && numerator < lower * denominator) {
+      lower = numerator / denominator;
+      index = i;
+    } else if (denominator > 0.f && numerator < upper * denominator) {
+      upper = numerator / denominator;
+    }
+    if (upper < lower) return SweepHit::None;
+  }
+  // like b2PolygonShape::RayCast, only entering counts as a hit
+  if (index >= 0) {
+    fraction = lower;
+    normal = polygon.m_normals[index];
+    return SweepHit::Enters;
+  }
+  // nothing cut the sweep off and no face was crossed, so it starts behind all of them
+  fraction = 0.f;
+  normal = polygon.m_normals[nearest];
+  return SweepHit::Inside;
+}
+
+} // namespace ktp
@@ -4,6 +4,8 @@
 #include "palette.hpp"
 #include <pugixml.hpp>
 #include <SDL.h>
+#include <cstdint> // std::uint16_t
+#include <set>
 #include <string>
 #include <vector>
 
@@ -43,6 +45,40 @@ namespace ConfigParser {
 
   void loadConfigFiles();
 
+  // COLLISIONS
+
+  /**
+   * @brief The collision layers. Every fixture is in the layer of its entity,
+   *  the player and the demo player share one.
+   */
+  enum CollisionLayer: std::uint16_t {
+    kAeroliteLayer   = 0x0001,
+    kExplosionLayer  = 0x0002,
+    kPlayerLayer     = 0x0004,
+    kProjectileLayer = 0x0008,
+    kSpawnerLayer    = 0x0010,
+    kAllLayers       = 0xFFFF
+  };
+
+  /**
+   * @brief The Box2D filter and CCD of the bodies of an entity type. Two
+   *  fixtures only make a pair if each one's layer is in the other one's mask.
+   */
+  struct CollisionConfig {
+    std::uint16_t layer_ {kAllLayers};
+    std::uint16_t mask_ {kAllLayers};
+    bool bullet_ {false}; // continuous collision against dynamic bodies too
+  };
+
+  /**
+   * @brief Reads a <collision bullet="" collidesWith=""/> element. Missing
+   *  attributes keep what the config already has.
+   * @param collision The element.
+   * @param name What the warnings call the entity.
+   * @param config Where the values go.
+   */
+  void loadCollisionConfig(const pugi::xml_node& collision, const std::string& name, CollisionConfig& config);
+
   // AEROLITES
   struct AerolitesConfig {
     ColorsVector colors_ {Palette::orange};
@@ -52,10 +88,32 @@ namespace ConfigParser {
     RRVFloat rotation_speed_ {2.f, -1.f, 1.f};
     RRVFloat size_ {3.0f, 0.6f, 1.f};
     RRVFloat speed_ {10.f, 0.1f, 1.f};
+    CollisionConfig collision_ {kAeroliteLayer, kAllLayers};
+    // the spawner only looks for something in the way of the next aerolite
+    CollisionConfig spawner_collision_ {kSpawnerLayer, kAeroliteLayer | kExplosionLayer | kProjectileLayer};
   };
   extern AerolitesConfig aerolites_config;
   void loadAerolitesConfig();
 
+  // BENCHMARK
+
+  /**
+   * @brief Options for the render benchmark in the testing state, set from the
+   *  command line: --benchmark aerolites|cubes|debug|particles|projectiles|stars
+   *  [--count N] [--ramp] [--ramp-step N] [--threshold ms] [--expect N] [--particles N]
+   */
+  struct BenchmarkConfig {
+    unsigned int count_ {100u};
+    bool enabled_ {false};
+    unsigned int expect_ {0u};
+    unsigned int particles_per_emitter_ {50u};
+    bool ramp_ {false};
+    unsigned int ramp_step_ {50u};
+    std::string scenario_ {"cubes"};
+    float threshold_ {16.6f}; // ms
+  };
+  extern BenchmarkConfig benchmark_config;
+
   // EMITTERS
 
   void constructEmitterTypesVector(const pugi::xml_document& doc);
@@ -65,13 +123,101 @@ namespace ConfigParser {
 
   // GAME
 
+  /**
+   * @brief Aerolite templates kept ready for every size bucket, the sizes
+   *  are rounded to bucket size.
+   */
+  struct AeroliteCacheConfig {
+    float bucket_size_ {0.2f};
+    bool enabled_ {true};
+    unsigned int per_bucket_ {4u};
+  };
+
+  /**
+   * @brief The scene is rendered at a scale of the screen size that moves
+   *  between min and max to hold the target frame time.
+   */
+  struct DynamicResolutionConfig {
+    bool enabled_ {true};
+    float max_scale_ {1.f};
+    float min_scale_ {0.5f};
+    float target_frame_time_ {16.6f}; // ms
+  };
+
+  /**
+   * @brief Ticks per second of the simulation. A frame runs at most max steps
+   *  ticks to catch up, the rest are dropped.
+   */
+  struct FixedStepConfig {
+    unsigned int max_steps_ {5u};
+    unsigned int tick_rate_ {100u};
+  };
+
+  /**
+   * @brief Frames per second the main loop waits for before every present,
+   *  and the swap interval. The wait sleeps until spin time ms are left and
+   *  spins the rest. A target of 0 means no limit.
+   */
+  struct FramePacingConfig {
+    float spin_time_ {1.5f}; // ms
+    unsigned int target_fps_ {0u};
+    std::string vsync_ {"adaptive"}; // off, on, adaptive
+  };
+
+  /**
+   * @brief Asks for a debug context and reports the OpenGL messages as they
+   *  happen. On by default only in debug builds.
+   */
+  struct GLDebugConfig {
+  #ifdef NDEBUG
+    bool enabled_ {false};
+  #else
+    bool enabled_ {true};
+  #endif
+    std::string min_severity_ {"medium"}; // high, medium, low, notification
+  };
+
+  /**
+   * @brief Frames per second of the states with little to animate, so they
+   *  don't spin the CPU and the GPU. 0 means no limit.
+   */
+  struct IdleFrameRateConfig {
+    unsigned int paused_ {20u};
+    unsigned int title_ {30u};
+  };
+
   struct GameConfig {
+    AeroliteCacheConfig aerolite_cache_ {};
+    DynamicResolutionConfig dynamic_resolution_ {};
+    FixedStepConfig fixed_step_ {};
+    FramePacingConfig frame_pacing_ {};
+    GLDebugConfig gl_debug_ {};
+    IdleFrameRateConfig idle_frame_rate_ {};
     bool output_ {true};
+    bool physics_thread_ {true};
     SDL_Point screen_size_ {1366, 768};
+    bool shader_cache_ {true};
   };
   extern GameConfig game_config;
   void loadGameConfig();
 
+  // HEADLESS
+
+  /**
+   * @brief Options to run without a visible window, set from the command line:
+   *  --headless [--frames N] [--capture 1,60,120] [--output dir] [--state title|demo|playing|testing]
+   *  Without a display use SDL_VIDEODRIVER=offscreen (EGL) or Mesa's llvmpipe.
+   */
+  struct HeadlessConfig {
+    std::set<unsigned int> capture_frames_ {};
+    bool enabled_ {false};
+    unsigned int frames_ {600u};
+    std::string output_path_ {"capture"};
+    std::string state_ {"demo"};
+  };
+  extern HeadlessConfig headless_config;
+  void parseCommandLine(int argc, char* argv[]);
+
   // PLAYER
 
   /**
@@ -86,6 +232,7 @@ namespace ConfigParser {
     float angular_impulse_ {5.f};
     float linear_impulse_ {0.05f};
     float max_delta_ {0.1f};
+    CollisionConfig collision_ {kPlayerLayer, kAeroliteLayer | kPlayerLayer | kProjectileLayer, true};
   };
   extern PlayerConfig player_config;
   void loadPlayerConfig();
@@ -102,6 +249,8 @@ namespace ConfigParser {
     float particle_radius_ {0.2f};
     unsigned int rays_ {100u};
     float restitution_ {0.99f};
+    bool shrapnel_ {false}; // rays simulated outside Box2D instead of bodies
+    CollisionConfig collision_ {kExplosionLayer, kAeroliteLayer | kProjectileLayer | kSpawnerLayer, true};
   };
   extern ExplosionConfig explosion_config;
 
@@ -110,10 +259,12 @@ namespace ConfigParser {
     Color color_ {Palette::copper_green};
     float density_ {10.f};
     float friction_ {0.1f};
+    bool ray_cast_ {false}; // moved here and ray cast instead of a bullet body
     float restitution_ {0.35f};
     float size_ {0.15f};
     float speed_ {0.1f};
     ExplosionConfig explosion_config_ {};
+    CollisionConfig collision_ {kProjectileLayer, kAllLayers, true};
   };
   extern ProjectilesConfig projectiles_config;
   void loadProjectilesConfig();
@@ -6,6 +6,47 @@ namespace ktp {
 
 class GameEntity;
 
+/**
+ * @brief Box2D's default filter, counting the pairs the broadphase asks about.
+ *  It runs with the step, maybe on the physics worker, so the counters of a
+ *  step are only read once it's waited for.
+ */
+class ContactFilter: public b2ContactFilter {
+
+ public:
+
+  struct Counters {
+    unsigned int accepted_ {}; // pairs that got a contact
+    int          contacts_ {}; // contacts in the world after the step
+    unsigned int filtered_ {}; // pairs the layers or the groups threw away
+  };
+
+  /**
+   * @brief Moves the counters of the finished step to lastStep(). Call it
+   *  after the step is waited for, the world can't be read while it steps.
+   * @param world The world that was stepped, for its contact count.
+   */
+  void endStep(const b2World& world);
+
+  /**
+   * @return The counters of the last finished step.
+   */
+  const auto& lastStep() const { return last_step_; }
+
+  /**
+   * @brief Return true if contact calculations should be performed between
+   * these two shapes.
+   * @warning for performance reasons this is only called when the AABBs begin
+   * to overlap.
+   */
+  virtual bool ShouldCollide(b2Fixture* fixture_a, b2Fixture* fixture_b) override;
+
+ private:
+
+  Counters last_step_ {};
+  Counters step_ {};
+};
+
 /**
  * @brief Implement this class to get contact information.
  * You can use these results for things like sounds and game logic.
@@ -6,89 +6,156 @@
 #include <box2d/box2d.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
 
 namespace ktp {
 
-inline constexpr auto kMaxVertices {512u};
+struct DebugVertex {
+  b2Vec2  position_ {};
+  b2Color color_ {};
+};
+
+struct DebugPoint {
+  b2Vec2  position_ {};
+  b2Color color_ {};
+  float   size_ {};
+};
+
+struct DebugCircle {
+  b2Vec2  center_ {};
+  float   radius_ {};
+  b2Color color_ {};
+};
+
+struct DebugAABB {
+  b2Vec2  lower_ {};
+  b2Vec2  upper_ {};
+  b2Color color_ {};
+};
+
+/**
+ * @brief Uploads a whole frame of data to a streaming VBO, growing it when needed.
+ * @param vbo The VBO to upload the data to.
+ * @param capacity The current size in bytes of the VBO. Updated if it grows.
+ * @param data The data to upload.
+ */
+template <typename T>
+void streamData(VBO& vbo, GLsizeiptr& capacity, const std::vector<T>& data) {
+  const auto size {static_cast<GLsizeiptr>(data.size() * sizeof(T))};
+  if (size > capacity) capacity = size * 2;
+  // orphan the previous store so we don't wait for the GPU
+  vbo.setup(nullptr, capacity, GL_STREAM_DRAW);
+  vbo.setupSubData(data.data(), size);
+}
 
 class GLRenderLines {
  public:
 
   GLRenderLines();
-  void addVertex(const b2Vec2& vertex, const b2Color& color);
-  void update();
+  void addVertex(const b2Vec2& vertex, const b2Color& color) { vertices_.push_back({vertex, color}); }
+  void update(const glm::mat4& mvp);
 
  private:
 
-  void updateMVP();
-
-	b2Vec2 vertices_[kMaxVertices * 2];
-	b2Color colors_[kMaxVertices * 2];
-
-	int32 count_ {0};
-
-	VAO vao_ {};
-  VBO vertices_attr_ {};
-  VBO colors_attr_ {};
-	ShaderProgram shader_ {Resources::getShader("debug_draw_lines")};
-  glm::mat4 mvp_ {};
+  std::vector<DebugVertex> vertices_ {};
+  GLsizeiptr    capacity_ {};
+  VAO           vao_ {};
+  VBO           vertices_attr_ {};
+  ShaderProgram shader_ {Resources::getShader("debug_draw_lines")};
 };
 
 class GLRenderPoints {
  public:
 
   GLRenderPoints();
-  void addVertex(const b2Vec2& vertex, const b2Color& color, float size);
-  void update();
+  void addVertex(const b2Vec2& vertex, const b2Color& color, float size) { points_.push_back({vertex, color, size}); }
+  void update(const glm::mat4& mvp);
 
  private:
 
-  void updateMVP();
+  std::vector<DebugPoint> points_ {};
+  GLsizeiptr    capacity_ {};
+  VAO           vao_ {};
+  VBO           points_attr_ {};
+  ShaderProgram shader_ {Resources::getShader("debug_draw_points")};
+};
 
-	b2Vec2 vertices_[kMaxVertices];
-	b2Color colors_[kMaxVertices];
-  float sizes_[kMaxVertices];
+class GLRenderTriangles {
+ public:
+
+  GLRenderTriangles();
+  void addVertex(const b2Vec2& vertex, const b2Color& color) { vertices_.push_back({vertex, color}); }
+  void update(const glm::mat4& mvp);
 
-	int32 count_ {0};
+ private:
 
-	VAO vao_ {};
-  VBO vertices_attr_ {};
-  VBO colors_attr_ {};
-  VBO sizes_attr_ {};
-	ShaderProgram shader_ {Resources::getShader("debug_draw_points")};
-  glm::mat4 mvp_ {};
+  std::vector<DebugVertex> vertices_ {};
+  GLsizeiptr    capacity_ {};
+  VAO           vao_ {};
+  VBO           vertices_attr_ {};
+  ShaderProgram shader_ {Resources::getShader("debug_draw_triangles")};
 };
 
-class GLRenderTriangles {
+/**
+ * @brief Circles drawn as instances of a unit circle mesh. Outlines and fills
+ *  go in one instanced call each.
+ */
+class GLRenderCircles {
  public:
 
-  GLRenderTriangles();
-  void addVertex(const b2Vec2& vertex, const b2Color& color);
-  void update();
+  GLRenderCircles();
+  void addFill(const b2Vec2& center, float radius, const b2Color& color) { fills_.push_back({center, radius, color}); }
+  void addOutline(const b2Vec2& center, float radius, const b2Color& color) { outlines_.push_back({center, radius, color}); }
+  void update(const glm::mat4& mvp);
 
  private:
 
-  void updateMVP();
+  static constexpr auto kSegments_ {16u};
+  std::vector<DebugCircle> fills_ {};
+  std::vector<DebugCircle> outlines_ {};
+  GLsizeiptr    fills_capacity_ {};
+  GLsizeiptr    outlines_capacity_ {};
+  VBO           mesh_ {};
+  VAO           fills_vao_ {};
+  VBO           fills_attr_ {};
+  VAO           outlines_vao_ {};
+  VBO           outlines_attr_ {};
+  ShaderProgram shader_ {Resources::getShader("debug_draw_circles")};
+};
 
-	b2Vec2 vertices_[kMaxVertices * 3];
-	b2Color colors_[kMaxVertices * 3];
+/**
+ * @brief AABBs drawn as instances of a unit quad outline.
+ */
+class GLRenderAABBs {
+ public:
+
+  GLRenderAABBs();
+  void addAABB(const b2Vec2& lower, const b2Vec2& upper, const b2Color& color) { aabbs_.push_back({lower, upper, color}); }
+  void update(const glm::mat4& mvp);
 
-	int32 count_ {0};
+ private:
 
-	VAO vao_ {};
-  VBO vertices_attr_ {};
-  VBO colors_attr_ {};
-	ShaderProgram shader_ {Resources::getShader("debug_draw_triangles")};
-  glm::mat4 mvp_ {};
+  std::vector<DebugAABB> aabbs_ {};
+  GLsizeiptr    capacity_ {};
+  VBO           mesh_ {};
+  VAO           vao_ {};
+  VBO           aabbs_attr_ {};
+  ShaderProgram shader_ {Resources::getShader("debug_draw_aabbs")};
 };
 
 /**
  * @brief Debug draw class heavily based on Erin Catto's testbed implementation. Thanks!
+ *  Everything is buffered during the frame and flushed once per primitive type in Draw().
  */
 class DebugDraw: public b2Draw {
  public:
 
+  /**
+   * @brief Releases the renderers and their GL objects. Init() makes them again.
+   */
+  void Clean();
   void Draw();
+  void DrawAABB(const b2AABB& aabb, const b2Color& color);
   void DrawCircle(const b2Vec2& center, float radius, const b2Color& color) override;
   void DrawPoint(const b2Vec2& point, float size, const b2Color& color) override;
   void DrawPolygon(const b2Vec2* vertices, int32 vertex_count, const b2Color& color) override;
@@ -96,10 +163,18 @@ class DebugDraw: public b2Draw {
   void DrawSolidPolygon(const b2Vec2* vertices, int32 vertex_count, const b2Color& color) override;
   void DrawSegment(const b2Vec2& start, const b2Vec2& end, const b2Color& color) override;
   void DrawTransform(const b2Transform& xf) override;
+  /**
+   * @brief Use it instead of b2World::DebugDraw(), it draws the AABBs
+   *  instanced instead of as polygons.
+   * @param world The world to draw.
+   */
+  void DrawWorld(b2World& world);
   void Init();
 
  private:
 
+  std::unique_ptr<GLRenderAABBs>     aabbs_ {};
+  std::unique_ptr<GLRenderCircles>   circles_ {};
   std::unique_ptr<GLRenderLines>     lines_ {};
   std::unique_ptr<GLRenderPoints>    points_ {};
   std::unique_ptr<GLRenderTriangles> triangles_ {};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "opengl.hpp"
+#include <SDL.h>
+#include <memory>
+
+namespace ktp {
+
+/**
+ * @brief Renders the scene into an offscreen target at a fraction of the
+ *  screen size and upscales it to the window with a fullscreen triangle, so
+ *  the window can be multisampled. The fraction adapts to the frame time
+ *  between the configured bounds. The target is allocated once at the max
+ *  scale and only the viewport changes, so a new scale is free.
+ *  Everything drawn after end() (GUI, ImGui) goes at native resolution.
+ */
+class DynamicResolution {
+
+ public:
+
+  /**
+   * @brief Binds the offscreen target with the scaled viewport and clears it.
+   *  When disabled it just binds the output framebuffer and clears it.
+   */
+  void begin() const;
+
+  /**
+   * @brief Deletes the OpenGL objects. Call it before the context is destroyed.
+   */
+  void clean();
+
+  /**
+   * @return True if the scene is being rendered offscreen.
+   */
+  auto enabled() const { return enabled_; }
+
+  /**
+   * @brief Upscales the offscreen target to the output framebuffer and
+   *  restores the native viewport. Does nothing when disabled.
+   */
+  void end() const;
+
+  /**
+   * @brief Creates the offscreen target using the game config. Call
+   *  setOutput() before this if the output isn't the window.
+   * @param screen_size The native size of the window.
+   */
+  void init(const SDL_Point& screen_size);
+
+  /**
+   * @return The framebuffer where end() puts the upscaled scene.
+   */
+  auto output() const { return output_; }
+
+  /**
+   * @return The current fraction of the screen size used for the scene.
+   */
+  auto scale() const { return enabled_ ? scale_ : 1.f; }
+
+  /**
+   * @brief Sets where end() puts the upscaled scene.
+   * @param framebuffer The id of the framebuffer, 0 for the window.
+   */
+  void setOutput(GLuint framebuffer) { output_ = framebuffer; }
+
+  /**
+   * @brief Adapts the scale to the last frame times.
+   * @param frame_time The last frame time in seconds.
+   */
+  void update(double frame_time);
+
+ private:
+
+  GLsizei scaledHeight() const { return static_cast<GLsizei>(screen_size_.y * scale_); }
+  GLsizei scaledWidth() const { return static_cast<GLsizei>(screen_size_.x * scale_); }
+
+  // frames to wait between scale changes, so it doesn't oscillate
+  static constexpr unsigned kCooldownFrames_ {30u};
+  // go down above target * kUpperTolerance_, up below target * kLowerTolerance_
+  static constexpr double   kLowerTolerance_ {0.8};
+  static constexpr double   kUpperTolerance_ {1.1};
+  static constexpr float    kScaleStep_ {0.05f};
+  // weight of the newest frame in the moving average
+  static constexpr double   kSmoothing_ {0.1};
+
+  double               average_frame_time_ {}; // ms
+  bool                 enabled_ {false};
+  FBO                  fbo_ {};
+  unsigned             frames_since_change_ {};
+  float                max_scale_ {1.f};
+  float                min_scale_ {1.f};
+  GLuint               output_ {};
+  float                scale_ {1.f};
+  SDL_Point            screen_size_ {};
+  std::unique_ptr<VAO> screen_vao_ {};
+  double               target_frame_time_ {}; // ms
+};
+
+} // namespace ktp
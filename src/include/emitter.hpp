@@ -64,7 +64,7 @@ class EmitterGraphicsComponent: public GraphicsComponent {
   VBO           subdata_ {};
   glm::mat4     mvp_ {};
   ShaderProgram shader_ {Resources::getShader("particle")};
-  Texture2D     texture_ {Resources::getTexture("particle_02")};
+  const Texture2D* texture_ {&Resources::getTexture("particle_02")};
 };
 
 class EmitterPhysicsComponent: public PhysicsComponent {
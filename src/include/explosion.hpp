@@ -1,5 +1,6 @@
 #pragma once
 
+#include "body_pool.hpp"
 #include "config_parser.hpp"
 #include "graphics_component.hpp"
 #include "physics_component.hpp"
@@ -33,9 +34,15 @@ class ExplosionGraphicsComponent: public GraphicsComponent {
   glm::mat4     mvp_ {};
   bool          render_ {false};
   ShaderProgram shader_ {Resources::getShader("explosion")};
-  Texture2D     texture_ {Resources::getTexture("particle_02")};
+  const Texture2D* texture_ {&Resources::getTexture("particle_02")};
 };
 
+/**
+ * @brief The rays of an explosion are Box2D bullet bodies, or, in shrapnel
+ *  mode, points simulated here with the same damping. Shrapnel finds what it
+ *  hits with one AABB query per tick and pushes it with impulses, so an
+ *  explosion costs no bodies at all.
+ */
 class ExplosionPhysicsComponent: public PhysicsComponent {
 
   friend class ProjectilePhysicsComponent;
@@ -45,7 +52,7 @@ class ExplosionPhysicsComponent: public PhysicsComponent {
   ExplosionPhysicsComponent(GameEntity* owner, ExplosionGraphicsComponent* graphics);
   ExplosionPhysicsComponent(const ExplosionPhysicsComponent& other) = delete;
   ExplosionPhysicsComponent(ExplosionPhysicsComponent&& other) { *this = std::move(other); }
-  ~ExplosionPhysicsComponent() override { for (auto ray: explosion_rays_) if (ray) world_->DestroyBody(ray); }
+  ~ExplosionPhysicsComponent() override { for (auto ray: explosion_rays_) BodyPool::release(BodyArchetype::ExplosionRay, ray); }
 
   ExplosionPhysicsComponent& operator=(const ExplosionPhysicsComponent& other) = delete;
   ExplosionPhysicsComponent& operator=(ExplosionPhysicsComponent&& other);
@@ -56,13 +63,30 @@ class ExplosionPhysicsComponent: public PhysicsComponent {
 
  private:
 
+  /**
+   * @brief The rays when they aren't bodies, one entry per ray.
+   */
+  struct Shrapnel {
+    std::vector<float>       x_ {};
+    std::vector<float>       y_ {};
+    std::vector<float>       vx_ {};
+    std::vector<float>       vy_ {};
+    float                    mass_ {};
+    float                    radius_ {};
+    // what some shrapnel started inside of, already told about it
+    std::vector<GameEntity*> overlapped_ {};
+  };
+
+  void shrapnelHit(GameEntity* other, const b2Vec2& point, const b2Vec2& normal);
   void updateMVP();
+  void updateShrapnel(float delta_time);
 
   bool                          detonated_ {false};
   unsigned int                  detonation_time_ {};
   ConfigParser::ExplosionConfig explosion_config_ {ConfigParser::explosion_config};
   std::vector<b2Body*>          explosion_rays_ {};
   ExplosionGraphicsComponent*   graphics_ {nullptr};
+  Shrapnel                      shrapnel_ {};
   std::vector<glm::vec3>        translations_data_ {};
 };
 
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "config_parser.hpp"
+#include "gpu_timer.hpp"
+#include "opengl.hpp"
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief Headless runs draw every frame into an offscreen target instead of
+ *  the window, so they work with a hidden window and no real display. The
+ *  requested frames are saved as PNG and every frame's render time is recorded.
+ */
+class FrameCapture {
+
+ public:
+
+  /**
+   * @brief Starts timing a frame.
+   */
+  void begin();
+
+  /**
+   * @brief Deletes the OpenGL objects. Call it before the context is destroyed.
+   */
+  void clean();
+
+  /**
+   * @return True when all the requested frames have been rendered.
+   */
+  auto done() const { return frame_ >= config_.frames_; }
+
+  /**
+   * @brief Waits for the GPU to finish the frame, records its render time and
+   *  saves it if it was requested.
+   */
+  void end();
+
+  /**
+   * @return The number of frames rendered so far.
+   */
+  auto frame() const { return frame_; }
+
+  /**
+   * @brief Creates the offscreen target.
+   * @param config The headless options.
+   * @param screen_size The size of the target.
+   */
+  void init(const ConfigParser::HeadlessConfig& config, const SDL_Point& screen_size);
+
+  /**
+   * @return The framebuffer the frame must end up in.
+   */
+  auto output() const { return fbo_.id(); }
+
+  /**
+   * @return The render time of each frame in ms.
+   */
+  const auto& renderTimes() const { return render_times_; }
+
+  /**
+   * @brief Logs a summary of the render times and writes them all to a csv
+   *  file in the output folder, along with the CPU and GPU time of every pass.
+   * @param passes The pass times of every frame, matched by frame number.
+   */
+  void report(const std::vector<RenderPassSample>& passes) const;
+
+ private:
+
+  bool savePNG(const std::string& path) const;
+
+  ConfigParser::HeadlessConfig config_ {};
+  FBO                 fbo_ {};
+  unsigned int        frame_ {};
+  Uint64              frame_start_ {};
+  std::vector<double> render_times_ {}; // ms
+  SDL_Point           screen_size_ {};
+};
+
+} // namespace ktp
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "config_parser.hpp"
+#include <SDL.h>
+#include <array>
+
+namespace ktp {
+
+/**
+ * @brief Holds the frame rate to a target by waiting before every present.
+ *  The wait sleeps while there's plenty of time left, so the core is free for
+ *  other work, and spins the last stretch, b/c a sleep can overshoot by a few
+ *  ms. Also sets the swap interval and measures the frame time jitter.
+ */
+class FramePacer {
+
+ public:
+
+  /**
+   * @return The average time between presents in ms, over the last frames.
+   */
+  auto averageFrameTime() const { return average_; }
+
+  /**
+   * @brief Sets the swap interval and the target from the config. Call it
+   *  after the context is created.
+   * @param config The frame pacing options.
+   * @param headless True to never wait and never sync, so runs go flat out.
+   */
+  void init(const ConfigParser::FramePacingConfig& config, bool headless);
+
+  /**
+   * @return The standard deviation of the time between presents in ms, over
+   *  the last frames.
+   */
+  auto jitter() const { return jitter_; }
+
+  /**
+   * @return The worst distance of a frame time from the average in ms, over
+   *  the last frames.
+   */
+  auto maxDeviation() const { return max_deviation_; }
+
+  /**
+   * @return The frames that took longer than the target plus the tolerance.
+   */
+  auto missedFrames() const { return missed_frames_; }
+
+  /**
+   * @brief Waits until the frame is due and swaps the window.
+   * @param window The window to present.
+   */
+  void present(SDL_Window* window);
+
+  /**
+   * @brief Logs the frame time statistics.
+   */
+  void report() const;
+
+  /**
+   * @return The swap interval in use: 0 off, 1 vsync, -1 adaptive vsync.
+   */
+  auto swapInterval() const { return swap_interval_; }
+
+  /**
+   * @return The target frames per second, 0 for no limit.
+   */
+  auto targetFPS() const { return target_fps_; }
+
+ private:
+
+  void record(Uint64 now);
+  void wait();
+
+  // frames in the statistics window
+  static constexpr std::size_t kSamples_ {120u};
+  // a frame later than the target by this fraction counts as missed
+  static constexpr double      kMissTolerance_ {0.1};
+
+  double                         average_ {};
+  Uint64                         deadline_ {};
+  double                         jitter_ {};
+  Uint64                         last_present_ {};
+  double                         max_deviation_ {};
+  unsigned int                   missed_frames_ {};
+  std::size_t                    sample_ {};
+  std::array<double, kSamples_>  samples_ {};
+  std::size_t                    samples_count_ {};
+  Uint64                         spin_ticks_ {};
+  int                            swap_interval_ {};
+  Uint64                         target_ticks_ {};
+  unsigned int                   target_fps_ {};
+  unsigned long long             total_frames_ {};
+};
+
+} // namespace ktp
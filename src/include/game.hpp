@@ -4,7 +4,12 @@
 #include "camera.hpp"
 #include "config_parser.hpp"
 #include "contact_listener.hpp"
+#include "dynamic_resolution.hpp"
+#include "frame_capture.hpp"
+#include "frame_pacer.hpp"
 #include "game_state.hpp"
+#include "gpu_timer.hpp"
+#include "physics_thread.hpp"
 #include "../kuge/kuge.hpp"
 #include "../sdl2_wrappers/sdl2_wrappers.hpp"
 #include <box2d/box2d.h>
@@ -30,17 +35,49 @@ class Game {
   Game& operator=(const Game& other) = delete;
   Game& operator=(Game&& other) = delete;
 
-  void draw() { state_->draw(*this); }
+  void draw();
+  auto exitCode() const { return exit_code_; }
   void handleEvents() { state_->handleEvents(*this); }
   bool quit() const { return quit_; }
   void reset();
+  bool simulates() const { return state_->simulates(); }
   void update(float delta_time) { state_->update(*this, delta_time); }
 
   static Camera camera_;
 
+  /**
+   * @brief The offscreen target where the scene is drawn.
+   */
+  static DynamicResolution dynamic_resolution_;
+
+  /**
+   * @brief Waits for the target frame rate and presents every frame.
+   */
+  static FramePacer frame_pacer_;
+
   // FPS
   static double frame_time_;
 
+  /**
+   * @brief How far the frame is between the last two ticks, from 0 to 1.
+   */
+  static float interpolation_;
+
+  /**
+   * @brief Counters of the fixed step loop.
+   */
+  struct TickStats {
+    unsigned int catch_up_ticks_ {}; // ticks run after the first one of a frame
+    unsigned int dropped_ticks_ {};  // ticks skipped b/c a frame hit the cap
+    unsigned int max_ticks_ {};      // most ticks run in a single frame
+  };
+  static TickStats tick_stats_;
+
+  /**
+   * @brief CPU and GPU times of every render pass.
+   */
+  static GPUTimer gpu_timer_;
+
   /**
    * @brief This timer only goes when playing or in demo state.
    */
@@ -51,14 +88,29 @@ class Game {
    */
   static b2World b2_world_;
 
+  /**
+   * @brief Counts the pairs the collision layers keep and throw away.
+   */
+  static ContactFilter contact_filter_;
+
+  /**
+   * @brief Steps b2_world_, on its own thread if enabled.
+   */
+  static PhysicsThread physics_thread_;
+
  private:
 
   void clean();
   bool initImgui();
   bool initSDL2();
   bool loadResources();
+  GameState* headlessState();
 
   SDL_Point screen_size_ {ConfigParser::game_config.screen_size_};
+  // headless runs
+  FrameCapture frame_capture_ {};
+  bool headless_ {ConfigParser::headless_config.enabled_};
+  int exit_code_ {0};
   bool paused_ {false};
   bool quit_ {false};
   SDL2_Window main_window_ {};
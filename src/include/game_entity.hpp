@@ -12,10 +12,12 @@
 #include "physics_component.hpp"
 #include "player.hpp"
 #include "projectile.hpp"
-#include <algorithm> // std::find
+#include <array>
+#include <initializer_list>
 #include <map>
 #include <memory>
 #include <utility> // std::move std::exchange
+#include <vector>
 
 namespace ktp {
 
@@ -33,6 +35,7 @@ enum class EntityTypes {
   count
 };
 
+using DrawBuckets   = std::array<std::vector<std::size_t>, static_cast<std::size_t>(EntityTypes::count)>;
 using EntitiesCount = std::map<EntityTypes, std::size_t>;
 using EntitiesPool  = IndexedObjectPool<GameEntity>;
 using Graphics      = std::unique_ptr<GraphicsComponent>;
@@ -80,6 +83,23 @@ class GameEntity {
     entities_count_.clear();
   }
 
+  /**
+   * @brief "Creates" an Aerolite of a given size, so it takes only one shape
+   *  from the cache instead of a random one and then the right one.
+   * @param size The size of the aerolite.
+   * @return A pointer to the newly created GameEntity or nullptr.
+   */
+  static GameEntity* createAerolite(float size) {
+    const auto entity {game_entities_.activate()};
+    if (!entity) return entity;
+    entity->deactivate_ = false;
+    entity->type_ = EntityTypes::Aerolite;
+    entity->graphics_ = std::make_unique<AeroliteGraphicsComponent>();
+    entity->physics_  = std::make_unique<AerolitePhysicsComponent>(entity, static_cast<AeroliteGraphicsComponent*>(entity->graphics_.get()), size);
+    ++entities_count_[entity->type_];
+    return entity;
+  }
+
   /**
    * @brief "Creates" a GameEntity object.
    * @param type The type of GameEntity desired.
@@ -144,6 +164,14 @@ class GameEntity {
    */
   static auto count() { return game_entities_.activeCount(); }
 
+  /**
+   * @brief Use this to get the number of entities of a given type skipped by
+   *  the drawAll() calls of the last frame b/c they were out of view.
+   * @param type The type of entity to look for.
+   * @return The number of culled entities of the type requested.
+   */
+  static auto culledCount(EntityTypes type) { return culled_count_[type]; }
+
   /**
    * @brief Sets the deactivate flag to true.
    */
@@ -158,6 +186,33 @@ class GameEntity {
     if (graphics_) graphics_->update(*this);
   }
 
+  /**
+   * @brief Draws the active GameEntities of the given types whose graphics
+   *  bounds overlap the view. Entities without bounds are always drawn. Culling
+   *  happens before any OpenGL call and the results are added to the per type
+   *  counts. It walks the buckets made by prepareDrawAll(), so call that once
+   *  per frame first.
+   * @param view The visible area of the world in pixels, or nullptr to draw everything.
+   * @param types The types of entity to draw.
+   */
+  static void drawAll(const b2AABB* view, std::initializer_list<EntityTypes> types) {
+    for (const auto type: types) {
+      std::size_t culled {}, visible {};
+      for (const auto index: draw_buckets_[static_cast<std::size_t>(type)]) {
+        const auto& entity {game_entities_[index]};
+        const auto bounds {entity.graphics_->bounds()};
+        if (view && bounds && !b2TestOverlap(*view, *bounds)) {
+          ++culled;
+        } else {
+          entity.draw();
+          ++visible;
+        }
+      }
+      culled_count_[type] += culled;
+      visible_count_[type] += visible;
+    }
+  }
+
   /**
    * @brief Use this to get the number of entities active of a given type.
    * @param type The type of entity to look for.
@@ -201,6 +256,21 @@ class GameEntity {
    */
   auto physics() const { return physics_.get(); }
 
+  /**
+   * @brief Clears the visible and culled counts and sorts the active
+   *  GameEntities with graphics by type, so every drawAll() only walks the
+   *  ones it draws. Call it before the first drawAll() of a frame.
+   */
+  static void prepareDrawAll() {
+    culled_count_.clear();
+    visible_count_.clear();
+    for (auto& bucket: draw_buckets_) bucket.clear();
+    for (auto i = 0u; i <= game_entities_.highestActiveIndex(); ++i) {
+      if (!game_entities_.active(i) || !game_entities_[i].graphics_) continue;
+      draw_buckets_[static_cast<std::size_t>(game_entities_[i].type_)].push_back(i);
+    }
+  }
+
   /**
    * @return The type of the GameEntity.
    */
@@ -215,6 +285,14 @@ class GameEntity {
     if (physics_) physics_->update(*this, delta_time);
   }
 
+  /**
+   * @brief Use this to get the number of entities of a given type drawn by
+   *  the drawAll() calls of the last frame.
+   * @param type The type of entity to look for.
+   * @return The number of visible entities of the type requested.
+   */
+  static auto visibleCount(EntityTypes type) { return visible_count_[type]; }
+
   /**
    * @brief All the GameEntities are in this pool.
    */
@@ -245,7 +323,10 @@ class GameEntity {
   }
 
   // defined in game.cpp
+  static DrawBuckets   draw_buckets_;
+  static EntitiesCount culled_count_;
   static EntitiesCount entities_count_;
+  static EntitiesCount visible_count_;
 
   bool        deactivate_ {false};
   Graphics    graphics_ {nullptr};
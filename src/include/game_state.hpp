@@ -2,6 +2,7 @@
 #define AEROLITS_SRC_INCLUDE_GAME_STATE_HPP_
 
 #include "opengl.hpp"
+#include <memory>
 
 // https://gameprogrammingpatterns.com/state.html
 
@@ -28,9 +29,35 @@ class GameState {
   virtual void handleEvents(Game&) = 0;
   virtual void update(Game&, float) = 0;
 
-  static GameState* goToState(Game& game, GameState& state) { return state.enter(game); }
+  /**
+   * @return True if the state runs at a limited frame rate, so its frame
+   *  times say nothing about the load.
+   */
+  virtual bool idle() const { return false; }
+
+  /**
+   * @return False if update() doesn't move the entities, so there's nothing
+   *  to interpolate between ticks.
+   */
+  virtual bool simulates() const { return true; }
+
+  /**
+   * @brief Waits for the pending Box2D step, since entering a state may touch
+   *  the world, and enters the state.
+   * @param game The game.
+   * @param state The state to enter.
+   * @return The state entered.
+   */
+  static GameState* goToState(Game& game, GameState& state);
+
+  /**
+   * @brief Releases the GL objects the states keep, while there's a context.
+   */
+  static void clean();
 
   static void setDebugDrawFlags(const kuge::B2DebugFlags& debug_flags);
+  static void drawDebug();
+  static void drawEntities();
   static void updateCulling() { culling_ ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE); }
   static void updateDeepTest() { deep_test_ ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST); }
   static void updatePolygonDraw() { polygon_draw_ ? glPolygonMode(GL_FRONT_AND_BACK, GL_LINE) : glPolygonMode(GL_FRONT_AND_BACK, GL_FILL); }
@@ -41,6 +68,7 @@ class GameState {
   static bool debug_draw_;
   static bool deep_test_;
   static bool polygon_draw_;
+  static bool visibility_culling_;
 
   static DemoState    demo_;
   static PausedState  paused_;
@@ -52,6 +80,16 @@ class GameState {
 
   virtual GameState* enter(Game& game) { return this; }
   virtual void handleSDL2KeyEvents(Game&, SDL_Keycode) = 0;
+
+  /**
+   * @brief Sleeps until 1/fps seconds have passed since the last frame. Never
+   *  waits in headless runs.
+   * @param game The game.
+   * @param fps The frames per second, 0 for no limit.
+   * @param last_frame When the last frame started. Updated.
+   */
+  static void limitFrameRate(const Game& game, unsigned int fps, Uint64& last_frame);
+
   SDL_Event sdl_event_ {};
 };
 
@@ -67,16 +105,33 @@ class DemoState: public GameState {
   bool blink_flag_ {true};
 };
 
+/**
+ * @brief Nothing moves while paused, so the scene is drawn once into an
+ *  offscreen copy. The next frames only blit it back and draw the text on top.
+ */
 class PausedState: public GameState {
  public:
+  void clean() { cached_scene_ = FBO{}; screen_vao_.reset(); }
   virtual void draw(Game& game) override;
   virtual void handleEvents(Game& game) override;
+  virtual bool idle() const override { return true; }
+  virtual bool simulates() const override { return false; }
   virtual void update(Game& game, float delta_time) override;
  private:
+  void cacheScene(GLuint output, const SDL_Point& size);
   virtual GameState* enter(Game& game) override;
   void handleSDL2KeyEvents(Game& game, SDL_Keycode key) override;
+  void restoreScene(GLuint output, const SDL_Point& size);
+  static unsigned int sceneKey();
   Uint32 blink_timer_ {};
   bool blink_flag_ {true};
+  FBO          cached_scene_ {};
+  bool         scene_cached_ {false};
+  // no vertices, made with the first restore b/c the state outlives the context
+  std::unique_ptr<VAO> screen_vao_ {};
+  // the debug options the scene was drawn with
+  unsigned int scene_key_ {};
+  Uint64       last_frame_ {};
 };
 
 class PlayingState: public GameState {
@@ -94,6 +149,7 @@ class Testing;
 class TestingState: public GameState {
  public:
   ~TestingState() { delete test_; }
+  void clean();
   virtual void draw(Game& game) override;
   virtual void handleEvents(Game& game) override;
   virtual void update(Game& game, float delta_time) override;
@@ -107,6 +163,7 @@ class TitleState: public GameState {
  public:
   virtual void draw(Game& game) override;
   virtual void handleEvents(Game& game) override;
+  virtual bool idle() const override { return true; }
   virtual void update(Game& game, float delta_time) override;
  private:
   virtual GameState* enter(Game& game) override;
@@ -114,6 +171,7 @@ class TitleState: public GameState {
   static constexpr auto kDefaultBackgroundDeltaInMenu_ {500.f};
   static constexpr Uint32 kWaitForDemo_ {2000};
   Uint32 demo_time_ {};
+  Uint64 last_frame_ {};
 };
 
 } // namespace ktp
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "opengl.hpp"
+#include <SDL.h>
+#include <array>
+#include <vector>
+
+namespace ktp {
+
+enum class RenderPass {
+  Background,
+  Aerolites,
+  Particles,
+  Entities,
+  Debug,
+  Upscale,
+  GUIText,
+  ImGui,
+  count
+};
+
+using RenderPassTimes = std::array<double, static_cast<std::size_t>(RenderPass::count)>;
+
+/**
+ * @brief The times of every pass of one frame, in ms.
+ */
+struct RenderPassSample {
+  unsigned int    frame_ {};
+  RenderPassTimes cpu_ {};
+  RenderPassTimes gpu_ {};
+};
+
+/**
+ * @brief Times every render pass on the CPU and on the GPU. The GPU side uses
+ *  GL_TIME_ELAPSED queries kept in a ring of kFrames_ sets. The results of a
+ *  frame are read when its set comes around again, with kFrames_ - 1 frames
+ *  submitted in between, so they are already there and the CPU never waits.
+ *  Passes can't be nested and each one is timed once per frame.
+ */
+class GPUTimer {
+
+ public:
+
+  /**
+   * @brief Starts timing a pass and opens a debug group named after it.
+   * @param pass The pass about to be drawn.
+   */
+  void begin(RenderPass pass);
+
+  /**
+   * @brief Deletes the queries. Call it before the context is destroyed.
+   */
+  void clean();
+
+  /**
+   * @param pass The pass to look for.
+   * @return The rolling average of the CPU time of the pass in ms.
+   */
+  auto cpuTime(RenderPass pass) const { return cpu_average_[index(pass)]; }
+
+  /**
+   * @brief Stops timing a pass and closes its debug group.
+   * @param pass The pass that was just drawn.
+   */
+  void end(RenderPass pass);
+
+  /**
+   * @brief Waits for all the pending queries and reads them. Only meant for
+   *  the end of a run, b/c it stalls.
+   */
+  void flush();
+
+  /**
+   * @param pass The pass to look for.
+   * @return The rolling average of the GPU time of the pass in ms.
+   */
+  auto gpuTime(RenderPass pass) const { return gpu_average_[index(pass)]; }
+
+  /**
+   * @return Every frame read so far, if recording.
+   */
+  const auto& history() const { return history_; }
+
+  /**
+   * @brief Creates the queries.
+   * @param record_history True to keep the times of every frame, for traces.
+   */
+  void init(bool record_history = false);
+
+  /**
+   * @brief Reads the oldest set of queries and makes it the current one. Call
+   *  it once per frame before any pass.
+   */
+  void newFrame();
+
+  /**
+   * @param pass The pass.
+   * @return A name to show.
+   */
+  static const char* passName(RenderPass pass);
+
+ private:
+
+  static constexpr std::size_t index(RenderPass pass) { return static_cast<std::size_t>(pass); }
+  void read(std::size_t set, bool wait);
+
+  // sets of queries in flight
+  static constexpr std::size_t kFrames_ {3u};
+  static constexpr std::size_t kPasses_ {static_cast<std::size_t>(RenderPass::count)};
+  // weight of the newest frame in the rolling averages
+  static constexpr double      kSmoothing_ {0.05};
+
+  struct QuerySet {
+    std::array<GLuint, kPasses_> ids_ {};
+    std::array<bool, kPasses_>   issued_ {};
+    RenderPassTimes              cpu_ {};
+    unsigned int                 frame_ {};
+  };
+
+  RenderPassTimes               cpu_average_ {};
+  unsigned int                  frame_ {};
+  RenderPassTimes               gpu_average_ {};
+  std::vector<RenderPassSample> history_ {};
+  bool                          initialized_ {false};
+  Uint64                        pass_start_ {};
+  bool                          record_history_ {false};
+  std::size_t                   set_ {};
+  std::array<QuerySet, kFrames_> sets_ {};
+};
+
+} // namespace ktp
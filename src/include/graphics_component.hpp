@@ -1,7 +1,10 @@
 #ifndef AEROLITS_SRC_INCLUDE_GRAPHICS_COMPONENT_HPP_
 #define AEROLITS_SRC_INCLUDE_GRAPHICS_COMPONENT_HPP_
 
+#include "box2d_utils.hpp"
 #include "palette.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath> // std::remainder
 
 namespace ktp {
 
@@ -14,6 +17,87 @@ class GraphicsComponent {
   virtual ~GraphicsComponent() {}
   virtual void update(const GameEntity&) = 0;
 
+  /**
+   * @return A pointer to the world-space bounds of the component in pixels, or
+   *  nullptr if they are unknown and the component must always be drawn.
+   */
+  const b2AABB* bounds() const { return has_bounds_ ? &bounds_ : nullptr; }
+
+  /**
+   * @brief Sets the world-space bounds of what the component draws.
+   * @param bounds The bounds in pixels.
+   */
+  void setBounds(const b2AABB& bounds) {
+    bounds_ = bounds;
+    has_bounds_ = true;
+  }
+
+  /**
+   * @brief Sets what every draw of the frame shares. Call it before drawing.
+   * @param view_projection The camera matrices.
+   * @param interpolation How far the frame is between the last two ticks, 0
+   *  draws the previous one and 1 the last one.
+   */
+  static void setFrame(const glm::mat4& view_projection, float interpolation) {
+    view_projection_ = view_projection;
+    interpolation_ = interpolation;
+  }
+
+  /**
+   * @brief Sets the transform of the last tick. The one before it is kept,
+   *  so the draw can blend both.
+   * @param position The position in pixels.
+   * @param angle The angle in radians.
+   */
+  void setTransform(const glm::vec2& position, float angle) {
+    // Box2D can't move a body farther than this in one step, so it was teleported
+    constexpr auto kMaxTranslation {b2_maxTranslation * kMetersToPixels};
+    const auto moved {position - position_};
+    if (has_transform_ && glm::dot(moved, moved) <= kMaxTranslation * kMaxTranslation) {
+      previous_position_ = position_;
+      previous_angle_ = angle_;
+    } else {
+      previous_position_ = position;
+      previous_angle_ = angle;
+    }
+    position_ = position;
+    angle_ = angle;
+    has_transform_ = true;
+  }
+
+ protected:
+
+  /**
+   * @return The angle blended between the last two ticks, the short way round.
+   */
+  float interpolatedAngle() const {
+    return previous_angle_ + static_cast<float>(std::remainder(angle_ - previous_angle_, 2.f * b2_pi)) * interpolation_;
+  }
+
+  /**
+   * @return The model matrix blended between the last two ticks.
+   */
+  glm::mat4 interpolatedModel() const {
+    const auto model {glm::translate(glm::mat4{1.f}, glm::vec3(interpolatedPosition(), 0.f))};
+    return glm::rotate(model, interpolatedAngle(), glm::vec3(0.f, 0.f, 1.f));
+  }
+
+  /**
+   * @return The position blended between the last two ticks.
+   */
+  glm::vec2 interpolatedPosition() const { return glm::mix(previous_position_, position_, interpolation_); }
+
+  // defined in game.cpp
+  static float     interpolation_;
+  static glm::mat4 view_projection_;
+
+  float     angle_ {};
+  b2AABB    bounds_ {};
+  bool      has_bounds_ {false};
+  bool      has_transform_ {false};
+  glm::vec2 position_ {};
+  float     previous_angle_ {};
+  glm::vec2 previous_position_ {};
 };
 
 } // namespace ktp
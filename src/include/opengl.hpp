@@ -2,6 +2,8 @@
 #define KTP_OPENGL_HPP_
 
 #include <GL/glew.h>
+#include <cstddef> // std::size_t
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -11,10 +13,149 @@ using GLfloatVector = std::vector<GLfloat>;
 using GLuintVector  = std::vector<GLuint>;
 
   /**
-   * @brief Checks for OpenGL errors.
+   * @brief Checks for OpenGL errors. Does nothing while the debug output is on.
    */
   GLenum glCheckError_(const char* file, int line);
-  #define glCheckError() ktp::glCheckError_(__FILE__, __LINE__ - 1)
+  // every check is a sync point, so release builds don't check at all
+  #ifdef NDEBUG
+    #define glCheckError() ((void)0)
+  #else
+    #define glCheckError() ktp::glCheckError_(__FILE__, __LINE__ - 1)
+  #endif
+
+namespace GLDebug {
+
+  /**
+   * @brief Hooks a callback to the KHR_debug output. Needs a debug context.
+   * @param min_severity Messages less severe than this are filtered by the driver.
+   * @return True if the debug output is on.
+   */
+  bool init(GLenum min_severity);
+
+  /**
+   * @return True if the debug output is on.
+   */
+  bool enabled();
+
+  /**
+   * @brief Names an object in the debug messages and in the debuggers. Does
+   *  nothing if the debug output is off.
+   * @param identifier The kind of object: GL_BUFFER, GL_VERTEX_ARRAY, GL_TEXTURE...
+   * @param id The id of the object.
+   * @param name The label.
+   */
+  void label(GLenum identifier, GLuint id, const std::string& name);
+
+  /**
+   * @brief Closes the last group opened with pushGroup().
+   */
+  void popGroup();
+
+  /**
+   * @brief Opens a named group, so the commands until popGroup() show together
+   *  in the debuggers. Does nothing if the debug output is off.
+   * @param name The name of the group.
+   */
+  void pushGroup(const char* name);
+
+  /**
+   * @param severity "high", "medium", "low" or "notification".
+   * @return The matching GL_DEBUG_SEVERITY_*, GL_DEBUG_SEVERITY_MEDIUM if unknown.
+   */
+  GLenum severityFromString(const std::string& severity);
+
+} // namespace GLDebug
+
+/**
+ * @brief Who owns a GL object, to group the GPU memory.
+ */
+enum class MemoryCategory {
+  Aerolites,
+  Entities,
+  Particles,
+  Stars,
+  GUI,
+  Debug,
+  Framebuffers,
+  Other,
+  count
+};
+
+namespace GLMemory {
+
+  /**
+   * @brief Records the size of the data store of an object. Replaces the
+   *  previous size, as glBufferData() and glTexImage2D() do.
+   * @param identifier GL_BUFFER, GL_TEXTURE or GL_RENDERBUFFER.
+   * @param id The id of the object.
+   * @param bytes The new size.
+   */
+  void allocated(GLenum identifier, GLuint id, std::size_t bytes);
+
+  /**
+   * @param category The category.
+   * @return A name to show.
+   */
+  const char* categoryName(MemoryCategory category);
+
+  /**
+   * @brief Starts tracking an object. Its category is Other until labeled.
+   * @param identifier The kind of object: GL_BUFFER, GL_VERTEX_ARRAY, GL_TEXTURE...
+   * @param id The id of the object.
+   */
+  void created(GLenum identifier, GLuint id);
+
+  /**
+   * @brief Stops tracking an object and frees its bytes.
+   * @param identifier The kind of object.
+   * @param id The id of the object.
+   */
+  void deleted(GLenum identifier, GLuint id);
+
+  /**
+   * @brief Names an object in the leak report and moves it to a category.
+   * @param identifier The kind of object.
+   * @param id The id of the object.
+   * @param name The label.
+   * @param category Who owns it.
+   */
+  void label(GLenum identifier, GLuint id, const std::string& name, MemoryCategory category);
+
+  /**
+   * @return The bytes held by all the objects alive.
+   */
+  std::size_t liveBytes();
+
+  /**
+   * @param category The category.
+   * @return The bytes held by the objects alive of a category.
+   */
+  std::size_t liveBytes(MemoryCategory category);
+
+  /**
+   * @return How many objects are alive.
+   */
+  std::size_t liveObjects();
+
+  /**
+   * @return The most bytes ever held at once.
+   */
+  std::size_t peakBytes();
+
+  /**
+   * @param category The category.
+   * @return The most bytes ever held at once by a category.
+   */
+  std::size_t peakBytes(MemoryCategory category);
+
+  /**
+   * @brief Logs every object still alive. Call it when everything should have
+   *  been released.
+   * @return How many objects leaked.
+   */
+  std::size_t reportLeaks();
+
+} // namespace GLMemory
 
   /**
    * @brief Returns the coordinates for a 3D cube build with triangles.
@@ -31,7 +172,7 @@ class ShaderProgram {
  public:
 
   ShaderProgram() = default;
-  ShaderProgram(GLuint id): id_(id) {}
+  ShaderProgram(GLuint id, unsigned int tag = 0u): id_(id), tag_(tag) {}
   /**
    * @return The id of the shader program.
    */
@@ -44,6 +185,12 @@ class ShaderProgram {
    */
   auto getUniformLocation(const char* name) const { return glGetUniformLocation(id_, name); }
 
+  /**
+   * @brief Names the ShaderProgram in the debug output.
+   * @param name The label.
+   */
+  void label(const std::string& name) const { GLDebug::label(GL_PROGRAM, id_, name); }
+
   /**
    * @brief Sets a boolean uniform. Uses glUniform1i()
    * @param name The name of the uniform.
@@ -177,13 +324,38 @@ class ShaderProgram {
   }
 
   /**
-   * @brief Activates the shader.
+   * @brief Forgets the program in use, so the next use() binds it again.
+   *  Call it once per frame.
+   */
+  static void newFrame();
+
+  /**
+   * @return The glUseProgram() calls made since the last newFrame().
+   */
+  static auto programSwitches() { return program_switches_; }
+
+  /**
+   * @return The switches there would have been since the last newFrame() if
+   *  every shader name had a program of its own.
+   */
+  static auto unsharedSwitches() { return unshared_switches_; }
+
+  /**
+   * @brief Activates the shader. Nothing is sent to OpenGL if it is already
+   *  the one in use.
    */
-  void use() const { glUseProgram(id_); }
+  void use() const;
 
  private:
 
-  GLuint id_ {};
+  static GLuint       current_id_;
+  static unsigned int current_tag_;
+  static unsigned int program_switches_;
+  static unsigned int unshared_switches_;
+
+  GLuint       id_ {};
+  // the shader name this program was asked for, 0 if unknown
+  unsigned int tag_ {};
 };
 
 /**
@@ -196,11 +368,11 @@ class VBO {
   VBO();
   VBO(const VBO& other) = delete;
   VBO(VBO&& other) { *this = std::move(other); }
-  ~VBO() { if (id_) glDeleteBuffers(1, &id_); }
+  ~VBO() { destroy(); }
   VBO& operator=(const VBO& other) = delete;
   VBO& operator=(VBO&& other) {
     if (this != &other) {
-      if (id_) glDeleteBuffers(1, &id_);
+      destroy();
       id_ = std::exchange(other.id_, 0);
     }
     return *this;
@@ -211,6 +383,18 @@ class VBO {
    */
   void bind() const { glBindBuffer(GL_ARRAY_BUFFER, id_); }
 
+  /**
+   * @return The id of the VBO.
+   */
+  auto id() const { return id_; }
+
+  /**
+   * @brief Names the VBO in the debug output and in the memory report.
+   * @param name The label.
+   * @param category Who owns it.
+   */
+  void label(const std::string& name, MemoryCategory category = MemoryCategory::Other) const;
+
   /**
    * @brief Sets up the data for the buffer.
    * @param vertices A pointer to an array of floats to use as data.
@@ -230,6 +414,7 @@ class VBO {
   void setup(const T* vertices, GLsizeiptr size, GLenum usage = GL_STATIC_DRAW) {
     glBindBuffer(GL_ARRAY_BUFFER, id_);
     glBufferData(GL_ARRAY_BUFFER, size, vertices, usage);
+    GLMemory::allocated(GL_BUFFER, id_, static_cast<std::size_t>(size));
   }
 
   /**
@@ -242,6 +427,7 @@ class VBO {
   void setup(const std::vector<T>& vertices, GLenum usage = GL_STATIC_DRAW) {
     glBindBuffer(GL_ARRAY_BUFFER, id_);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(T), vertices.data(), usage);
+    GLMemory::allocated(GL_BUFFER, id_, vertices.size() * sizeof(T));
   }
 
   /**
@@ -280,6 +466,8 @@ class VBO {
 
  private:
 
+  void destroy();
+
   GLuint id_ {};
 };
 
@@ -293,28 +481,45 @@ class EBO {
   EBO();
   EBO(const EBO& other) = delete;
   EBO(EBO&& other) { *this = std::move(other); }
-  ~EBO() { if (id_) glDeleteBuffers(1, &id_); }
+  ~EBO() { destroy(); }
   EBO& operator=(const EBO& other) = delete;
   EBO& operator=(EBO&& other) {
     if (this != &other) {
-      if (id_) glDeleteBuffers(1, &id_);
+      destroy();
       id_ = std::exchange(other.id_, 0);
     }
     return *this;
   }
 
   /**
-   * @brief Generates an EBO by removing duplicate coordinates and creating an index array.
-   * @param vertices Vector of vertices.
+   * @brief Generates an EBO by removing duplicate vertices and creating an index array.
+   *  Duplicates are found with a hash table, so it's linear in the vertices.
+   * @param vertices Vector of vertices, interleaved. The duplicates are removed in place.
    * @param indices Vector of indices.
+   * @param stride The floats per vertex, ie: 3 for xyz, 5 for xyz + uv.
+   * @param epsilon 0 to weld only equal vertices, or the size of the grid the
+   *  components are snapped to before comparing them. The first vertex of a
+   *  cell is kept as is.
    */
-  static void generateEBO(GLfloatVector& vertices, GLuintVector& indices);
+  static void generateEBO(GLfloatVector& vertices, GLuintVector& indices, std::size_t stride = 3u, GLfloat epsilon = 0.f);
 
   /**
    * @brief Binds the EBO.
    */
   void bind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id_); }
 
+  /**
+   * @return The id of the EBO.
+   */
+  auto id() const { return id_; }
+
+  /**
+   * @brief Names the EBO in the debug output and in the memory report.
+   * @param name The label.
+   * @param category Who owns it.
+   */
+  void label(const std::string& name, MemoryCategory category = MemoryCategory::Other) const;
+
   /**
    * @brief Sets up the data for the buffer.
    * @param vertices A std::vector of uints to use as data.
@@ -328,6 +533,18 @@ class EBO {
    */
   void setup(const GLuint* indices, GLsizeiptr size, GLenum usage = GL_STATIC_DRAW);
 
+  /**
+   * @brief Sets up the data for the buffer avoiding the cost of reallocating
+   *  the data store.
+   * @param indices A std::vector of uints to use as data.
+   * @param offset The offset into the buffer object's data store where data
+   *  replacement will begin, measured in bytes.
+   */
+  void setupSubData(const GLuintVector& indices, GLintptr offset = 0) {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id_);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, indices.size() * sizeof(GLuint), indices.data());
+  }
+
   /**
    * @brief Unbinds the EBO.
    */
@@ -335,6 +552,8 @@ class EBO {
 
  private:
 
+  void destroy();
+
   GLuint id_ {};
 };
 
@@ -348,11 +567,11 @@ class VAO {
   VAO();
   VAO(const VAO& other) = delete;
   VAO(VAO&& other) { *this = std::move(other); }
-  ~VAO() { if (id_) glDeleteVertexArrays(1, &id_); }
+  ~VAO() { destroy(); }
   VAO& operator=(const VAO& other) = delete;
   VAO& operator=(VAO&& other) {
     if (this != &other) {
-      if (id_) glDeleteVertexArrays(1, &id_);
+      destroy();
       id_ = std::exchange(other.id_, 0);
     }
     return *this;
@@ -363,6 +582,13 @@ class VAO {
    */
   void bind() const { glBindVertexArray(id_); }
 
+  /**
+   * @brief Names the VAO in the debug output and in the leak report.
+   * @param name The label.
+   * @param category Who owns it.
+   */
+  void label(const std::string& name, MemoryCategory category = MemoryCategory::Other) const;
+
   /**
    * @brief Specifies how OpenGL should interpret the vertex buffer data whenever a draw call is made.
    * @param vbo The vertex buffer object to be binded.
@@ -394,37 +620,160 @@ class VAO {
 
  private:
 
+  void destroy();
+
   GLuint id_ {};
 };
 
 /**
- * @brief A texture wrapper.
+ * @brief A RAII framebuffer object wrapper with a color texture and a depth
+ *  renderbuffer attached. A default constructed FBO owns nothing.
+ */
+class FBO {
+
+ public:
+
+  FBO() = default;
+  FBO(GLsizei width, GLsizei height);
+  FBO(const FBO& other) = delete;
+  FBO(FBO&& other) { *this = std::move(other); }
+  ~FBO() { destroy(); }
+  FBO& operator=(const FBO& other) = delete;
+  FBO& operator=(FBO&& other) {
+    if (this != &other) {
+      destroy();
+      id_     = std::exchange(other.id_, 0);
+      color_  = std::exchange(other.color_, 0);
+      depth_  = std::exchange(other.depth_, 0);
+      width_  = std::exchange(other.width_, 0);
+      height_ = std::exchange(other.height_, 0);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Binds the FBO for drawing and reading.
+   */
+  void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, id_); }
+
+  /**
+   * @return The id of the color texture.
+   */
+  auto colorTexture() const { return color_; }
+
+  /**
+   * @return The height in pixels of the attachments.
+   */
+  auto height() const { return height_; }
+
+  /**
+   * @return The id of the FBO.
+   */
+  auto id() const { return id_; }
+
+  /**
+   * @brief Names the FBO and its attachments in the debug output and in the
+   *  memory report.
+   * @param name The label.
+   * @param category Who owns it.
+   */
+  void label(const std::string& name, MemoryCategory category = MemoryCategory::Framebuffers) const;
+
+  /**
+   * @brief Binds the default framebuffer.
+   */
+  void unbind() const { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+  /**
+   * @return The width in pixels of the attachments.
+   */
+  auto width() const { return width_; }
+
+ private:
+
+  void destroy();
+
+  GLuint  id_ {};
+  GLuint  color_ {};
+  GLuint  depth_ {};
+  GLsizei width_ {};
+  GLsizei height_ {};
+};
+
+/**
+ * @brief A RAII texture wrapper. A default constructed Texture2D owns nothing
+ *  until setup() is called.
  */
 class Texture2D {
 
  public:
 
   Texture2D() = default;
-  Texture2D(GLuint id): id_(id) {}
+  Texture2D(const Texture2D& other) = delete;
+  Texture2D(Texture2D&& other) { *this = std::move(other); }
+  ~Texture2D() { destroy(); }
+  Texture2D& operator=(const Texture2D& other) = delete;
+  Texture2D& operator=(Texture2D&& other) {
+    if (this != &other) {
+      destroy();
+      id_     = std::exchange(other.id_, 0);
+      width_  = std::exchange(other.width_, 0);
+      height_ = std::exchange(other.height_, 0);
+    }
+    return *this;
+  }
 
   /**
    * @brief Bind the texture.
    */
   void bind() const { glBindTexture(GL_TEXTURE_2D, id_); }
 
+  /**
+   * @return The height in pixels.
+   */
+  auto height() const { return height_; }
+
+  /**
+   * @return The id of the texture.
+   */
+  auto id() const { return id_; }
+
+  /**
+   * @brief Names the Texture2D in the debug output and in the memory report.
+   * @param name The label.
+   * @param category Who owns it.
+   */
+  void label(const std::string& name, MemoryCategory category = MemoryCategory::Other) const;
+
+  /**
+   * @brief Uploads an image. The texture is created the first time and reused
+   *  after that. It is left bound, so the parameters can be set right away.
+   * @param width The width in pixels.
+   * @param height The height in pixels.
+   * @param internal_format How OpenGL stores it, ie. GL_RGBA.
+   * @param format The format of the pixels given.
+   * @param pixels The image, unsigned bytes.
+   * @param mipmaps True to generate the mipmaps.
+   */
+  void setup(GLsizei width, GLsizei height, GLint internal_format, GLenum format, const void* pixels, bool mipmaps = false);
+
   /**
    * @brief Unbinds the texture.
    */
   void unbind() const { glBindTexture(GL_TEXTURE_2D, 0); }
 
+  /**
+   * @return The width in pixels.
+   */
+  auto width() const { return width_; }
+
  private:
 
-  GLuint id_ {};
-  // GLsizei width_ {}, height_ {};
-  // GLint internal_format_ {GL_RGB};
-  // GLenum image_format_ {GL_RGB};
-  // GLint wrap_s_ {GL_REPEAT}, wrap_t_ {GL_REPEAT};
-  // GLint filter_max_ {GL_LINEAR}, filter_min_ {GL_LINEAR};
+  void destroy();
+
+  GLuint  id_ {};
+  GLsizei width_ {};
+  GLsizei height_ {};
 };
 
 } // namespace ktp
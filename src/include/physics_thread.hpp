@@ -0,0 +1,93 @@
+#pragma once
+
+#include <box2d/box2d.h>
+#include <SDL.h>
+
+namespace ktp {
+
+/**
+ * @brief Runs b2World::Step on a worker thread, overlapped with the draw of
+ *  the frame. A tick updates the entities with the step that was started at
+ *  the end of the previous tick, then starts the next one. The world must not
+ *  be touched from the main thread while a step is pending, so everything that
+ *  does (state changes, spawns, debug draw, resets) calls wait() first. The
+ *  contact listener runs on the worker, but it only sets flags in the physics
+ *  components. The graphics components the draw reads are only written by the
+ *  main thread in the ticks, so they are the snapshot of the last tick, and a
+ *  frame whose step isn't ready() yet is drawn from them without waiting.
+ */
+class PhysicsThread {
+
+ public:
+
+  /**
+   * @brief Starts the step of the next tick. Without a worker it does nothing
+   *  and the step happens in finishStep().
+   * @param delta_time The time to step.
+   * @param velocity_iterations Box2D velocity iterations.
+   * @param position_iterations Box2D position iterations.
+   */
+  void beginStep(float delta_time, int32 velocity_iterations, int32 position_iterations);
+
+  /**
+   * @brief Stops the worker. Call it before the world is cleared.
+   */
+  void clean();
+
+  /**
+   * @brief Waits for the step started in the last tick, or steps now if there
+   *  isn't one.
+   * @param delta_time The time to step.
+   * @param velocity_iterations Box2D velocity iterations.
+   * @param position_iterations Box2D position iterations.
+   */
+  void finishStep(float delta_time, int32 velocity_iterations, int32 position_iterations);
+
+  /**
+   * @brief Starts the worker.
+   * @param world The world to step.
+   * @param threaded False to step on the main thread, as before.
+   */
+  void init(b2World* world, bool threaded);
+
+  /**
+   * @brief Checks the pending step without blocking.
+   * @return True if there's no step running, so a tick won't wait for it.
+   */
+  bool ready();
+
+  /**
+   * @return The time of the last finished step in ms.
+   */
+  auto stepTime() const { return step_time_; }
+
+  /**
+   * @return True if the steps run on the worker.
+   */
+  auto threaded() const { return thread_ != nullptr; }
+
+  /**
+   * @brief Blocks until the pending step, if any, is done.
+   */
+  void wait();
+
+ private:
+
+  static int run(void* data);
+  void step();
+
+  SDL_sem*    done_ {nullptr};
+  float       delta_time_ {};
+  bool        pending_ {false};
+  int32       position_iterations_ {};
+  bool        quit_ {false};
+  SDL_sem*    start_ {nullptr};
+  double      step_time_ {};
+  SDL_Thread* thread_ {nullptr};
+  int32       velocity_iterations_ {};
+  b2World*    world_ {nullptr};
+  // written by the worker, copied to step_time_ once the step is waited for
+  double      worker_step_time_ {};
+};
+
+} // namespace ktp
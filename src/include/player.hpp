@@ -31,7 +31,6 @@ class PlayerGraphicsComponent: public GraphicsComponent {
   VBO vertices_ {};
   EBO vertices_indices_ {};
   ShaderProgram shader_ {Resources::getShader("player")};
-  glm::mat4 mvp_ {};
 };
 
 class DemoInputComponent: public InputComponent {
@@ -72,7 +71,7 @@ class PlayerPhysicsComponent: public PhysicsComponent {
 
   void checkWrap();
   void setBox2D();
-  void updateMVP();
+  void updateTransform();
 
   PlayerGraphicsComponent* graphics_ {nullptr};
   b2Body* body_ {nullptr};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "body_pool.hpp"
 #include "config_parser.hpp"
 #include "graphics_component.hpp"
 #include "physics_component.hpp"
@@ -27,7 +28,6 @@ class ProjectileGraphicsComponent: public GraphicsComponent {
   VBO vertices_ {};
   EBO vertices_indices_ {};
   ShaderProgram shader_ {Resources::getShader("projectile")};
-  glm::mat4 mvp_ {};
 };
 
 class ProjectilePhysicsComponent: public PhysicsComponent {
@@ -37,23 +37,33 @@ class ProjectilePhysicsComponent: public PhysicsComponent {
   ProjectilePhysicsComponent(GameEntity* owner, ProjectileGraphicsComponent* graphics);
   ProjectilePhysicsComponent(const ProjectilePhysicsComponent& other) = delete;
   ProjectilePhysicsComponent(ProjectilePhysicsComponent&& other) { *this = std::move(other); }
-  ~ProjectilePhysicsComponent() { if (body_) world_->DestroyBody(body_); }
+  ~ProjectilePhysicsComponent() { BodyPool::release(BodyArchetype::Projectile, body_); }
 
   ProjectilePhysicsComponent& operator=(const ProjectilePhysicsComponent& other) = delete;
   ProjectilePhysicsComponent& operator=(ProjectilePhysicsComponent&& other);
 
-  auto body() { return body_; }
   void collide(const GameEntity* other) override { collided_ = true; }
   void detonate();
+  void setTransform(const b2Vec2& position, float angle);
+  void setVelocity(const b2Vec2& velocity);
   auto speed() const { return speed_; }
   virtual void update(const GameEntity& projectile, float delta_time) override;
 
  private:
 
+  /**
+   * @brief Moves a ray cast projectile one tick and finds what it hits, like
+   *  a step would do with its body.
+   * @param delta_time The time to move.
+   */
+  void advance(float delta_time);
+  float currentAngle() const { return body_ ? body_->GetAngle() : angle_; }
+  b2Vec2 currentPosition() const { return body_ ? body_->GetPosition() : position_; }
   inline bool isOutOfScreen(float threshold = 0.f);
   void setBox2D();
-  void updateMVP();
+  void updateTransform();
 
+  float angle_ {};
   bool armed_ {false};
   unsigned int arm_time_ {ConfigParser::projectiles_config.arm_time_};
   b2Body* body_ {nullptr};
@@ -62,8 +72,12 @@ class ProjectilePhysicsComponent: public PhysicsComponent {
   ExplosionPhysicsComponent* explosion_ {nullptr};
   unsigned int fired_time_ {};
   ProjectileGraphicsComponent* graphics_ {nullptr};
+  float mass_ {};
+  b2Vec2 position_ {0.f, 0.f};
+  bool ray_cast_ {ConfigParser::projectiles_config.ray_cast_};
   float speed_ {ConfigParser::projectiles_config.speed_};
   float sin_ {}, cos_ {};
+  b2Vec2 velocity_ {0.f, 0.f};
 };
 
 } // namespace ktp
@@ -2,24 +2,75 @@
 
 #include "opengl.hpp"
 #include "../sdl2_wrappers/sdl2_font.hpp"
+#include <glm/glm.hpp>
+#include <array>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace ktp { namespace Resources {
 
-using FontsMap    = std::map<std::string, SDL2_Font>;
-using ShadersMap  = std::map<std::string, GLuint>;
-using TexturesMap = std::map<std::string, GLuint>;
+/**
+ * @brief A glyph inside a GlyphAtlas. All the measures are in atlas pixels.
+ */
+struct Glyph {
+  // Texture coords: {u0, v0, u1, v1}, v0 being the top.
+  glm::vec4 uv_ {};
+  // Width and height of the glyph's cell.
+  glm::vec2 size_ {};
+  // How much the pen moves after this glyph. 0 means not present in the atlas.
+  float advance_ {};
+};
 
-extern FontsMap    fonts_map;
-extern ShadersMap  shaders_map;
-extern TexturesMap textures_map;
+/**
+ * @brief Every glyph of a font (Latin-1) rendered once into a single texture.
+ */
+struct GlyphAtlas {
+  std::array<Glyph, 256> glyphs_ {};
+  float line_height_ {};
+  Texture2D texture_ {};
+};
+
+using FontsMap        = std::map<std::string, SDL2_Font>;
+using GlyphAtlasesMap = std::map<std::string, GlyphAtlas>;
+using ShaderDefines   = std::vector<std::string>;
+using ShadersMap      = std::map<std::string, GLuint>;
+using ShaderTagsMap   = std::map<std::string, unsigned int>;
+using TexturesMap     = std::map<std::string, Texture2D>;
+
+extern FontsMap        fonts_map;
+extern GlyphAtlasesMap glyph_atlases_map;
+extern ShadersMap      shaders_map;
+/**
+ * @brief One tag per shader name loaded, starting at 1. Names sharing a
+ *  program still have their own tag, to count what sharing saves.
+ */
+extern ShaderTagsMap   shader_tags;
+extern TexturesMap     textures_map;
+
+/**
+ * @brief Where linked shader programs are cached as binaries. Empty to
+ *  always compile them from source.
+ */
+extern std::string  shader_cache_path;
+/**
+ * @brief Shader programs loaded from the binary cache and from source.
+ */
+extern unsigned int shader_cache_hits;
+extern unsigned int shader_cache_misses;
 
 /**
  * @brief Deletes the OpenGL resources.
  */
 void cleanOpenGL();
 
+/**
+ * @brief Gets the path to the cache directory. It may not exist yet.
+ * @param sub_dir Specify a sub directory, ie. shaders.
+ * @return The full path to the cache directory (and subdirectory if instructed).
+ */
+std::string getCachePath(const std::string& sub_dir = "");
+
 /**
  * @brief Gets the path to the config directory.
  * @param sub_dir Specify a sub directory.
@@ -51,6 +102,24 @@ inline auto getFont(const std::string name) { return fonts_map.at(name).font();
  */
 void loadFont(const std::string& name, const std::string& file, int size);
 
+/* GLYPH ATLASES */
+
+/**
+ * @brief Retrieves a glyph atlas by name.
+ * @param name The name of the atlas.
+ * @return A reference to the atlas requested.
+ */
+inline const auto& getGlyphAtlas(const std::string& name) { return glyph_atlases_map.at(name); }
+
+/**
+ * @brief Renders all the Latin-1 glyphs of a loaded font into one texture,
+ *  owned by the atlas.
+ * @param name The name you want to give to the atlas.
+ * @param font The name of an already loaded font.
+ * @return True on success, or false on errors.
+ */
+bool loadGlyphAtlas(const std::string& name, const std::string& font);
+
 /* SHADERS */
 
 /**
@@ -58,16 +127,21 @@ void loadFont(const std::string& name, const std::string& file, int size);
  * @param name The name of the shader you want.
  * @return A ShaderProgram with the shader requested.
  */
-inline auto getShader(const std::string& name) { return ShaderProgram{shaders_map.at(name)}; }
+inline auto getShader(const std::string& name) { return ShaderProgram{shaders_map.at(name), shader_tags.at(name)}; }
 
 /**
- * @brief Loads and compiles a shader program.
+ * @brief Loads and compiles a shader program. If there's a binary in the cache
+ *  for the same sources and the same driver it is used instead, otherwise the
+ *  program is compiled and the binary stored for the next time.
+ *  The defines pick a permutation of an über shader. Asking again for the same
+ *  files and defines under another name shares the program already linked.
  * @param name The name you wan to give to the shader program.
  * @param vertex_shader_path Vertex shader file path.
  * @param fragment_shader_path Fragment shader file path.
+ * @param defines Added as #define lines after #version, in every stage.
  * @param geometry_shader_path Geometry shader file path.
  */
-bool loadShader(const std::string& name, const std::string& vertex_shader_path, const std::string& fragment_shader_path, const std::string& geometry_shader_path = "");
+bool loadShader(const std::string& name, const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines = {}, const std::string& geometry_shader_path = "");
 
 /**
  * @brief Prints any problems with the shader program. If any...
@@ -102,36 +176,39 @@ inline int pow2RoundUp(int x) {
 /**
  * @brief Retrieves a texture by name.
  * @param name The name of the texture.
- * @return A Texture2D object with the requested texture.
+ * @return The requested texture. It lives until cleanOpenGL().
  */
-inline auto getTexture(const std::string& name) { return Texture2D{textures_map.at(name)}; }
+inline const auto& getTexture(const std::string& name) { return textures_map.at(name); }
 
 /**
  * @brief Image file to opengl texture loader. Use with caution.
  * @param name The name you want for the texture. Don't forget it!
  * @param file The full path to the image file.
  * @param alpha Alpha channel?
+ * @param category Who uses it, for the memory report.
  */
-void loadTexture(const std::string& name, const std::string& file, bool alpha = false);
+void loadTexture(const std::string& name, const std::string& file, bool alpha = false, MemoryCategory category = MemoryCategory::Other);
 
 /**
  * @brief Tries to create textures with text. Blended in this case, which may be slow.
+ *  A texture with the same name is reused, not recreated.
  * @param name The name of the texture for the textures map.
  * @param text The desired text to display.
  * @param font The font to use.
  * @param color The color desired.
- * @return Texture2D
+ * @return The texture, empty on errors.
  */
-Texture2D loadTextureFromTextBlended(const std::string& name, const std::string& text, const std::string& font, SDL_Color color);
+const Texture2D& loadTextureFromTextBlended(const std::string& name, const std::string& text, const std::string& font, SDL_Color color);
 
 /**
  * @brief Tries to create textures with text. Solid in this case, which should be fast.
+ *  A texture with the same name is reused, not recreated.
  * @param name The name of the texture for the textures map.
  * @param text The desired text to display.
  * @param font The font to use.
  * @param color The color desired.
- * @return Texture2D
+ * @return The texture, empty on errors.
  */
-Texture2D loadTextureFromTextSolid(const std::string& name, const std::string& text, const std::string& font, SDL_Color color);
+const Texture2D& loadTextureFromTextSolid(const std::string& name, const std::string& text, const std::string& font, SDL_Color color);
 
 } } // namespace resources / ktp
@@ -1,35 +1,181 @@
 #pragma once
 
 #include "camera.hpp"
+#include "config_parser.hpp"
 #include "opengl.hpp"
 #include "../sdl2_wrappers/sdl2_geometry.hpp"
+#include <box2d/box2d.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <array>
+#include <string>
 #include <vector>
 
 namespace ktp {
 
+class DebugDraw;
+class EmitterPhysicsComponent;
+
+enum class BenchmarkScenario {
+  Aerolites,
+  Cubes,
+  DebugDraw,
+  Particles,
+  Projectiles,
+  Stars,
+  count
+};
+
+enum class BenchmarkPass {
+  Update,
+  Scene,
+  Debug,
+  Present,
+  count
+};
+
+using PassTimes = std::array<double, static_cast<std::size_t>(BenchmarkPass::count)>;
+
+/**
+ * @brief A render benchmark. Keeps a load of the chosen scenario alive and
+ *  measures the frame and pass times. In ramp mode the load keeps growing
+ *  until the frame time passes the threshold, then the last load that held
+ *  is reported. Box2D isn't stepped, so the load stays the same every frame.
+ */
 class Testing {
  public:
 
+  /**
+   * @brief Starts timing a new frame. Call it before anything gets drawn.
+   */
+  void beginFrame();
+
   void draw();
+
+  /**
+   * @brief Queues the debug draw primitives of the scenario, if any.
+   * @param debug_draw Where to queue them.
+   */
+  void drawDebug(DebugDraw& debug_draw) const;
+
+  /**
+   * @return True if the scenario needs the debug draw flushed.
+   */
+  auto drawsDebug() const { return scenario_ == BenchmarkScenario::DebugDraw; }
+
+  /**
+   * @brief Feeds the frame into the measures and the ramp.
+   */
+  void endFrame();
+
+  /**
+   * @return 0 if the benchmark held the threshold (and the expected count in
+   *  ramp mode), 1 otherwise.
+   */
+  auto exitCode() const { return exit_code_; }
+
+  /**
+   * @return True when a scripted benchmark has its result.
+   */
+  auto finished() const { return finished_; }
+
   void init();
+
+  /**
+   * @brief Waits for the GPU and adds the time since the last mark to a pass.
+   * @param pass The pass that just ended.
+   */
+  void markPass(BenchmarkPass pass);
+
+  /**
+   * @brief Adds time to a pass without waiting for the GPU.
+   * @param pass The pass.
+   * @param ms The time to add.
+   */
+  void addPassTime(BenchmarkPass pass, double ms) { frame_passes_[static_cast<std::size_t>(pass)] += ms; }
+
+  /**
+   * @brief Changes the load. Lowering it needs the entities cleared first.
+   * @param count The new load.
+   */
+  void setCount(unsigned int count);
+
+  /**
+   * @brief Changes the scenario. The entities must be cleared first.
+   * @param scenario The new scenario.
+   */
+  void setScenario(BenchmarkScenario scenario);
+
+  /**
+   * @brief Turns the ramp mode on or off. Measures start again.
+   */
+  void toggleRamp();
+
   void update(float delta_time);
   void updateMouse(float x_pos, float y_pos) { camera_.look(x_pos, -y_pos); }
   void updateZoom(float y_offset) { camera_.zoom(y_offset); }
 
+  auto count() const { return count_; }
+  auto rampStep() const { return config_.ramp_step_; }
+  auto scenario() const { return scenario_; }
+
+  static BenchmarkScenario scenarioFromString(const std::string& name);
+  static std::string scenarioToString(BenchmarkScenario scenario);
+
  private:
 
+  struct DebugPrimitive {
+    b2Vec2  position_ {};
+    b2Vec2  end_ {};
+    float   radius_ {};
+    b2Color color_ {};
+  };
+
+  bool freeEntities(unsigned int needed);
+  void generateCubes();
+  void generateDebugPrimitives();
+  void generateEmitterType();
+  unsigned int load() const;
+  void report(double frame_time, const PassTimes& passes) const;
+  void resetMeasures();
   void updateCamera(float delta_time);
+  void updateLoad();
   void updateMVP();
 
-  static constexpr int kNumCubes_ {1000};
+  // frames skipped after every load change
+  static constexpr unsigned kWarmupFrames_ {20u};
+  // frames averaged for every measure
+  static constexpr unsigned kSampleFrames_ {60u};
 
-  VAO vao_ {};
-  VBO vertices_ {};
-  VBO colors_ {};
-  VBO translations_ {};
+  ConfigParser::BenchmarkConfig config_ {ConfigParser::benchmark_config};
+  unsigned int      count_ {};
+  BenchmarkScenario scenario_ {BenchmarkScenario::Cubes};
+  bool              ramp_ {false};
+  // measures
+  int               exit_code_ {0};
+  bool              finished_ {false};
+  Uint64            frame_start_ {};
+  PassTimes         frame_passes_ {};
+  bool              limited_ {false};
+  Uint64            pass_start_ {};
+  unsigned int      sampled_frames_ {};
+  double            sampled_frame_time_ {};
+  PassTimes         sampled_passes_ {};
+  unsigned int      sustained_count_ {};
+  double            sustained_frame_time_ {};
+  PassTimes         sustained_passes_ {};
+  unsigned int      window_frames_ {};
+  // scenarios
+  std::vector<DebugPrimitive>           debug_primitives_ {};
+  std::vector<EmitterPhysicsComponent*> emitters_ {};
+  unsigned int                          stars_ {};
+  // cubes
+  GLsizei       cubes_count_ {};
+  VAO           vao_ {};
+  VBO           vertices_ {};
+  VBO           colors_ {};
+  VBO           translations_ {};
   GLfloatVector vertices_data_ {};
   ShaderProgram shader_program_ {};
 
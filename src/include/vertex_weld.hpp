@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm> // std::copy_n
+#include <cmath>     // std::llround
+#include <cstdint>
+#include <cstring>   // std::memcpy
+#include <vector>
+
+namespace ktp {
+
+/**
+ * @brief The value a vertex component is compared by when welding. With an
+ *  epsilon it's the grid cell, without it the exact bits, with -0 as 0.
+ * @param value The component.
+ * @param inverse_epsilon 1 / epsilon, or 0 for the exact bits.
+ * @return The key.
+ */
+inline std::int64_t weldKey(float value, float inverse_epsilon) {
+  if (inverse_epsilon > 0.f) return std::llround(value * inverse_epsilon);
+  value += 0.f;
+  std::uint32_t bits {};
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+/**
+ * @brief Removes the duplicate vertices and makes the indices to draw the
+ *  originals with. Duplicates are found with a hash table, so it's linear in
+ *  the vertices, and the unique ones keep their order.
+ * @param vertices Vector of vertices, interleaved. The duplicates are removed in place.
+ * @param indices Vector of indices.
+ * @param stride The floats per vertex, ie: 3 for xyz, 5 for xyz + uv.
+ * @param epsilon 0 to weld only equal vertices, or the size of the grid the
+ *  components are snapped to before comparing them. The first vertex of a
+ *  cell is kept as is.
+ */
+inline void weldVertices(std::vector<float>& vertices, std::vector<unsigned int>& indices, std::size_t stride, float epsilon) {
+  // reused between welds, one per thread so a worker can weld too
+  thread_local std::vector<unsigned int> weld_table {};
+
+  indices.clear();
+  if (stride == 0u) return;
+  const auto count {vertices.size() / stride};
+  indices.reserve(count);
+  // open addressing, never more than half full
+  std::size_t capacity {16u};
+  while (capacity < count * 2u) capacity <<= 1u;
+  weld_table.assign(capacity, 0u);
+  const auto mask {capacity - 1u};
+  const float inverse_epsilon {epsilon > 0.f ? 1.f / epsilon : 0.f};
+
+  std::size_t unique {};
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto vertex {vertices.begin() + static_cast<std::ptrdiff_t>(i * stride)};
+    std::uint64_t hash {14695981039346656037ull};
+    for (std::size_t c = 0; c < stride; ++c) {
+      hash = (hash ^ static_cast<std::uint64_t>(weldKey(vertex[c], inverse_epsilon))) * 1099511628211ull;
+    }
+    auto slot {static_cast<std::size_t>(hash ^ (hash >> 32u)) & mask};
+    // the table holds the unique index + 1, 0 is empty
+    for (; weld_table[slot] != 0u; slot = (slot + 1u) & mask) {
+      const auto other {vertices.begin() + static_cast<std::ptrdiff_t>((weld_table[slot] - 1u) * stride)};
+      std::size_t c {};
+      while (c < stride && weldKey(vertex[c], inverse_epsilon) == weldKey(other[c], inverse_epsilon)) ++c;
+      if (c == stride) break;
+    }
+    if (weld_table[slot] == 0u) {
+      // new unique vertex, moved down in place
+      if (unique != i) std::copy_n(vertex, stride, vertices.begin() + static_cast<std::ptrdiff_t>(unique * stride));
+      weld_table[slot] = static_cast<unsigned int>(++unique);
+    }
+    indices.push_back(weld_table[slot] - 1u);
+  }
+  // the new vertices
+  vertices.resize(unique * stride);
+}
+
+} // namespace ktp
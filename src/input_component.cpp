@@ -14,13 +14,13 @@ void ktp::InputComponent::shoot(GameEntity& player) {
     const auto sin {SDL_sinf(physics_->body_->GetAngle())};
     const auto cos {SDL_cosf(physics_->body_->GetAngle())};
 
-    projectile_phy->body()->SetTransform({
+    projectile_phy->setTransform({
       physics_->body_->GetPosition().x - projectile_phy->size() * 5.2f * sin,
       physics_->body_->GetPosition().y + projectile_phy->size() * 5.2f * cos},
       physics_->body_->GetAngle() - b2_pi
     );
 
-    projectile_phy->body()->SetLinearVelocity({
+    projectile_phy->setVelocity({
       -projectile_phy->speed() * sin * 30,
        projectile_phy->speed() * cos * 30
     });
@@ -1,4 +1,5 @@
 #include "backend_system.hpp"
+#include "../include/body_pool.hpp"
 #include "../include/game.hpp"
 #include "../include/game_entity.hpp"
 #include "../include/game_state.hpp"
@@ -9,6 +10,7 @@
 #include "algorithm" // std::copy
 
 void kuge::BackendSystem::draw() {
+  ktp::Game::gpu_timer_.begin(ktp::RenderPass::ImGui);
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplSDL2_NewFrame();
   ImGui::NewFrame();
@@ -19,6 +21,7 @@ void kuge::BackendSystem::draw() {
 
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  ktp::Game::gpu_timer_.end(ktp::RenderPass::ImGui);
 }
 
 void kuge::BackendSystem::mainMenuBar() {
@@ -39,6 +42,7 @@ void kuge::BackendSystem::mainMenuBar() {
       if (ImGui::Checkbox("Polygon mode", &ktp::GameState::polygon_draw_)) {
         ktp::GameState::updatePolygonDraw();
       }
+      ImGui::Checkbox("Visibility culling", &ktp::GameState::visibility_culling_);
       ImGui::EndMenu();
     }
 
@@ -78,6 +82,7 @@ void kuge::BackendSystem::resetStatistics() {
   max_frame_time_ = 0.f;
   min_frame_time_ = std::numeric_limits<double>::max();
   for (auto& time: frame_times_) time = 0.f;
+  ktp::Game::tick_stats_ = {};
 }
 
 void kuge::BackendSystem::statisticsWindow(bool* show) {
@@ -131,6 +136,14 @@ void kuge::BackendSystem::statisticsWindow(bool* show) {
     }
     // plot the result
     ImGui::PlotLines("", frame_times_.data(), kFrameBufferSize_);
+    // frame pacing
+    const auto& pacer {ktp::Game::frame_pacer_};
+    const auto swap_interval {pacer.swapInterval()};
+    ImGui::Text("Pacing: %u fps target, %s", pacer.targetFPS(), swap_interval == -1 ? "adaptive vsync" : swap_interval == 1 ? "vsync" : "no vsync");
+    ImGui::Text("Jitter: %.3fms. Max deviation: %.3fms. Missed: %u", pacer.jitter(), pacer.maxDeviation(), pacer.missedFrames());
+    // fixed step
+    const auto& ticks {ktp::Game::tick_stats_};
+    ImGui::Text("Ticks: %u Hz. Catch-up: %u. Dropped: %u. Max per frame: %u", ktp::ConfigParser::game_config.fixed_step_.tick_rate_, ticks.catch_up_ticks_, ticks.dropped_ticks_, ticks.max_ticks_);
     // and a button to reset them
     if (ImGui::Button("Reset")) resetStatistics();
     // mouse coordinates
@@ -140,7 +153,18 @@ void kuge::BackendSystem::statisticsWindow(bool* show) {
       ImGui::Text("Mouse Position: <invalid>");
     ImGui::Separator();
     // Box2D bodies
-    ImGui::Text("B2Bodies: %i", ktp::Game::b2_world_.GetBodyCount());
+    // the parked ones are in the world, but not in the game
+    ImGui::Text("B2Bodies: %i", ktp::Game::b2_world_.GetBodyCount() - static_cast<int>(ktp::BodyPool::parked()));
+    ImGui::Text("B2 step: %.3fms%s", ktp::Game::physics_thread_.stepTime(), ktp::Game::physics_thread_.threaded() ? " (threaded)" : "");
+    const auto& pairs {ktp::Game::contact_filter_.lastStep()};
+    // the world may be stepping on the worker right now, so the contacts are the ones counted after the last step
+    ImGui::Text("B2 pairs: %i contacts. Last step: %u new, %u filtered", pairs.contacts_, pairs.accepted_, pairs.filtered_);
+    const auto& bodies {ktp::BodyPool::lastFrame()};
+    ImGui::Text("Frame bodies: %u created, %u destroyed, %u reused, %u parked", bodies.created_, bodies.destroyed_, bodies.reused_, bodies.parked_);
+    ImGui::Text("Parked: %i aerolites, %i rays, %i projectiles",
+      static_cast<int>(ktp::BodyPool::parked(ktp::BodyArchetype::Aerolite)),
+      static_cast<int>(ktp::BodyPool::parked(ktp::BodyArchetype::ExplosionRay)),
+      static_cast<int>(ktp::BodyPool::parked(ktp::BodyArchetype::Projectile)));
     ImGui::Separator();
     // GameEntities
     ImGui::Text("Entities\t%i/%i", ktp::GameEntity::count(), ktp::GameEntity::game_entities_.capacity());
@@ -152,6 +176,49 @@ void kuge::BackendSystem::statisticsWindow(bool* show) {
     ImGui::Text("Projectile:      %i",  ktp::GameEntity::entitiesCount(ktp::EntityTypes::Projectile));
     ImGui::Text("Emitter:         %i",  ktp::GameEntity::entitiesCount(ktp::EntityTypes::Emitter));
     ImGui::Text("Explosion:       %i",  ktp::GameEntity::entitiesCount(ktp::EntityTypes::Explosion));
+    ImGui::Separator();
+    // Rendering
+    if (ktp::Game::dynamic_resolution_.enabled()) {
+      ImGui::Text("Render scale: %.2f", ktp::Game::dynamic_resolution_.scale());
+    } else {
+      ImGui::Text("Render scale: native");
+    }
+    ImGui::Text("Aerolite draw calls: %i", ktp::AeroliteMeshArena::drawCalls());
+    ImGui::Text("Aerolite templates: %u ready, %u hits, %u misses", ktp::AeroliteShapeCache::ready(), ktp::AeroliteShapeCache::hits(), ktp::AeroliteShapeCache::misses());
+    ImGui::Text("Program switches: %u (%u without shared programs)", ktp::ShaderProgram::programSwitches(), ktp::ShaderProgram::unsharedSwitches());
+    // visible/culled per type
+    const auto culling_text = [](const char* label, std::size_t visible, std::size_t culled) {
+      ImGui::Text("%s%i/%i", label, static_cast<int>(visible), static_cast<int>(culled));
+    };
+    const auto type_culling_text = [&culling_text](const char* label, ktp::EntityTypes type) {
+      culling_text(label, ktp::GameEntity::visibleCount(type), ktp::GameEntity::culledCount(type));
+    };
+    ImGui::Text("Visible/culled");
+    culling_text("Player:          ",
+      ktp::GameEntity::visibleCount(ktp::EntityTypes::Player) + ktp::GameEntity::visibleCount(ktp::EntityTypes::PlayerDemo),
+      ktp::GameEntity::culledCount(ktp::EntityTypes::Player) + ktp::GameEntity::culledCount(ktp::EntityTypes::PlayerDemo));
+    type_culling_text("Aerolite:        ", ktp::EntityTypes::Aerolite);
+    type_culling_text("Arrow:           ", ktp::EntityTypes::AeroliteArrow);
+    type_culling_text("Projectile:      ", ktp::EntityTypes::Projectile);
+    type_culling_text("Emitter:         ", ktp::EntityTypes::Emitter);
+    type_culling_text("Explosion:       ", ktp::EntityTypes::Explosion);
+    ImGui::Separator();
+    // pass times, the GPU ones come from timer queries a few frames late
+    ImGui::Text("Pass            CPU ms   GPU ms");
+    for (std::size_t i = 0; i < static_cast<std::size_t>(ktp::RenderPass::count); ++i) {
+      const auto pass {static_cast<ktp::RenderPass>(i)};
+      ImGui::Text("%-15s %6.3f   %6.3f", ktp::GPUTimer::passName(pass), ktp::Game::gpu_timer_.cpuTime(pass), ktp::Game::gpu_timer_.gpuTime(pass));
+    }
+    ImGui::Separator();
+    // GPU memory held through the GL wrappers, estimated from the sizes asked
+    constexpr auto kKiB {1024.0};
+    ImGui::Text("GPU memory      live KiB peak KiB");
+    for (std::size_t i = 0; i < static_cast<std::size_t>(ktp::MemoryCategory::count); ++i) {
+      const auto category {static_cast<ktp::MemoryCategory>(i)};
+      ImGui::Text("%-15s %8.1f %8.1f", ktp::GLMemory::categoryName(category), ktp::GLMemory::liveBytes(category) / kKiB, ktp::GLMemory::peakBytes(category) / kKiB);
+    }
+    ImGui::Text("%-15s %8.1f %8.1f", "Total", ktp::GLMemory::liveBytes() / kKiB, ktp::GLMemory::peakBytes() / kKiB);
+    ImGui::Text("GL objects: %i", static_cast<int>(ktp::GLMemory::liveObjects()));
     // pop-up window for position
     if (ImGui::BeginPopupContextWindow()) {
       if (ImGui::MenuItem("Custom",       nullptr, corner == -1)) corner = -1;
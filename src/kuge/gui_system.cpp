@@ -1,29 +1,107 @@
 #include "event.hpp"
 #include "gui_system.hpp"
+#include "../include/config_parser.hpp"
 #include "../include/resources.hpp"
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
 
 kuge::GUIStringImpl::GUIStringImpl(const GUIStringConfig& config) {
   config_ = config;
-  texture_ = ktp::Resources::loadTextureFromTextBlended(config_.name_, config_.text_, config_.font_, ktp::Palette::colorToSDL2Color(config_.color_));
+  texture_ = &ktp::Resources::getGlyphAtlas(config_.font_).texture_;
   shader_ = ktp::Resources::getShader(config_.shader_);
+  // {x, y, z, u, v}
+  vao_.linkAttrib(vbo_, 0, 3, GL_FLOAT, 5 * sizeof(GLfloat), nullptr);
+  vao_.linkAttrib(vbo_, 1, 2, GL_FLOAT, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+  ebo_.bind();
+  vao_.label("GUI " + config_.text_, ktp::MemoryCategory::GUI);
+  vbo_.label("GUI " + config_.text_ + " vertices", ktp::MemoryCategory::GUI);
+  ebo_.label("GUI " + config_.text_ + " indices", ktp::MemoryCategory::GUI);
+}
+
+void kuge::GUIStringImpl::buildMesh() {
+  const auto& atlas {ktp::Resources::getGlyphAtlas(config_.font_)};
+  // decode the UTF-8 text, anything out of Latin-1 becomes '?'
+  std::vector<Uint8> chars {};
+  chars.reserve(config_.text_.size());
+  for (std::size_t i = 0; i < config_.text_.size(); ++i) {
+    const auto c {static_cast<unsigned char>(config_.text_[i])};
+    if (c < 0x80u) {
+      chars.push_back(c);
+    } else if ((c & 0xE0u) == 0xC0u && i + 1 < config_.text_.size()) {
+      const auto code_point {((c & 0x1Fu) << 6u) | (static_cast<unsigned char>(config_.text_[++i]) & 0x3Fu)};
+      chars.push_back(code_point < 256u ? static_cast<Uint8>(code_point) : '?');
+    } else if ((c & 0xC0u) != 0x80u) {
+      // first byte of a 3 or 4 bytes sequence
+      chars.push_back('?');
+    }
+  }
+  // the text is as tall as the box and only gets compressed if it's too wide
+  const auto screen {ktp::ConfigParser::game_config.screen_size_};
+  const auto box_width_px  {config_.box_.w * 0.5f * screen.x};
+  const auto box_height_px {config_.box_.h * 0.5f * screen.y};
+  float text_width {};
+  for (const auto ch: chars) text_width += atlas.glyphs_[ch].advance_;
+  const auto scale_y {box_height_px / atlas.line_height_};
+  auto scale_x {scale_y};
+  if (text_width * scale_x > box_width_px) scale_x = box_width_px / text_width;
+  const auto to_ndc_x {2.f / screen.x};
+  const auto to_ndc_y {2.f / screen.y};
+  auto pen_x {config_.box_.x + (config_.box_.w - text_width * scale_x * to_ndc_x) * 0.5f};
+  // one quad per glyph
+  vertices_data_.clear();
+  indices_data_.clear();
+  GLuint quad {0};
+  for (const auto ch: chars) {
+    const auto& glyph {atlas.glyphs_[ch]};
+    if (glyph.advance_ == 0.f) continue;
+    const auto left   {pen_x};
+    const auto right  {pen_x + glyph.size_.x * scale_x * to_ndc_x};
+    const auto bottom {config_.box_.y};
+    const auto top    {config_.box_.y + glyph.size_.y * scale_y * to_ndc_y};
+    vertices_data_.insert(vertices_data_.end(), {
+      right, top,    0.f, glyph.uv_.z, glyph.uv_.y, // top right
+      right, bottom, 0.f, glyph.uv_.z, glyph.uv_.w, // bottom right
+      left,  bottom, 0.f, glyph.uv_.x, glyph.uv_.w, // bottom left
+      left,  top,    0.f, glyph.uv_.x, glyph.uv_.y  // top left
+    });
+    const auto base {quad * 4u};
+    indices_data_.insert(indices_data_.end(), {
+      base + 0u, base + 3u, base + 1u, // first triangle
+      base + 3u, base + 2u, base + 1u  // second triangle
+    });
+    pen_x += glyph.advance_ * scale_x * to_ndc_x;
+    ++quad;
+  }
+  // only reallocate the buffers when the text outgrows them
+  const auto vertices_size {static_cast<GLsizeiptr>(vertices_data_.size() * sizeof(GLfloat))};
+  const auto indices_size  {static_cast<GLsizeiptr>(indices_data_.size() * sizeof(GLuint))};
   vao_.bind();
-  vbo_.setup(config_.vertices_);
-  uv_.setup(config_.texture_coords_);
-  vao_.linkAttrib(vbo_, 0, 3, GL_FLOAT, 0, nullptr);
-  vao_.linkAttrib(uv_, 1, 2, GL_FLOAT, 0, nullptr);
-  ebo_.setup(config_.indices_);
+  if (vertices_size > vertices_capacity_) {
+    vertices_capacity_ = vertices_size * 2;
+    vbo_.setup(nullptr, vertices_capacity_, GL_DYNAMIC_DRAW);
+  }
+  vbo_.setupSubData(vertices_data_);
+  if (indices_size > indices_capacity_) {
+    indices_capacity_ = indices_size * 2;
+    ebo_.setup(nullptr, indices_capacity_, GL_DYNAMIC_DRAW);
+  }
+  ebo_.setupSubData(indices_data_);
+  dirty_ = false;
 }
 
-void kuge::GUIStringImpl::draw() const {
+void kuge::GUIStringImpl::draw() {
+  if (dirty_) buildMesh();
   shader_.use();
-  texture_.bind();
+  shader_.setFloat4("text_color", glm::value_ptr(ktp::Palette::colorToGlmVec4(config_.color_)));
+  texture_->bind();
   vao_.bind();
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices_data_.size()), GL_UNSIGNED_INT, 0);
 }
 
-void kuge::GUIStringImpl::updateTexture(const std::string& text) {
+void kuge::GUIStringImpl::setText(const std::string& text) {
+  if (text == config_.text_) return;
   config_.text_ = text;
-  texture_ = ktp::Resources::loadTextureFromTextBlended(config_.name_, config_.text_, config_.font_, ktp::Palette::colorToSDL2Color(config_.color_));
+  dirty_ = true;
 }
 
 kuge::GUISystem& kuge::GUISystem::operator=(GUISystem&& other) noexcept {
@@ -40,6 +118,13 @@ kuge::GUISystem& kuge::GUISystem::operator=(GUISystem&& other) noexcept {
   return *this;
 }
 
+void kuge::GUISystem::clean() {
+  demo_text_.reset();
+  paused_text_.reset();
+  score_text_.reset();
+  title_text_.reset();
+}
+
 void kuge::GUISystem::handleEvent(const KugeEvent* event) {
   switch(event->type()) {
     case KugeEventTypes::AeroliteDestroyed:
@@ -55,75 +140,42 @@ void kuge::GUISystem::handleEvent(const KugeEvent* event) {
 void kuge::GUISystem::init() {
   GUIStringConfig config {};
   /* TITLE TEXT */
-  config.name_   = "title";
   config.text_   = kTitleText_;
   config.color_  = ktp::Palette::white;
   config.font_   = "future";
   config.shader_ = "gui_string";
-  config.vertices_ = {
-     0.8f,  0.4f, 0.0f,  // top right
-     0.8f, -0.4f, 0.0f,  // bottom right
-    -0.8f, -0.4f, 0.0f,  // bottom left
-    -0.8f,  0.4f, 0.0f   // top left
-  };
-  config.indices_ = {
-    0, 3, 1,   // first triangle
-    3, 2, 1    // second triangle
-  };
-  config.texture_coords_ = {
-    1.0f, 0.0f,   // top right
-    1.0f, 1.0f,   // bottom right
-    0.0f, 1.0f,   // bottom left
-    0.0f, 0.0f    // top left
-  };
+  config.box_    = {-0.8f, -0.4f, 1.6f, 0.8f};
   title_text_ = std::make_unique<GUIStringImpl>(config);
   /* DEMO MODE TEXT */
-  config.name_   = "demo";
   config.text_   = kDemoModeText_;
   config.color_  = ktp::Palette::white;
   config.font_   = "future";
   config.shader_ = "gui_string";
-  config.vertices_ = {
-     0.2f,  0.1f, 0.0f,  // top right
-     0.2f, -0.1f, 0.0f,  // bottom right
-    -0.2f, -0.1f, 0.0f,  // bottom left
-    -0.2f,  0.1f, 0.0f   // top left
-  };
+  config.box_    = {-0.2f, -0.1f, 0.4f, 0.2f};
   demo_text_ = std::make_unique<GUIStringImpl>(config);
   /* PAUSED TEXT */
-  config.name_   = "paused";
   config.text_   = kPausedText_;
   config.color_  = ktp::Palette::white;
   config.font_   = "future";
   config.shader_ = "gui_string";
-  config.vertices_ = {
-     0.2f,  0.1f, 0.0f,  // top right
-     0.2f, -0.1f, 0.0f,  // bottom right
-    -0.2f, -0.1f, 0.0f,  // bottom left
-    -0.2f,  0.1f, 0.0f   // top left
-  };
+  config.box_    = {-0.2f, -0.1f, 0.4f, 0.2f};
   paused_text_ = std::make_unique<GUIStringImpl>(config);
   /* SCORE TEXT */
-  config.name_   = "score";
   config.text_   = kScoreText_;
   config.color_  = ktp::Palette::white;
   config.font_   = "future";
   config.shader_ = "gui_string";
-  config.vertices_ = {
-    -0.80f, 0.99f, 0.0f,  // top right
-    -0.80f, 0.93f, 0.0f,  // bottom right
-    -1.00f, 0.93f, 0.0f,  // bottom left
-    -1.00f, 0.99f, 0.0f   // top left
-  };
+  config.box_    = {-1.f, 0.93f, 0.2f, 0.06f};
   score_text_ = std::make_unique<GUIStringImpl>(config);
 }
 
 void kuge::GUISystem::resetScore() {
   score_ = 0;
-  score_text_->updateTexture(kScoreText_ + std::to_string(score_));
+  score_text_->setText(kScoreText_ + std::to_string(score_));
 }
 
 void kuge::GUISystem::updateScore(Uint32 points) {
   score_ += points;
-  score_text_->updateTexture(kScoreText_ + std::to_string(score_));
+  // the mesh is rebuilt when drawn, so a burst of events costs only one rebuild
+  score_text_->setText(kScoreText_ + std::to_string(score_));
 }
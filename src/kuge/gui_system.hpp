@@ -8,34 +8,47 @@
 namespace kuge {
 
 struct GUIStringConfig {
-  // The desired name for the texture.
-  std::string name_ {};
   // The text to display.
   std::string text_ {};
-  // The font to use.
+  // The glyph atlas to use.
   std::string font_ {};
   // The color for the font.
   ktp::Color color_ {};
   // The shader to use.
   std::string shader_ {};
-  ktp::GLfloatVector vertices_;
-  ktp::GLuintVector indices_;
-  ktp::GLfloatVector texture_coords_;
+  // The area where the text is centered, in NDC: {x, y, w, h}, x and y being the bottom left corner.
+  SDL_FRect box_ {};
 };
 
 class GUIStringImpl {
  public:
   GUIStringImpl(const GUIStringConfig& config);
-  void draw() const;
-  void updateTexture(const std::string& text);
+  /**
+   * @brief Draws the text. If the text has changed since the last draw,
+   *  the mesh is rebuilt first, so many changes in a frame cost one rebuild.
+   */
+  void draw();
+  /**
+   * @brief Changes the text to display.
+   * @param text The new text.
+   */
+  void setText(const std::string& text);
  private:
-  GUIStringConfig config_ {};
-  ktp::VAO vao_ {};
-  ktp::VBO vbo_ {};
-  ktp::VBO uv_ {};
-  ktp::EBO ebo_ {};
+  /**
+   * @brief Lays out one quad per glyph and uploads them.
+   */
+  void buildMesh();
+  GUIStringConfig    config_ {};
+  bool               dirty_ {true};
+  ktp::GLuintVector  indices_data_ {};
+  GLsizeiptr         indices_capacity_ {};
+  ktp::GLfloatVector vertices_data_ {};
+  GLsizeiptr         vertices_capacity_ {};
+  ktp::VAO           vao_ {};
+  ktp::VBO           vbo_ {};
+  ktp::EBO           ebo_ {};
   ktp::ShaderProgram shader_ {};
-  ktp::Texture2D texture_ {};
+  const ktp::Texture2D* texture_ {};
 };
 
 using GUIString = std::unique_ptr<GUIStringImpl>;
@@ -50,6 +63,10 @@ class GUISystem: public System {
   GUISystem& operator=(const GUISystem&) = delete;
   GUISystem& operator=(GUISystem&& other) noexcept;
 
+  /**
+   * @brief Releases the strings and their GL objects.
+   */
+  void clean();
   virtual void handleEvent(const KugeEvent*) override;
   void init();
   void resetScore();
@@ -1,10 +1,17 @@
 #include "include/opengl.hpp"
+#include "include/vertex_weld.hpp"
 #include "sdl2_wrappers/sdl2_log.hpp"
+#include <algorithm> // std::max std::sort
+#include <array>
+#include <cstdint>
+#include <unordered_map>
 
 /* SDL2_GL */
 
 GLenum ktp::glCheckError_(const char* file, int line) {
   GLenum error_code {};
+  // the debug output callback already reports every error as it happens
+  if (GLDebug::enabled()) return error_code;
   while (error_code = glGetError()) {
     std::string error_msg {};
     switch (error_code) {
@@ -22,6 +29,254 @@ GLenum ktp::glCheckError_(const char* file, int line) {
   return error_code;
 }
 
+/* GLDEBUG */
+
+namespace {
+
+bool debug_output {false};
+
+const char* debugSourceName(GLenum source) {
+  switch (source) {
+    case GL_DEBUG_SOURCE_API:             return "API";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "window system";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+    case GL_DEBUG_SOURCE_THIRD_PARTY:     return "third party";
+    case GL_DEBUG_SOURCE_APPLICATION:     return "application";
+    default:                              return "other";
+  }
+}
+
+const char* debugTypeName(GLenum type) {
+  switch (type) {
+    case GL_DEBUG_TYPE_ERROR:               return "error";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated behavior";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "undefined behavior";
+    case GL_DEBUG_TYPE_PORTABILITY:         return "portability";
+    case GL_DEBUG_TYPE_PERFORMANCE:         return "performance";
+    case GL_DEBUG_TYPE_MARKER:              return "marker";
+    case GL_DEBUG_TYPE_PUSH_GROUP:          return "push group";
+    case GL_DEBUG_TYPE_POP_GROUP:           return "pop group";
+    default:                                return "other";
+  }
+}
+
+void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_param) {
+  const std::string text {std::string{"OpenGL "} + debugSourceName(source) + ' ' + debugTypeName(type) + " (" + std::to_string(id) + "): " + message};
+  if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH) {
+    ktp::logError(text, SDL_LOG_CATEGORY_RENDER);
+  } else {
+    ktp::logMessage(text, SDL_LOG_CATEGORY_RENDER);
+  }
+}
+
+} // namespace
+
+bool ktp::GLDebug::init(GLenum min_severity) {
+  GLint flags {};
+  glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+  if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT) || !GLEW_KHR_debug) {
+    logMessage("Warning! No debug context or no KHR_debug. OpenGL debug output is off.");
+    debug_output = false;
+    return false;
+  }
+  glEnable(GL_DEBUG_OUTPUT);
+#ifndef NDEBUG
+  // the messages come from inside the call that caused them, so breakpoints work
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+  glDebugMessageCallback(debugCallback, nullptr);
+  // everything on, then the severities below the minimum off
+  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+  constexpr GLenum kSeverities[] {GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH};
+  for (const auto severity: kSeverities) {
+    if (severity == min_severity) break;
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, GL_FALSE);
+  }
+  debug_output = true;
+  logMessage("OpenGL debug output is on.");
+  return true;
+}
+
+bool ktp::GLDebug::enabled() {
+  return debug_output;
+}
+
+void ktp::GLDebug::label(GLenum identifier, GLuint id, const std::string& name) {
+  if (!debug_output || !id) return;
+  // generated names aren't objects until they are bound for the first time
+  if (identifier == GL_BUFFER) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+  } else if (identifier == GL_VERTEX_ARRAY) {
+    GLint previous {};
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+    glBindVertexArray(id);
+    glBindVertexArray(static_cast<GLuint>(previous));
+  }
+  glObjectLabel(identifier, id, static_cast<GLsizei>(name.size()), name.c_str());
+}
+
+void ktp::GLDebug::popGroup() {
+  if (debug_output) glPopDebugGroup();
+}
+
+void ktp::GLDebug::pushGroup(const char* name) {
+  if (debug_output) glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+GLenum ktp::GLDebug::severityFromString(const std::string& severity) {
+  if (severity == "high")         return GL_DEBUG_SEVERITY_HIGH;
+  if (severity == "low")          return GL_DEBUG_SEVERITY_LOW;
+  if (severity == "notification") return GL_DEBUG_SEVERITY_NOTIFICATION;
+  if (severity != "medium") logMessage("Warning! Unknown OpenGL debug severity \"" + severity + "\". Using medium.");
+  return GL_DEBUG_SEVERITY_MEDIUM;
+}
+
+/* GLMEMORY */
+
+namespace {
+
+struct TrackedObject {
+  GLenum               identifier_ {};
+  GLuint               id_ {};
+  std::string          name_ {};
+  ktp::MemoryCategory  category_ {ktp::MemoryCategory::Other};
+  std::size_t          bytes_ {};
+};
+
+constexpr auto kCategories {static_cast<std::size_t>(ktp::MemoryCategory::count)};
+
+std::unordered_map<std::uint64_t, TrackedObject> tracked_objects {};
+std::array<std::size_t, kCategories> live_bytes {};
+std::array<std::size_t, kCategories> peak_bytes {};
+std::size_t total_live_bytes {};
+std::size_t total_peak_bytes {};
+
+std::uint64_t trackingKey(GLenum identifier, GLuint id) {
+  return (static_cast<std::uint64_t>(identifier) << 32) | id;
+}
+
+void addBytes(ktp::MemoryCategory category, std::size_t bytes) {
+  const auto index {static_cast<std::size_t>(category)};
+  live_bytes[index] += bytes;
+  peak_bytes[index] = std::max(peak_bytes[index], live_bytes[index]);
+  total_live_bytes += bytes;
+  total_peak_bytes = std::max(total_peak_bytes, total_live_bytes);
+}
+
+void removeBytes(ktp::MemoryCategory category, std::size_t bytes) {
+  live_bytes[static_cast<std::size_t>(category)] -= bytes;
+  total_live_bytes -= bytes;
+}
+
+const char* identifierName(GLenum identifier) {
+  switch (identifier) {
+    case GL_BUFFER:       return "buffer";
+    case GL_FRAMEBUFFER:  return "framebuffer";
+    case GL_RENDERBUFFER: return "renderbuffer";
+    case GL_TEXTURE:      return "texture";
+    case GL_VERTEX_ARRAY: return "vertex array";
+    default:              return "object";
+  }
+}
+
+// an estimate, drivers may pad the rows or store RGB as RGBA
+std::size_t bytesPerTexel(GLint internal_format) {
+  switch (internal_format) {
+    case GL_RED: case GL_R8:                   return 1u;
+    case GL_RG: case GL_RG8:                   return 2u;
+    case GL_RGB: case GL_RGB8:                 return 3u;
+    case GL_DEPTH_COMPONENT24:                 return 3u;
+    default:                                   return 4u;
+  }
+}
+
+} // namespace
+
+void ktp::GLMemory::allocated(GLenum identifier, GLuint id, std::size_t bytes) {
+  const auto found {tracked_objects.find(trackingKey(identifier, id))};
+  if (found == tracked_objects.end()) return;
+  auto& object {found->second};
+  removeBytes(object.category_, object.bytes_);
+  object.bytes_ = bytes;
+  addBytes(object.category_, object.bytes_);
+}
+
+const char* ktp::GLMemory::categoryName(MemoryCategory category) {
+  switch (category) {
+    case MemoryCategory::Aerolites:    return "Aerolites";
+    case MemoryCategory::Entities:     return "Entities";
+    case MemoryCategory::Particles:    return "Particles";
+    case MemoryCategory::Stars:        return "Stars";
+    case MemoryCategory::GUI:          return "GUI";
+    case MemoryCategory::Debug:        return "Debug";
+    case MemoryCategory::Framebuffers: return "Framebuffers";
+    case MemoryCategory::Other:        return "Other";
+    default:                           return "Unknown";
+  }
+}
+
+void ktp::GLMemory::created(GLenum identifier, GLuint id) {
+  if (!id) return;
+  tracked_objects[trackingKey(identifier, id)] = TrackedObject{identifier, id};
+}
+
+void ktp::GLMemory::deleted(GLenum identifier, GLuint id) {
+  const auto found {tracked_objects.find(trackingKey(identifier, id))};
+  if (found == tracked_objects.end()) return;
+  removeBytes(found->second.category_, found->second.bytes_);
+  tracked_objects.erase(found);
+}
+
+void ktp::GLMemory::label(GLenum identifier, GLuint id, const std::string& name, MemoryCategory category) {
+  const auto found {tracked_objects.find(trackingKey(identifier, id))};
+  if (found == tracked_objects.end()) return;
+  auto& object {found->second};
+  object.name_ = name;
+  removeBytes(object.category_, object.bytes_);
+  object.category_ = category;
+  addBytes(object.category_, object.bytes_);
+}
+
+std::size_t ktp::GLMemory::liveBytes() {
+  return total_live_bytes;
+}
+
+std::size_t ktp::GLMemory::liveBytes(MemoryCategory category) {
+  return live_bytes[static_cast<std::size_t>(category)];
+}
+
+std::size_t ktp::GLMemory::liveObjects() {
+  return tracked_objects.size();
+}
+
+std::size_t ktp::GLMemory::peakBytes() {
+  return total_peak_bytes;
+}
+
+std::size_t ktp::GLMemory::peakBytes(MemoryCategory category) {
+  return peak_bytes[static_cast<std::size_t>(category)];
+}
+
+std::size_t ktp::GLMemory::reportLeaks() {
+  if (tracked_objects.empty()) {
+    logMessage("No GL objects leaked. Peak GPU memory: " + std::to_string(total_peak_bytes) + " bytes.");
+    return 0u;
+  }
+  // sorted, so two reports of the same leak look the same
+  std::vector<const TrackedObject*> leaks {};
+  leaks.reserve(tracked_objects.size());
+  for (const auto& [key, object]: tracked_objects) leaks.push_back(&object);
+  std::sort(leaks.begin(), leaks.end(), [](const TrackedObject* a, const TrackedObject* b) {
+    return a->identifier_ != b->identifier_ ? a->identifier_ < b->identifier_ : a->id_ < b->id_;
+  });
+  logError(std::to_string(leaks.size()) + " GL objects never released, holding " + std::to_string(total_live_bytes) + " bytes:");
+  for (const auto object: leaks) {
+    const auto name {object->name_.empty() ? std::string{"unlabeled"} : '\"' + object->name_ + '\"'};
+    logError(std::string{"  "} + identifierName(object->identifier_) + ' ' + std::to_string(object->id_) + ' ' + name + " [" + categoryName(object->category_) + "] " + std::to_string(object->bytes_) + " bytes");
+  }
+  return leaks.size();
+}
+
 std::vector<GLfloat> ktp::cube(GLfloat size) {
   const auto good_size {SDL_fabsf(size)};
   std::vector<GLfloat> vertices {
@@ -65,72 +320,108 @@ std::vector<GLfloat> ktp::cube(GLfloat size) {
   return vertices;
 }
 
+/* SHADER PROGRAM */
+
+GLuint       ktp::ShaderProgram::current_id_ {};
+unsigned int ktp::ShaderProgram::current_tag_ {};
+unsigned int ktp::ShaderProgram::program_switches_ {};
+unsigned int ktp::ShaderProgram::unshared_switches_ {};
+
+void ktp::ShaderProgram::newFrame() {
+  current_id_ = 0u;
+  current_tag_ = 0u;
+  program_switches_ = 0u;
+  unshared_switches_ = 0u;
+}
+
+void ktp::ShaderProgram::use() const {
+  // untagged programs only count as the same one if the id is the same
+  if (tag_ != current_tag_ || (tag_ == 0u && id_ != current_id_)) ++unshared_switches_;
+  current_tag_ = tag_;
+  if (id_ == current_id_) return;
+  glUseProgram(id_);
+  current_id_ = id_;
+  ++program_switches_;
+}
+
 /* VBO */
 
 ktp::VBO::VBO() {
   glGenBuffers(1, &id_);
+  GLMemory::created(GL_BUFFER, id_);
+}
+
+void ktp::VBO::destroy() {
+  if (!id_) return;
+  GLMemory::deleted(GL_BUFFER, id_);
+  glDeleteBuffers(1, &id_);
+  id_ = 0;
+}
+
+void ktp::VBO::label(const std::string& name, MemoryCategory category) const {
+  GLDebug::label(GL_BUFFER, id_, name);
+  GLMemory::label(GL_BUFFER, id_, name, category);
 }
 
 // this setup is needed when you pass nullptr for a later use with subData
 void ktp::VBO::setup(const GLfloat* vertices, GLsizeiptr size, GLenum usage) {
   glBindBuffer(GL_ARRAY_BUFFER, id_);
   glBufferData(GL_ARRAY_BUFFER, size, vertices, usage);
+  GLMemory::allocated(GL_BUFFER, id_, static_cast<std::size_t>(size));
 }
 
 /* EBO */
 
 ktp::EBO::EBO() {
   glGenBuffers(1, &id_);
+  GLMemory::created(GL_BUFFER, id_);
 }
 
-void ktp::EBO::generateEBO(GLfloatVector& vertices, GLuintVector& indices) {
-  GLfloatVector unique_coords {};
-  indices.clear();
-  // push the first element
-  indices.push_back(0);
-  // push the first three coords
-  unique_coords.push_back(vertices[0]);
-  unique_coords.push_back(vertices[1]);
-  unique_coords.push_back(vertices[2]);
-  // find repeated coords by groups of 3
-  for (std::size_t i = 3; i < vertices.size(); i += 3) {
-    bool found {false};
-    for (std::size_t j = 0; j < unique_coords.size(); j += 3) {
-      if (vertices[i] == unique_coords[j] && vertices[i + 1] == unique_coords[j + 1] && vertices[i + 2] == unique_coords[j + 2]) {
-        // coord already in the list
-        found = true;
-        // so, new index will point to...
-        indices.push_back(j / 3u);
-        break;
-      }
-    }
-    if (!found) {
-      // new unique coord
-      unique_coords.push_back(vertices[i]);
-      unique_coords.push_back(vertices[i + 1]);
-      unique_coords.push_back(vertices[i + 2]);
-      // the new index points at...
-      indices.push_back((unique_coords.size() - 1u) / 3u);
-    }
-  }
-  // the new vertices
-  vertices = std::move(unique_coords);
+void ktp::EBO::destroy() {
+  if (!id_) return;
+  GLMemory::deleted(GL_BUFFER, id_);
+  glDeleteBuffers(1, &id_);
+  id_ = 0;
+}
+
+void ktp::EBO::generateEBO(GLfloatVector& vertices, GLuintVector& indices, std::size_t stride, GLfloat epsilon) {
+  weldVertices(vertices, indices, stride, epsilon);
+}
+
+void ktp::EBO::label(const std::string& name, MemoryCategory category) const {
+  GLDebug::label(GL_BUFFER, id_, name);
+  GLMemory::label(GL_BUFFER, id_, name, category);
 }
 
 void ktp::EBO::setup(const GLuintVector& indices, GLenum usage) {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id_);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), usage);
+  GLMemory::allocated(GL_BUFFER, id_, indices.size() * sizeof(GLuint));
 }
 
 void ktp::EBO::setup(const GLuint* indices, GLsizeiptr size, GLenum usage) {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id_);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, usage);
+  GLMemory::allocated(GL_BUFFER, id_, static_cast<std::size_t>(size));
 }
 
 /* VAO */
 
 ktp::VAO::VAO() {
   glGenVertexArrays(1, &id_);
+  GLMemory::created(GL_VERTEX_ARRAY, id_);
+}
+
+void ktp::VAO::destroy() {
+  if (!id_) return;
+  GLMemory::deleted(GL_VERTEX_ARRAY, id_);
+  glDeleteVertexArrays(1, &id_);
+  id_ = 0;
+}
+
+void ktp::VAO::label(const std::string& name, MemoryCategory category) const {
+  GLDebug::label(GL_VERTEX_ARRAY, id_, name);
+  GLMemory::label(GL_VERTEX_ARRAY, id_, name, category);
 }
 
 void ktp::VAO::linkAttrib(const VBO& vbo, GLuint layout, GLuint components, GLenum type, GLsizeiptr stride, void* offset, GLboolean normalize) const {
@@ -159,19 +450,92 @@ void ktp::VAO::linkAttribFast(GLuint layout, GLuint components, GLenum type, GLs
   );
 }
 
+/* FBO */
+
+ktp::FBO::FBO(GLsizei width, GLsizei height): width_(width), height_(height) {
+  glGenFramebuffers(1, &id_);
+  GLMemory::created(GL_FRAMEBUFFER, id_);
+  glBindFramebuffer(GL_FRAMEBUFFER, id_);
+  // color
+  glGenTextures(1, &color_);
+  GLMemory::created(GL_TEXTURE, color_);
+  glBindTexture(GL_TEXTURE_2D, color_);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  GLMemory::allocated(GL_TEXTURE, color_, static_cast<std::size_t>(width_) * height_ * bytesPerTexel(GL_RGBA8));
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  // depth
+  glGenRenderbuffers(1, &depth_);
+  GLMemory::created(GL_RENDERBUFFER, depth_);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width_, height_);
+  GLMemory::allocated(GL_RENDERBUFFER, depth_, static_cast<std::size_t>(width_) * height_ * bytesPerTexel(GL_DEPTH_COMPONENT24));
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    logError("Framebuffer " + std::to_string(width_) + 'x' + std::to_string(height_) + " is not complete", SDL_LOG_CATEGORY_RENDER);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ktp::FBO::destroy() {
+  if (depth_) {
+    GLMemory::deleted(GL_RENDERBUFFER, depth_);
+    glDeleteRenderbuffers(1, &depth_);
+  }
+  if (color_) {
+    GLMemory::deleted(GL_TEXTURE, color_);
+    glDeleteTextures(1, &color_);
+  }
+  if (id_) {
+    GLMemory::deleted(GL_FRAMEBUFFER, id_);
+    glDeleteFramebuffers(1, &id_);
+  }
+  id_ = color_ = depth_ = 0;
+  width_ = height_ = 0;
+}
+
+void ktp::FBO::label(const std::string& name, MemoryCategory category) const {
+  GLDebug::label(GL_FRAMEBUFFER, id_, name);
+  GLMemory::label(GL_FRAMEBUFFER, id_, name, category);
+  GLMemory::label(GL_TEXTURE, color_, name + " color", category);
+  GLMemory::label(GL_RENDERBUFFER, depth_, name + " depth", category);
+}
+
 /* Texture2D */
 
-// void ktp::Texture2D::generate(GLsizei width, GLsizei height, unsigned char* data) {
-//   width_ = width;
-//   height_ = height;
-//   // create Texture
-//   glBindTexture(GL_TEXTURE_2D, id_);
-//   glTexImage2D(GL_TEXTURE_2D, 0, internal_format_, width, height, 0, image_format_, GL_UNSIGNED_BYTE, data);
-//   // set Texture wrap and filter modes
-//   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s_);
-//   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t_);
-//   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min_);
-//   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_max_);
-//   // unbind texture
-//   glBindTexture(GL_TEXTURE_2D, 0);
-// }
+void ktp::Texture2D::destroy() {
+  if (!id_) return;
+  GLMemory::deleted(GL_TEXTURE, id_);
+  glDeleteTextures(1, &id_);
+  id_ = 0;
+  width_ = height_ = 0;
+}
+
+void ktp::Texture2D::label(const std::string& name, MemoryCategory category) const {
+  GLDebug::label(GL_TEXTURE, id_, name);
+  GLMemory::label(GL_TEXTURE, id_, name, category);
+}
+
+void ktp::Texture2D::setup(GLsizei width, GLsizei height, GLint internal_format, GLenum format, const void* pixels, bool mipmaps) {
+  if (!id_) {
+    glGenTextures(1, &id_);
+    GLMemory::created(GL_TEXTURE, id_);
+  }
+  width_ = width;
+  height_ = height;
+  glBindTexture(GL_TEXTURE_2D, id_);
+  glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width_, height_, 0, format, GL_UNSIGNED_BYTE, pixels);
+  auto bytes {static_cast<std::size_t>(width_) * height_ * bytesPerTexel(internal_format)};
+  if (mipmaps) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    // the whole chain adds up to a third of the base level
+    bytes += bytes / 3u;
+  }
+  GLMemory::allocated(GL_TEXTURE, id_, bytes);
+}
@@ -0,0 +1,85 @@
+#include "include/physics_thread.hpp"
+#include "sdl2_wrappers/sdl2_log.hpp"
+
+void ktp::PhysicsThread::beginStep(float delta_time, int32 velocity_iterations, int32 position_iterations) {
+  if (!thread_) return;
+  wait();
+  delta_time_ = delta_time;
+  velocity_iterations_ = velocity_iterations;
+  position_iterations_ = position_iterations;
+  pending_ = true;
+  // the semaphore publishes everything above to the worker
+  SDL_SemPost(start_);
+}
+
+void ktp::PhysicsThread::clean() {
+  if (!thread_) return;
+  wait();
+  quit_ = true;
+  SDL_SemPost(start_);
+  SDL_WaitThread(thread_, nullptr);
+  thread_ = nullptr;
+  SDL_DestroySemaphore(start_);
+  SDL_DestroySemaphore(done_);
+  start_ = done_ = nullptr;
+  quit_ = false;
+}
+
+void ktp::PhysicsThread::finishStep(float delta_time, int32 velocity_iterations, int32 position_iterations) {
+  if (pending_) {
+    wait();
+    return;
+  }
+  delta_time_ = delta_time;
+  velocity_iterations_ = velocity_iterations;
+  position_iterations_ = position_iterations;
+  step();
+  step_time_ = worker_step_time_;
+}
+
+void ktp::PhysicsThread::init(b2World* world, bool threaded) {
+  world_ = world;
+  if (!threaded) return;
+  start_ = SDL_CreateSemaphore(0);
+  done_ = SDL_CreateSemaphore(0);
+  if (start_ && done_) thread_ = SDL_CreateThread(run, "physics", this);
+  if (!thread_) {
+    logSDL2Error("SDL_CreateThread");
+    logMessage("Warning! Physics thread not available. Stepping on the main thread.");
+    if (start_) SDL_DestroySemaphore(start_);
+    if (done_) SDL_DestroySemaphore(done_);
+    start_ = done_ = nullptr;
+  }
+}
+
+bool ktp::PhysicsThread::ready() {
+  if (!pending_) return true;
+  if (SDL_SemTryWait(done_) != 0) return false;
+  pending_ = false;
+  step_time_ = worker_step_time_;
+  return true;
+}
+
+int ktp::PhysicsThread::run(void* data) {
+  auto& physics {*static_cast<PhysicsThread*>(data)};
+  while (true) {
+    SDL_SemWait(physics.start_);
+    if (physics.quit_) break;
+    physics.step();
+    SDL_SemPost(physics.done_);
+  }
+  return 0;
+}
+
+void ktp::PhysicsThread::step() {
+  const auto start {SDL_GetPerformanceCounter()};
+  world_->Step(delta_time_, velocity_iterations_, position_iterations_);
+  worker_step_time_ = static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+void ktp::PhysicsThread::wait() {
+  if (!pending_) return;
+  SDL_SemWait(done_);
+  pending_ = false;
+  step_time_ = worker_step_time_;
+}
@@ -26,14 +26,18 @@ void ktp::PlayerGraphicsComponent::generateOpenGLStuff(float size) {
   // vertices
   vao_.linkAttrib(vertices_, 0, 3, GL_FLOAT, 6 * sizeof(GLfloat), nullptr);
   // colors
-  vao_.linkAttrib(vertices_, 1, 3, GL_FLOAT, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+  vao_.linkAttrib(vertices_, 2, 3, GL_FLOAT, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
   // EBO
   vertices_indices_.setup(player_shape_indices);
+  vao_.label("player", MemoryCategory::Entities);
+  vertices_.label("player vertices", MemoryCategory::Entities);
+  vertices_indices_.label("player indices", MemoryCategory::Entities);
 }
 
 void ktp::PlayerGraphicsComponent::update(const GameEntity& player) {
   shader_.use();
-  shader_.setMat4f("mvp", glm::value_ptr(mvp_));
+  const glm::mat4 mvp {view_projection_ * interpolatedModel()};
+  shader_.setMat4f("mvp", glm::value_ptr(mvp));
   vao_.bind();
   glDrawElements(GL_TRIANGLES, 9, GL_UNSIGNED_INT, 0); // 9 is the number of indices
 }
@@ -136,7 +140,7 @@ void ktp::PlayerPhysicsComponent::setBox2D() {
   // Player
   b2BodyDef body_def {};
   body_def.type = b2_dynamicBody;
-  body_def.bullet = true;
+  body_def.bullet = ConfigParser::player_config.collision_.bullet_;
   body_def.position.Set(b2_screen_size_.x * 0.5f, b2_screen_size_.y * 0.5f);
   body_def.userData.pointer = reinterpret_cast<uintptr_t>(owner_);
 
@@ -151,7 +155,7 @@ void ktp::PlayerPhysicsComponent::setBox2D() {
 
   b2FixtureDef fixture_def {};
   fixture_def.density = ConfigParser::player_config.density_;
-  fixture_def.filter.groupIndex = -1;
+  fixture_def.filter = collisionFilter(ConfigParser::player_config.collision_);
   fixture_def.friction = ConfigParser::player_config.friction_;
   fixture_def.shape = &triangle;
 
@@ -178,7 +182,7 @@ void ktp::PlayerPhysicsComponent::setBox2D() {
 
 void ktp::PlayerPhysicsComponent::update(const GameEntity& player, float delta_time) {
   checkWrap();
-  updateMVP();
+  updateTransform();
   // exhaust emitter stuff
   const auto good_angle {body_->GetAngle() + b2_pi};
   cos_ = SDL_cosf(good_angle);
@@ -192,9 +196,8 @@ void ktp::PlayerPhysicsComponent::update(const GameEntity& player, float delta_t
   if (thrusting_) exhaust_emitter_->generateParticles();
 }
 
-void ktp::PlayerPhysicsComponent::updateMVP() {
-  glm::mat4 model {1.f};
-  model = glm::translate(model, glm::vec3(body_->GetPosition().x * kMetersToPixels, body_->GetPosition().y * kMetersToPixels, 0.f));
-  model = glm::rotate(model, body_->GetAngle(), glm::vec3(0.f, 0.f, 1.f));
-  graphics_->mvp_ = camera_.projectionMatrix() * camera_.viewMatrix() * model;
+void ktp::PlayerPhysicsComponent::updateTransform() {
+  graphics_->setTransform({body_->GetPosition().x * kMetersToPixels, body_->GetPosition().y * kMetersToPixels}, body_->GetAngle());
+  const b2Vec2 extent {size_ * 0.5f, size_ * 0.5f};
+  graphics_->setBounds({kMetersToPixels * (body_->GetPosition() - extent), kMetersToPixels * (body_->GetPosition() + extent)});
 }
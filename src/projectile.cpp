@@ -4,14 +4,85 @@
 #include "include/game_entity.hpp"
 #include "include/projectile.hpp"
 #include "sdl2_wrappers/sdl2_timer.hpp"
+#include <algorithm> // std::max
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The shape of the laser, for the fixture or the mass of a ray cast one.
+ * @param size The size of the projectile.
+ * @return The polygon.
+ */
+b2PolygonShape laserShape(float size) {
+  b2Vec2 laser_vertices[5];
+  laser_vertices[0].Set(0, -size - (size * 0.5f)); // top
+  laser_vertices[1].Set(-size * 0.15f, -size); // top left
+  laser_vertices[2].Set(-size * 0.15f,  size); // down left
+  laser_vertices[3].Set( size * 0.15f,  size); // down right
+  laser_vertices[4].Set( size * 0.15f, -size); // up right
+
+  b2PolygonShape projectile_shape {};
+  projectile_shape.Set(laser_vertices, 5);
+  return projectile_shape;
+}
+
+/**
+ * @brief Finds the closest thing a ray cast projectile would collide with, and
+ *  the sensors on the way. Reused by every projectile, main thread only.
+ */
+class ProjectileRayCast: public b2RayCastCallback {
+ public:
+  struct SensorHit {
+    ktp::GameEntity* entity_;
+    float            fraction_;
+  };
+
+  float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override {
+    // what a projectile's body wouldn't pair with
+    if (!ktp::shouldCollide(ktp::collisionFilter(ktp::ConfigParser::projectiles_config.collision_), fixture->GetFilterData())) return -1.f;
+    const auto entity {reinterpret_cast<ktp::GameEntity*>(fixture->GetBody()->GetUserData().pointer)};
+    // it's leaving too
+    if (!entity || entity->canBeDeactivated()) return -1.f;
+    switch (entity->type()) {
+      case ktp::EntityTypes::Aerolite:
+      case ktp::EntityTypes::Explosion:
+        fixture_ = fixture;
+        fraction_ = fraction;
+        normal_ = normal;
+        point_ = point;
+        // only what's closer from now on
+        return fraction;
+      case ktp::EntityTypes::AeroliteSpawner:
+        sensors_.push_back({entity, fraction});
+        return -1.f;
+      default:
+        // the player, and what the contact listener doesn't pair a projectile with
+        return -1.f;
+    }
+  }
+
+  void reset() {
+    fixture_ = nullptr;
+    fraction_ = 1.f;
+    sensors_.clear();
+  }
+
+  b2Fixture*             fixture_ {nullptr};
+  float                  fraction_ {1.f};
+  b2Vec2                 normal_ {};
+  b2Vec2                 point_ {};
+  std::vector<SensorHit> sensors_ {};
+};
+
+ProjectileRayCast ray_cast {};
+
+} // namespace
 
 /* GRAPHICS */
 
 ktp::ProjectileGraphicsComponent::ProjectileGraphicsComponent() {
   generateOpenGLStuff(ConfigParser::projectiles_config.size_ * kMetersToPixels);
-  const glm::vec4 uniform_color {color_.r, color_.g, color_.b, color_.a};
-  shader_.use();
-  shader_.setFloat4("projectile_color", glm::value_ptr(uniform_color));
 }
 
 void ktp::ProjectileGraphicsComponent::generateOpenGLStuff(float size) {
@@ -32,11 +103,18 @@ void ktp::ProjectileGraphicsComponent::generateOpenGLStuff(float size) {
   vao_.linkAttrib(vertices_, 0, 3, GL_FLOAT, 0, nullptr);
   // EBO
   vertices_indices_.setup(projectiles_shape_indices);
+  vao_.label("projectile", MemoryCategory::Entities);
+  vertices_.label("projectile vertices", MemoryCategory::Entities);
+  vertices_indices_.label("projectile indices", MemoryCategory::Entities);
 }
 
 void ktp::ProjectileGraphicsComponent::update(const GameEntity& projectile) {
+  // the program is shared with the arrows, so the color goes in every draw
+  const glm::vec4 uniform_color {color_.r, color_.g, color_.b, color_.a};
   shader_.use();
-  shader_.setMat4f("mvp", glm::value_ptr(mvp_));
+  const glm::mat4 mvp {view_projection_ * interpolatedModel()};
+  shader_.setMat4f("mvp", glm::value_ptr(mvp));
+  shader_.setFloat4("color", glm::value_ptr(uniform_color));
   vao_.bind();
   glDrawElements(GL_TRIANGLES, 9, GL_UNSIGNED_INT, 0); // 9 is the number of indices
 }
@@ -48,7 +126,13 @@ ktp::ProjectilePhysicsComponent::ProjectilePhysicsComponent(GameEntity* owner, P
   owner_ = owner;
   size_ = ConfigParser::projectiles_config.size_;
   // Box2D
-  setBox2D();
+  if (ray_cast_) {
+    b2MassData mass_data {};
+    laserShape(size_).ComputeMass(&mass_data, ConfigParser::projectiles_config.density_);
+    mass_ = mass_data.mass;
+  } else {
+    setBox2D();
+  }
   // explosion
   explosion_ = static_cast<ExplosionPhysicsComponent*>(GameEntity::createEntity(EntityTypes::Explosion)->physics());
   if (explosion_) {
@@ -57,11 +141,12 @@ ktp::ProjectilePhysicsComponent::ProjectilePhysicsComponent(GameEntity* owner, P
   }
   // exhaust emitter
   exhaust_emitter_ = static_cast<EmitterPhysicsComponent*>(GameEntity::createEntity(EntityTypes::Emitter)->physics());
+  const auto position {currentPosition()};
   exhaust_emitter_->init("projectile_exhaust",
-    {(body_->GetPosition().x * kMetersToPixels) - size_ * 0.33f * kMetersToPixels * sin_,
-     (body_->GetPosition().y * kMetersToPixels) + size_ * 0.33f * kMetersToPixels * cos_,
+    {(position.x * kMetersToPixels) - size_ * 0.33f * kMetersToPixels * sin_,
+     (position.y * kMetersToPixels) + size_ * 0.33f * kMetersToPixels * cos_,
      0.f});
-  exhaust_emitter_->setAngle(body_->GetAngle());
+  exhaust_emitter_->setAngle(currentAngle());
 
   fired_time_ = Game::gameplay_timer_.milliseconds();
 }
@@ -74,6 +159,7 @@ ktp::ProjectilePhysicsComponent& ktp::ProjectilePhysicsComponent::operator=(Proj
     owner_    = std::exchange(other.owner_, nullptr);
     size_     = other.size_;
     // own members
+    angle_            = other.angle_;
     armed_            = other.armed_;
     arm_time_         = other.arm_time_;
     body_             = std::exchange(other.body_, nullptr);
@@ -83,53 +169,116 @@ ktp::ProjectilePhysicsComponent& ktp::ProjectilePhysicsComponent::operator=(Proj
     explosion_        = std::exchange(other.explosion_, nullptr);
     fired_time_       = other.fired_time_;
     graphics_         = std::exchange(other.graphics_, nullptr);
+    mass_             = other.mass_;
+    position_         = other.position_;
+    ray_cast_         = other.ray_cast_;
     sin_              = other.sin_;
     speed_            = other.speed_;
+    velocity_         = other.velocity_;
   }
   return *this;
 }
 
+void ktp::ProjectilePhysicsComponent::advance(float delta_time) {
+  auto translation {delta_time * velocity_};
+  // the same limit a step puts on a body
+  if (b2Dot(translation, translation) > b2_maxTranslation * b2_maxTranslation) {
+    const auto ratio {b2_maxTranslation / translation.Length()};
+    translation *= ratio;
+    velocity_ *= ratio;
+  }
+  const auto distance {translation.Length()};
+  // the ray needs some length
+  if (distance < b2_linearSlop) {
+    position_ += translation;
+    return;
+  }
+  const auto direction {(1.f / distance) * translation};
+  // from the center to the tip of the laser
+  const auto nose {size_ * 1.5f};
+  const auto length {distance + nose};
+  ray_cast.reset();
+  world_->RayCast(&ray_cast, position_, position_ + length * direction);
+  // the sensors it goes through before it stops
+  for (const auto& sensor: ray_cast.sensors_) {
+    if (sensor.fraction_ <= ray_cast.fraction_) sensor.entity_->physics()->collide(owner_);
+  }
+  if (!ray_cast.fixture_) {
+    position_ += translation;
+    return;
+  }
+  // it stops where the tip touches
+  position_ += std::max(ray_cast.fraction_ * length - nose, 0.f) * direction;
+  // the same the contact listener does with a projectile's body
+  const auto entity {reinterpret_cast<GameEntity*>(ray_cast.fixture_->GetBody()->GetUserData().pointer)};
+  if (entity->type() == EntityTypes::Explosion) entity->physics()->collide(owner_);
+  collide(entity);
+  // bounces off, in case it's not armed, and pushes what it hit
+  const auto body {ray_cast.fixture_->GetBody()};
+  const auto approach {b2Dot(velocity_ - body->GetLinearVelocityFromWorldPoint(ray_cast.point_), ray_cast.normal_)};
+  if (approach < 0.f) {
+    const auto delta_v {-(1.f + ConfigParser::projectiles_config.restitution_) * approach};
+    velocity_ += delta_v * ray_cast.normal_;
+    body->ApplyLinearImpulse(-(mass_ * delta_v) * ray_cast.normal_, ray_cast.point_, true);
+  }
+}
+
 void ktp::ProjectilePhysicsComponent::detonate() {
   detonated_ = true;
-  explosion_->detonate(Game::gameplay_timer_.milliseconds(), body_->GetPosition());
+  explosion_->detonate(Game::gameplay_timer_.milliseconds(), currentPosition());
 }
 
 bool ktp::ProjectilePhysicsComponent::isOutOfScreen(float threshold) {
+  const auto position {currentPosition()};
   return (
-    body_->GetPosition().x < -threshold || body_->GetPosition().x > b2_screen_size_.x + threshold ||
-    body_->GetPosition().y < -threshold || body_->GetPosition().y > b2_screen_size_.y + threshold
+    position.x < -threshold || position.x > b2_screen_size_.x + threshold ||
+    position.y < -threshold || position.y > b2_screen_size_.y + threshold
   );
 }
 
 void ktp::ProjectilePhysicsComponent::setBox2D() {
   b2BodyDef body_def {};
   body_def.type = b2_dynamicBody;
-  body_def.bullet = true;
+  body_def.bullet = ConfigParser::projectiles_config.collision_.bullet_;
   body_def.userData.pointer = reinterpret_cast<uintptr_t>(owner_);
   body_def.angularDamping = 1.f;
 
-  body_ = world_->CreateBody(&body_def);
+  body_ = BodyPool::acquire(BodyArchetype::Projectile, body_def);
+  // a recycled one already has its fixture
+  if (body_->GetFixtureList()) return;
 
-  b2Vec2 laser_vertices[5];
-  laser_vertices[0].Set(0, -size_ - (size_ * 0.5f)); // top
-  laser_vertices[1].Set(-size_ * 0.15f, -size_); // top left
-  laser_vertices[2].Set(-size_ * 0.15f,  size_); // down left
-  laser_vertices[3].Set( size_ * 0.15f,  size_); // down right
-  laser_vertices[4].Set( size_ * 0.15f, -size_); // up right
-
-  b2PolygonShape projectile_shape {};
-  projectile_shape.Set(laser_vertices, 5);
+  const auto projectile_shape {laserShape(size_)};
 
   b2FixtureDef projectile_fixture_def {};
   projectile_fixture_def.shape = &projectile_shape;
   projectile_fixture_def.density = ConfigParser::projectiles_config.density_;
+  projectile_fixture_def.filter = collisionFilter(ConfigParser::projectiles_config.collision_);
   projectile_fixture_def.friction = ConfigParser::projectiles_config.friction_;
   projectile_fixture_def.restitution = ConfigParser::projectiles_config.restitution_;
 
   body_->CreateFixture(&projectile_fixture_def);
 }
 
+void ktp::ProjectilePhysicsComponent::setTransform(const b2Vec2& position, float angle) {
+  if (body_) {
+    body_->SetTransform(position, angle);
+  } else {
+    position_ = position;
+    angle_ = angle;
+  }
+}
+
+void ktp::ProjectilePhysicsComponent::setVelocity(const b2Vec2& velocity) {
+  if (body_) {
+    body_->SetLinearVelocity(velocity);
+  } else {
+    velocity_ = velocity;
+  }
+}
+
 void ktp::ProjectilePhysicsComponent::update(const GameEntity& projectile, float delta_time) {
+  // a body was moved by the step, this one moves now
+  if (ray_cast_ && !detonated_) advance(delta_time);
   // collisions
   if (collided_) {
     if (armed_) {
@@ -150,7 +299,7 @@ void ktp::ProjectilePhysicsComponent::update(const GameEntity& projectile, float
     return;
   }
   // update sin & cos
-  const auto angle {body_->GetAngle()};
+  const auto angle {currentAngle()};
   cos_ = SDL_cosf(angle);
   sin_ = SDL_sinf(angle);
   // velocity
@@ -158,24 +307,30 @@ void ktp::ProjectilePhysicsComponent::update(const GameEntity& projectile, float
     armed_ = true;
     delta_.x +=  sin_ * speed_ * delta_time;
     delta_.y += -cos_ * speed_ * delta_time;
-    body_->ApplyLinearImpulseToCenter({delta_.x, delta_.y}, true);
+    if (ray_cast_) {
+      velocity_ += (1.f / mass_) * b2Vec2{delta_.x, delta_.y};
+    } else {
+      body_->ApplyLinearImpulseToCenter({delta_.x, delta_.y}, true);
+    }
   }
   // exhaust emitter position and angle
+  const auto position {currentPosition()};
   exhaust_emitter_->setAngle(angle);
   exhaust_emitter_->setPosition({
-    (body_->GetPosition().x * kMetersToPixels) - size_ * kMetersToPixels * sin_,
-    (body_->GetPosition().y * kMetersToPixels) + size_ * kMetersToPixels * cos_,
+    (position.x * kMetersToPixels) - size_ * kMetersToPixels * sin_,
+    (position.y * kMetersToPixels) + size_ * kMetersToPixels * cos_,
     0.f
   });
   // generate exhaust particles if armed and not out of screen
   if (armed_ && !isOutOfScreen(size_ * 10.f)) exhaust_emitter_->generateParticles();
-  // mvp
-  updateMVP();
+  // render transform
+  updateTransform();
 }
 
-void ktp::ProjectilePhysicsComponent::updateMVP() {
-  glm::mat4 model {1.f};
-  model = glm::translate(model, glm::vec3(body_->GetPosition().x * kMetersToPixels, body_->GetPosition().y * kMetersToPixels, 0.f));
-  model = glm::rotate(model, body_->GetAngle(), glm::vec3(0.f, 0.f, 1.f));
-  graphics_->mvp_ = camera_.projectionMatrix() * camera_.viewMatrix() * model;
+void ktp::ProjectilePhysicsComponent::updateTransform() {
+  const auto position {currentPosition()};
+  graphics_->setTransform({position.x * kMetersToPixels, position.y * kMetersToPixels}, currentAngle());
+  // the laser is 1.5 times its size long from the center
+  const b2Vec2 extent {size_ * 1.5f, size_ * 1.5f};
+  graphics_->setBounds({kMetersToPixels * (position - extent), kMetersToPixels * (position + extent)});
 }
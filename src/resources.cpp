@@ -2,26 +2,184 @@
 #include "sdl2_wrappers/sdl2_log.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include <algorithm> // std::equal std::sort
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <iterator> // std::begin std::end
+#include <set>
 #include <sstream>
 #include <utility>
+#include <vector>
 
-ktp::Resources::FontsMap    ktp::Resources::fonts_map {};
-ktp::Resources::ShadersMap  ktp::Resources::shaders_map {};
-ktp::Resources::TexturesMap ktp::Resources::textures_map {};
+ktp::Resources::FontsMap        ktp::Resources::fonts_map {};
+ktp::Resources::GlyphAtlasesMap ktp::Resources::glyph_atlases_map {};
+ktp::Resources::ShadersMap      ktp::Resources::shaders_map {};
+ktp::Resources::ShaderTagsMap   ktp::Resources::shader_tags {};
+ktp::Resources::TexturesMap     ktp::Resources::textures_map {};
+
+std::string  ktp::Resources::shader_cache_path {};
+unsigned int ktp::Resources::shader_cache_hits {};
+unsigned int ktp::Resources::shader_cache_misses {};
+
+namespace {
+
+constexpr char kProgramBinaryMagic[4] {'A', 'E', 'P', 'B'};
+
+/**
+ * @brief FNV-1a, good enough to tell two sources apart.
+ */
+std::uint64_t hash(const std::string& data, std::uint64_t seed = 14695981039346656037ull) {
+  auto result {seed};
+  for (const auto c: data) {
+    result ^= static_cast<unsigned char>(c);
+    result *= 1099511628211ull;
+  }
+  return result;
+}
+
+std::string glString(GLenum name) {
+  const auto string {glGetString(name)};
+  return string ? reinterpret_cast<const char*>(string) : "";
+}
+
+/**
+ * @brief A binary is only valid for the same sources on the same driver.
+ */
+std::uint64_t shaderCacheKey(const std::string& sources) {
+  return hash(glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION), hash(sources));
+}
+
+bool programBinarySupported() {
+  if (ktp::Resources::shader_cache_path.empty() || !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)) return false;
+  GLint formats {};
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  return formats > 0;
+}
+
+std::string programBinaryPath(const std::string& name) {
+  return ktp::Resources::shader_cache_path + name + ".bin";
+}
+
+/**
+ * @brief Creates a program from the cache.
+ * @return The id of the program, or 0 if it's not cached, stale or refused by the driver.
+ */
+GLuint loadProgramBinary(const std::string& name, std::uint64_t key) {
+  if (!programBinarySupported()) return 0;
+  std::ifstream file {programBinaryPath(name), std::ios::binary};
+  if (!file) return 0;
+  char magic[4] {};
+  std::uint64_t file_key {};
+  GLenum format {};
+  GLint length {};
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&file_key), sizeof(file_key));
+  file.read(reinterpret_cast<char*>(&format), sizeof(format));
+  file.read(reinterpret_cast<char*>(&length), sizeof(length));
+  if (!file || !std::equal(std::begin(magic), std::end(magic), std::begin(kProgramBinaryMagic)) || length <= 0) {
+    ktp::logMessage("Warning! Shader cache for \"" + name + "\" is corrupt. Compiling from source.");
+    return 0;
+  }
+  if (file_key != key) {
+    ktp::logMessage("Shader cache for \"" + name + "\" is stale. Compiling from source.");
+    return 0;
+  }
+  std::vector<char> binary(static_cast<std::size_t>(length));
+  file.read(binary.data(), length);
+  if (!file) return 0;
+  const GLuint id {glCreateProgram()};
+  glProgramBinary(id, format, binary.data(), length);
+  GLint linked {};
+  glGetProgramiv(id, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    // the driver may refuse binaries even with a matching key, ie: after an update
+    ktp::logMessage("Warning! Shader cache for \"" + name + "\" refused by the driver. Compiling from source.");
+    glDeleteProgram(id);
+    return 0;
+  }
+  return id;
+}
+
+/**
+ * @brief Stores a linked program in the cache.
+ */
+void saveProgramBinary(const std::string& name, std::uint64_t key, GLuint id) {
+  if (!programBinarySupported()) return;
+  GLint length {};
+  glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+  std::vector<char> binary(static_cast<std::size_t>(length));
+  GLenum format {};
+  GLsizei written {};
+  glGetProgramBinary(id, length, &written, &format, binary.data());
+  if (written <= 0) return;
+  std::error_code error {};
+  std::filesystem::create_directories(ktp::Resources::shader_cache_path, error);
+  const auto path {programBinaryPath(name)};
+  std::ofstream file {path, std::ios::binary | std::ios::trunc};
+  if (error || !file) {
+    ktp::logError("Could not write the shader cache " + path);
+    return;
+  }
+  const GLint written_length {written};
+  file.write(kProgramBinaryMagic, sizeof(kProgramBinaryMagic));
+  file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+  file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+  file.write(reinterpret_cast<const char*>(&written_length), sizeof(written_length));
+  file.write(binary.data(), written);
+}
+
+// programs already linked, by sources and defines, so permutations are shared
+std::map<std::string, std::string> shader_permutations {};
+
+/**
+ * @brief Adds a #define for every permutation right after the #version line.
+ *  A #line directive keeps the compiler errors pointing at the file lines.
+ */
+std::string injectDefines(const std::string& code, const ktp::Resources::ShaderDefines& defines) {
+  if (defines.empty()) return code;
+  const auto version_end {code.rfind("#version", 0) == 0 ? code.find('\n') : std::string::npos};
+  std::string header {};
+  for (const auto& define: defines) header += "#define " + define + '\n';
+  if (version_end == std::string::npos) return header + "#line 1\n" + code;
+  return code.substr(0, version_end + 1) + header + "#line 2\n" + code.substr(version_end + 1);
+}
+
+} // namespace
 
 void ktp::Resources::cleanOpenGL() {
+  // permutations share their programs, delete each one only once
+  std::set<GLuint> programs {};
   for (auto& [name, shader_id]: shaders_map) {
-    glDeleteProgram(shader_id);
-  }
-  for (auto& [name, texture_id]: textures_map) {
-    glDeleteTextures(1, &texture_id);
+    if (programs.insert(shader_id).second) glDeleteProgram(shader_id);
   }
+  shaders_map.clear();
+  shader_tags.clear();
+  shader_permutations.clear();
+  glyph_atlases_map.clear();
+  textures_map.clear();
 }
 
 /* PATHS */
 
+std::string ktp::Resources::getCachePath(const std::string& sub_dir) {
+  const std::string kPROJECT_NAME = "Aerolits";
+  constexpr auto kCACHE_FOLDER = "cache";
+
+  #ifdef _WIN32
+    constexpr auto kPATH_SEPARATOR = '\\';
+  #else
+    constexpr auto kPATH_SEPARATOR = '/';
+  #endif
+
+  auto path {std::filesystem::current_path().string()};
+  const auto kPos {path.rfind(kPROJECT_NAME) + kPROJECT_NAME.length()};
+
+  path = path.substr(0, kPos) + kPATH_SEPARATOR + kCACHE_FOLDER + kPATH_SEPARATOR;
+  return sub_dir.empty() ? path : path + sub_dir + kPATH_SEPARATOR;
+}
+
 std::string ktp::Resources::getConfigPath(const std::string& sub_dir) {
   const std::string kPROJECT_NAME = "Aerolits";
   constexpr auto kCONFIG_FOLDER = "config";
@@ -66,17 +224,101 @@ void ktp::Resources::loadFont(const std::string& name, const std::string& file,
   }
 }
 
+/* GLYPH ATLASES */
+
+bool ktp::Resources::loadGlyphAtlas(const std::string& name, const std::string& font) {
+  if (!fonts_map.count(font)) {
+    logError("Could NOT create glyph atlas \"" + name + "\". Font \"" + font + "\" not loaded.");
+    return false;
+  }
+  const auto ttf_font {getFont(font)};
+  constexpr int kAtlasWidth {2048};
+  constexpr int kPadding {4};
+  constexpr SDL_Color kWhite {255, 255, 255, 255};
+  GlyphAtlas atlas {};
+  atlas.line_height_ = static_cast<float>(TTF_FontHeight(ttf_font));
+  // render every glyph and find a place for it in the atlas, row by row
+  std::array<SDL_Surface*, 256> surfaces {};
+  std::array<SDL_Point, 256> positions {};
+  int pen_x {0}, pen_y {0}, row_height {0};
+  for (Uint16 ch = 32u; ch < 256u; ++ch) {
+    if (ch >= 127u && ch < 160u) continue; // control characters
+    if (!TTF_GlyphIsProvided(ttf_font, ch)) continue;
+    int min_x {}, max_x {}, min_y {}, max_y {}, advance {};
+    if (TTF_GlyphMetrics(ttf_font, ch, &min_x, &max_x, &min_y, &max_y, &advance) != 0) continue;
+    SDL_Surface* surface {TTF_RenderGlyph_Blended(ttf_font, ch, kWhite)};
+    if (!surface) {
+      logSDL2Error("TTF_RenderGlyph_Blended");
+      continue;
+    }
+    if (pen_x + surface->w > kAtlasWidth) {
+      pen_x = 0;
+      pen_y += row_height + kPadding;
+      row_height = 0;
+    }
+    surfaces[ch] = surface;
+    positions[ch] = {pen_x, pen_y};
+    atlas.glyphs_[ch].size_ = {static_cast<float>(surface->w), static_cast<float>(surface->h)};
+    atlas.glyphs_[ch].advance_ = static_cast<float>(advance);
+    pen_x += surface->w + kPadding;
+    if (surface->h > row_height) row_height = surface->h;
+  }
+  const int atlas_height {pow2RoundUp(pen_y + row_height)};
+  // we only need the coverage, so the atlas is single channel
+  std::vector<Uint8> pixels(kAtlasWidth * atlas_height, 0u);
+  for (std::size_t ch = 0; ch < surfaces.size(); ++ch) {
+    const auto surface {surfaces[ch]};
+    if (!surface) continue;
+    SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; ++y) {
+      const auto row {reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(surface->pixels) + y * surface->pitch)};
+      for (int x = 0; x < surface->w; ++x) {
+        Uint8 r {}, g {}, b {}, a {};
+        SDL_GetRGBA(row[x], surface->format, &r, &g, &b, &a);
+        pixels[(positions[ch].y + y) * kAtlasWidth + positions[ch].x + x] = a;
+      }
+    }
+    SDL_UnlockSurface(surface);
+    atlas.glyphs_[ch].uv_ = {
+      static_cast<float>(positions[ch].x) / kAtlasWidth,
+      static_cast<float>(positions[ch].y) / atlas_height,
+      static_cast<float>(positions[ch].x + surface->w) / kAtlasWidth,
+      static_cast<float>(positions[ch].y + surface->h) / atlas_height
+    };
+    SDL_FreeSurface(surface);
+  }
+  // lets generate the opengl texture
+  // rows of one byte pixels are not 4 bytes aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  atlas.texture_.setup(kAtlasWidth, atlas_height, GL_R8, GL_RED, pixels.data(), true);
+  glCheckError();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  atlas.texture_.label(name + " atlas", MemoryCategory::GUI);
+  atlas.texture_.unbind();
+  // the atlas owns the texture, so cleanOpenGL() takes care of it
+  glyph_atlases_map[name] = std::move(atlas);
+  logMessage("Created glyph atlas \"" + name + "\" (" + std::to_string(kAtlasWidth) + 'x' + std::to_string(atlas_height) + ") from font \"" + font + '\"');
+  return true;
+}
+
 /* SHADERS */
 
-bool ktp::Resources::loadShader(const std::string& name, const std::string& vertex_shader_path, const std::string& fragment_shader_path, const std::string& geometry_shader_path) {
-  // Create the shaders
-	GLuint vertex_shader_id {glCreateShader(GL_VERTEX_SHADER)};
-	GLuint fragment_shader_id {glCreateShader(GL_FRAGMENT_SHADER)};
-  bool geometry_shader_present {};
-  GLuint geometry_shader_id {};
-  if (geometry_shader_path != "") {
-    geometry_shader_present = true;
-    glCreateShader(GL_GEOMETRY_SHADER);
+bool ktp::Resources::loadShader(const std::string& name, const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines, const std::string& geometry_shader_path) {
+  const bool geometry_shader_present {geometry_shader_path != ""};
+  // the same files with the same defines make the same program
+  auto sorted_defines {defines};
+  std::sort(sorted_defines.begin(), sorted_defines.end());
+  std::string permutation {vertex_shader_path + '|' + fragment_shader_path + '|' + geometry_shader_path};
+  for (const auto& define: sorted_defines) permutation += '|' + define;
+  if (const auto found {shader_permutations.find(permutation)}; found != shader_permutations.end()) {
+    shaders_map[name] = shaders_map.at(found->second);
+    shader_tags.emplace(name, static_cast<unsigned int>(shader_tags.size() + 1u));
+    logMessage("Shader program \"" + name + "\" shares the program of \"" + found->second + "\".");
+    return true;
   }
   // Read the Vertex Shader code from the file
 	std::string vertex_shader_code {};
@@ -102,6 +344,8 @@ bool ktp::Resources::loadShader(const std::string& name, const std::string& vert
     logError("Could NOT open fragment shader file", fragment_shader_path);
     return false;
 	}
+  vertex_shader_code = injectDefines(vertex_shader_code, sorted_defines);
+  fragment_shader_code = injectDefines(fragment_shader_code, sorted_defines);
   std::string geometry_shader_code {};
   if (geometry_shader_present) {
     // Read the Geometry Shader code from the file
@@ -115,7 +359,25 @@ bool ktp::Resources::loadShader(const std::string& name, const std::string& vert
       logError("Could NOT open geometry shader file", geometry_shader_path);
       return false;
     }
+    geometry_shader_code = injectDefines(geometry_shader_code, sorted_defines);
+  }
+  // try the binary cache before compiling anything
+  const auto key {shaderCacheKey(vertex_shader_code + fragment_shader_code + geometry_shader_code)};
+  if (const auto cached {loadProgramBinary(name, key)}) {
+    GLDebug::label(GL_PROGRAM, cached, name);
+    shaders_map[name] = cached;
+    shader_tags.emplace(name, static_cast<unsigned int>(shader_tags.size() + 1u));
+    shader_permutations[permutation] = name;
+    ++shader_cache_hits;
+    logMessage("Shader program \"" + name + "\" loaded from the binary cache.");
+    return true;
   }
+  ++shader_cache_misses;
+  // Create the shaders
+	GLuint vertex_shader_id {glCreateShader(GL_VERTEX_SHADER)};
+	GLuint fragment_shader_id {glCreateShader(GL_FRAGMENT_SHADER)};
+  GLuint geometry_shader_id {};
+  if (geometry_shader_present) geometry_shader_id = glCreateShader(GL_GEOMETRY_SHADER);
   // Compile Vertex Shader
   logMessage("Compiling vertex shader " + vertex_shader_path);
 	const auto vertex_source_pointer {vertex_shader_code.c_str()};
@@ -142,6 +404,8 @@ bool ktp::Resources::loadShader(const std::string& name, const std::string& vert
   // Link the program
 	const GLuint id {glCreateProgram()};
   glCheckError();
+  // so glGetProgramBinary() works after linking
+  if (!shader_cache_path.empty()) glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glAttachShader(id, vertex_shader_id);
   glCheckError();
 	glAttachShader(id, fragment_shader_id);
@@ -163,7 +427,11 @@ bool ktp::Resources::loadShader(const std::string& name, const std::string& vert
     glCheckError();
   }
 
+  saveProgramBinary(name, key, id);
+  GLDebug::label(GL_PROGRAM, id, name);
   shaders_map[name] = id;
+  shader_tags.emplace(name, static_cast<unsigned int>(shader_tags.size() + 1u));
+  shader_permutations[permutation] = name;
   logMessage("Shader program \"" + name + "\" successfully compiled and linked.");
   return true;
 }
@@ -214,8 +482,9 @@ bool ktp::Resources::printShaderLog(GLuint shader) {
 
 /* TEXTURES */
 
-void ktp::Resources::loadTexture(const std::string& name, const std::string& file, bool alpha) {
-  GLuint id {};
+void ktp::Resources::loadTexture(const std::string& name, const std::string& file, bool alpha, MemoryCategory category) {
+  // an existing texture is reused, so whoever holds it sees the new image
+  auto& texture {textures_map[name]};
   GLsizei width {}, height {};
   GLint internal_format {GL_RGB};
   GLenum image_format {GL_RGB};
@@ -231,9 +500,9 @@ void ktp::Resources::loadTexture(const std::string& name, const std::string& fil
   stbi_set_flip_vertically_on_load(true);
   auto data {stbi_load(file.c_str(), &width, &height, &num_channels, 0)};
   if (data) {
-    glGenTextures(1, &id);
+    // upload the img data
+    texture.setup(width, height, internal_format, image_format, data, true);
     glCheckError();
-    glBindTexture(GL_TEXTURE_2D, id);
     // set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t);
@@ -241,39 +510,32 @@ void ktp::Resources::loadTexture(const std::string& name, const std::string& fil
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min);
     // When MAGnifying the image (no bigger mipmap available), use XXXX filtering
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_max);
-    // upload the img data
-    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, image_format, GL_UNSIGNED_BYTE, data);
-    glCheckError();
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glCheckError();
+    texture.label(name, category);
     // unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    texture.unbind();
     // free the image
     stbi_image_free(data);
     logMessage("Loaded texture \"" + name + "\" from file " + file);
   } else {
     logError("Could NOT load texture " + file);
   }
-  textures_map[name] = id;
 }
 
-ktp::Texture2D ktp::Resources::loadTextureFromTextBlended(const std::string& name, const std::string& text, const std::string& font, SDL_Color color) {
-  // if already exists, delete the texture
-  if (textures_map.count(name)) glDeleteTextures(1, &textures_map[name]);
+const ktp::Texture2D& ktp::Resources::loadTextureFromTextBlended(const std::string& name, const std::string& text, const std::string& font, SDL_Color color) {
+  // if already exists, the texture is reused
+  auto& texture {textures_map[name]};
   // render a surface, remember to free it when done
   SDL_Surface* surface {TTF_RenderUTF8_Blended(Resources::getFont(font), text.c_str(), color)};
   if (surface) {
-    GLuint id {};
     constexpr GLint internal_format {GL_RGBA};
     GLenum format {};
     constexpr GLint wrap_s {GL_REPEAT}, wrap_t {GL_REPEAT};
     constexpr GLint filter_max {GL_LINEAR}, filter_min {GL_NEAREST};
     // find out the format
     surface->format->Rmask == 255u ? format = GL_RGBA : format = GL_BGRA;
-    // lets generate the opengl texture
-    glGenTextures(1, &id);
+    // upload the surface data
+    texture.setup(surface->w, surface->h, internal_format, format, surface->pixels);
     glCheckError();
-    glBindTexture(GL_TEXTURE_2D, id);
     // set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t);
@@ -281,39 +543,33 @@ ktp::Texture2D ktp::Resources::loadTextureFromTextBlended(const std::string& nam
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min);
     // When MAGnifying the image (no bigger mipmap available)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_max);
-    // upload the surface data
-    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, surface->w, surface->h, 0, format, GL_UNSIGNED_BYTE, surface->pixels);
-    glCheckError();
+    texture.label(name, MemoryCategory::GUI);
     // unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
-    // push it to the textures map
-    Resources::textures_map[name] = id;
+    texture.unbind();
     // free the surface
     SDL_FreeSurface(surface);
-    return Texture2D{id};
+    return texture;
   } else {
     logSDL2Error("TTF_RenderUTF8_Blended");
-    return 0;
+    return texture;
   }
 }
 
-ktp::Texture2D ktp::Resources::loadTextureFromTextSolid(const std::string& name, const std::string& text, const std::string& font, SDL_Color color) {
-  // if already exists, delete the texture
-  if (textures_map.count(name)) glDeleteTextures(1, &textures_map[name]);
+const ktp::Texture2D& ktp::Resources::loadTextureFromTextSolid(const std::string& name, const std::string& text, const std::string& font, SDL_Color color) {
+  // if already exists, the texture is reused
+  auto& texture {textures_map[name]};
   // render a surface, remember to free it when done
   SDL_Surface* surface {TTF_RenderUTF8_Solid(Resources::getFont(font), text.c_str(), color)};
   if (surface) {
-    GLuint id {};
     constexpr GLint internal_format {GL_RGB};
     GLenum format {};
     constexpr GLint wrap_s {GL_REPEAT}, wrap_t {GL_REPEAT};
     constexpr GLint filter_max {GL_LINEAR}, filter_min {GL_NEAREST};
     // find out the image format
     surface->format->Rmask == 255u ? format = GL_RGB : format = GL_BGR;
-    // lets generate the opengl texture
-    glGenTextures(1, &id);
+    // upload the surface data
+    texture.setup(surface->w, surface->h, internal_format, format, surface->pixels);
     glCheckError();
-    glBindTexture(GL_TEXTURE_2D, id);
     // set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t);
@@ -321,18 +577,14 @@ ktp::Texture2D ktp::Resources::loadTextureFromTextSolid(const std::string& name,
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min);
     // When MAGnifying the image (no bigger mipmap available)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_max);
-    // upload the surface data
-    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, surface->w, surface->h, 0, format, GL_UNSIGNED_BYTE, surface->pixels);
-    glCheckError();
+    texture.label(name, MemoryCategory::GUI);
     // unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
-    // push it to the textures map
-    Resources::textures_map[name] = id;
+    texture.unbind();
     // free the surface
     SDL_FreeSurface(surface);
-    return Texture2D{id};
+    return texture;
   } else {
     logSDL2Error("TTF_RenderUTF8_Solid");
-    return 0;
+    return texture;
   }
 }
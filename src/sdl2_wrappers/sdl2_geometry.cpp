@@ -1,4 +1,99 @@
 #include "sdl2_geometry.hpp"
+#include <algorithm> // std::find
+#include <cstring>   // std::memcmp
+
+namespace {
+
+using Piece = std::vector<std::size_t>;
+
+inline float cross(const ktp::Geometry::Point& o, const ktp::Geometry::Point& a, const ktp::Geometry::Point& b) {
+  return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+bool isConvex(const ktp::Geometry::Polygon& polygon, const Piece& piece) {
+  const auto size {piece.size()};
+  for (std::size_t i = 0; i < size; ++i) {
+    if (cross(polygon[piece[i]], polygon[piece[(i + 1) % size]], polygon[piece[(i + 2) % size]]) < 0.f) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Joins two counter-clockwise pieces through the edge a -> b of the
+ *  first one, if the second one has b -> a.
+ * @return The joined piece, or an empty one if they don't share the edge.
+ */
+Piece join(const Piece& first, const Piece& second) {
+  const auto first_size {first.size()}, second_size {second.size()};
+  for (std::size_t i = 0; i < first_size; ++i) {
+    const auto a {first[i]}, b {first[(i + 1) % first_size]};
+    for (std::size_t j = 0; j < second_size; ++j) {
+      if (second[j] != b || second[(j + 1) % second_size] != a) continue;
+      Piece joined {};
+      joined.reserve(first_size + second_size - 2u);
+      // b around the first piece up to a, then on the second piece back to b
+      for (std::size_t k = 1; k <= first_size; ++k) joined.push_back(first[(i + k) % first_size]);
+      for (std::size_t k = 2; k < second_size; ++k) joined.push_back(second[(j + k) % second_size]);
+      return joined;
+    }
+  }
+  return {};
+}
+
+} // namespace
+
+bool ktp::Geometry::convexPartition(const Polygon& polygon, std::vector<Polygon>& result, std::size_t max_vertices) {
+  auto vertices {polygon.size()};
+  // closed polygons repeat the first point at the end, an exact copy of its bits
+  if (vertices > 3 && std::memcmp(&polygon.front(), &polygon.back(), sizeof(Point)) == 0) --vertices;
+  if (vertices < 3 || max_vertices < 3) return false;
+
+  // we want a counter-clockwise polygon
+  const Polygon open {polygon.begin(), polygon.begin() + vertices};
+  Piece whole(vertices);
+  const bool ccw {area(open) > 0.f};
+  for (std::size_t i = 0; i < vertices; ++i) whole[i] = ccw ? i : (vertices - 1) - i;
+
+  std::vector<Piece> pieces {};
+  if (isConvex(polygon, whole)) {
+    // fans of max_vertices around the first vertex, the fewest pieces possible
+    for (std::size_t first = 1; first + 1 < vertices; first += max_vertices - 2u) {
+      Piece piece {whole[0]};
+      for (std::size_t i = first; i < vertices && i < first + max_vertices - 1u; ++i) piece.push_back(whole[i]);
+      pieces.push_back(std::move(piece));
+    }
+  } else {
+    std::vector<std::size_t> triangles {};
+    if (triangulateIndices(open, triangles) == 0) return false;
+    pieces.reserve(triangles.size() / 3);
+    for (std::size_t i = 0; i < triangles.size(); i += 3) {
+      pieces.push_back({triangles[i], triangles[i + 1], triangles[i + 2]});
+    }
+    // drop every diagonal that leaves a convex piece that fits
+    for (bool merged {true}; merged;) {
+      merged = false;
+      for (std::size_t i = 0; i < pieces.size() && !merged; ++i) {
+        for (std::size_t j = i + 1; j < pieces.size() && !merged; ++j) {
+          if (pieces[i].size() + pieces[j].size() - 2u > max_vertices) continue;
+          auto joined {join(pieces[i], pieces[j])};
+          if (joined.empty() || !isConvex(polygon, joined)) continue;
+          pieces[i] = std::move(joined);
+          pieces.erase(pieces.begin() + static_cast<std::ptrdiff_t>(j));
+          merged = true;
+        }
+      }
+    }
+  }
+
+  result.reserve(result.size() + pieces.size());
+  for (const auto& piece: pieces) {
+    Polygon convex {};
+    convex.reserve(piece.size());
+    for (const auto index: piece) convex.push_back(polygon[index]);
+    result.push_back(std::move(convex));
+  }
+  return true;
+}
 
 bool ktp::Geometry::insideTriangle(const Triangle& triangle, Point point) {
   const Point a {triangle.c.x - triangle.b.x, triangle.c.y - triangle.b.y};
@@ -17,154 +112,37 @@ bool ktp::Geometry::insideTriangle(const Triangle& triangle, Point point) {
 }
 
 bool ktp::Geometry::triangulate(const Polygon& polygon, std::vector<Polygon>& result, bool close) {
-  const auto vertices {polygon.size()};
-  if (vertices < 3) return false;
-
-  std::vector<std::size_t> V {};
-  V.resize(vertices);
-
-  // we want a counter-clockwise polygon in V
-  if (area(polygon) > 0.f) {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = i;
-  }
-  else {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = (vertices - 1) - i;
-  }
-
-  auto nv {vertices};
-  // remove nv-2 Vertices, creating 1 triangle every time
-  auto count {2 * nv};   // error detection
-
-  for (std::size_t i = 0, v = nv - 1; nv > 2; ++i) {
-    // if we loop, it is probably a non-simple polygon
-    if (0 >= (count--)) return false; // Triangulate: ERROR - probable bad polygon!
-
-    // three consecutive vertices in current polygon, <u,v,w>
-    auto u {v};
-    if (nv <= u) u = 0; // previous
-    v = u + 1u;
-    if (nv <= v) v = 0; // new v
-    auto w {v + 1u};
-    if (nv <= w) w = 0; // next
-
-    if (snip(polygon, u, v, w, nv, V)) {
-      std::size_t a{V[u]}, b{V[v]}, c{V[w]}, s{}, t{};
-      // output Triangle
-      if (close) {
-        result.push_back({polygon[a], polygon[b], polygon[c], polygon[a]});
-      } else {
-        result.push_back({polygon[a], polygon[b], polygon[c]});
-      }
-      // remove v from remaining polygon
-      for (s = v, t = v + 1; t < nv; ++s, ++t) V[s] = V[t];
-      --nv;
-      // reset error detection counter
-      count = 2 * nv;
+  std::vector<std::size_t> indices {};
+  if (triangulateIndices(polygon, indices) == 0) return false;
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const auto& a {polygon[indices[i]]};
+    if (close) {
+      result.push_back({a, polygon[indices[i + 1]], polygon[indices[i + 2]], a});
+    } else {
+      result.push_back({a, polygon[indices[i + 1]], polygon[indices[i + 2]]});
     }
   }
   return true;
 }
 
 bool ktp::Geometry::triangulate(const Polygon& polygon, std::vector<Triangle>& result) {
-  const auto vertices {polygon.size()};
-  if (vertices < 3) return false;
-
-  std::vector<std::size_t> V {};
-  V.resize(vertices);
-
-  // we want a counter-clockwise polygon in V
-  if (area(polygon) > 0.f) {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = i;
-  }
-  else {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = (vertices - 1) - i;
-  }
-
-  auto nv {vertices};
-  // remove nv-2 Vertices, creating 1 triangle every time
-  auto count {2 * nv};   // error detection
-
-  for (std::size_t i = 0, v = nv - 1; nv > 2; ++i) {
-    // if we loop, it is probably a non-simple polygon
-    if (0 >= (count--)) return false; // Triangulate: ERROR - probable bad polygon!
-
-    // three consecutive vertices in current polygon, <u,v,w>
-    auto u {v};
-    if (nv <= u) u = 0; // previous
-    v = u + 1u;
-    if (nv <= v) v = 0; // new v
-    auto w {v + 1u};
-    if (nv <= w) w = 0; // next
-
-    if (snip(polygon, u, v, w, nv, V)) {
-      std::size_t a{V[u]}, b{V[v]}, c{V[w]}, s{}, t{};
-      // output Triangle
-      result.push_back({polygon[a], polygon[b], polygon[c]});
-      // remove v from remaining polygon
-      for (s = v, t = v + 1; t < nv; ++s, ++t) V[s] = V[t];
-      --nv;
-      // reset error detection counter
-      count = 2 * nv;
-    }
+  std::vector<std::size_t> indices {};
+  if (triangulateIndices(polygon, indices) == 0) return false;
+  result.reserve(result.size() + indices.size() / 3);
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    result.push_back({polygon[indices[i]], polygon[indices[i + 1]], polygon[indices[i + 2]]});
   }
   return true;
 }
 
 bool ktp::Geometry::triangulate(const Polygon& polygon, std::vector<GLfloat>& result) {
-  const auto vertices {polygon.size()};
-  if (vertices < 3) return false;
-
-  std::vector<std::size_t> V {};
-  V.resize(vertices);
-
-  // we want a counter-clockwise polygon in V
-  if (area(polygon) > 0.f) {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = i;
-  }
-  else {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = (vertices - 1) - i;
-  }
-
-  auto nv {vertices};
-  // remove nv-2 Vertices, creating 1 triangle every time
-  auto count {2 * nv};   // error detection
-
-  for (std::size_t i = 0, v = nv - 1; nv > 2; ++i) {
-    // if we loop, it is probably a non-simple polygon
-    if (0 >= (count--)) return false; // Triangulate: ERROR - probable bad polygon!
-
-    // three consecutive vertices in current polygon, <u,v,w>
-    auto u {v};
-    if (nv <= u) u = 0; // previous
-    v = u + 1u;
-    if (nv <= v) v = 0; // new v
-    auto w {v + 1u};
-    if (nv <= w) w = 0; // next
-
-    if (snip(polygon, u, v, w, nv, V)) {
-      std::size_t a{V[u]}, b{V[v]}, c{V[w]}, s{}, t{};
-      // output Triangle
-      result.push_back(polygon[a].x);
-      result.push_back(polygon[a].y);
-      result.push_back(0.f);
-      result.push_back(polygon[b].x);
-      result.push_back(polygon[b].y);
-      result.push_back(0.f);
-      result.push_back(polygon[c].x);
-      result.push_back(polygon[c].y);
-      result.push_back(0.f);
-      // remove v from remaining polygon
-      for (s = v, t = v + 1; t < nv; ++s, ++t) V[s] = V[t];
-      --nv;
-      // reset error detection counter
-      count = 2 * nv;
-    }
+  std::vector<std::size_t> indices {};
+  if (triangulateIndices(polygon, indices) == 0) return false;
+  result.reserve(result.size() + indices.size() * 3);
+  for (const auto index: indices) {
+    result.push_back(polygon[index].x);
+    result.push_back(polygon[index].y);
+    result.push_back(0.f);
   }
   return true;
 }
@@ -71,6 +71,20 @@ float area(const std::vector<T>& polygon) {
   return area * 0.5f;
 }
 
+/**
+ * @brief Splits a polygon in the fewest convex pieces it can, none with more
+ *  than max_vertices. Convex polygons are cut in fans, so the ones that fit
+ *  come back as they are. The rest are triangulated and the triangles merged
+ *  through their shared diagonals while the result stays convex
+ *  (Hertel-Mehlhorn). **Doesn't work with
+ *  polygons with inner holes.**
+ * @param polygon The polygon to split, open or closed.
+ * @param result Where to store the pieces, open and counter-clockwise.
+ * @param max_vertices The most vertices a piece can have, at least 3.
+ * @return True if all went ok.
+ */
+bool convexPartition(const Polygon& polygon, std::vector<Polygon>& result, std::size_t max_vertices);
+
 /**
  * @brief Returns the distance between 2 points.
  * @tparam T A point type, ie: SDL_Point, ktp::Point.
@@ -200,6 +214,108 @@ bool snip(const std::vector<T>& polygon, U u, V v, W w, X n, const std::vector<Y
   return true;
 }
 
+/**
+ * @brief Divides a polygon in triangles and writes the indices of their points,
+ *  so nothing is copied and there are no duplicates to remove later. Convex
+ *  polygons, and polygons star-shaped around center, are fanned in O(n). The
+ *  rest fall back to ear clipping. **Doesn't work with polygons with inner holes.**
+ * @tparam T Some object resembling a point (x, y), ie: SDL_Point, SDL_FPoint, ktp::Point.
+ * @tparam Index Some integer type.
+ * @param polygon The polygon to triangularize, without the first point repeated at the end.
+ * @param indices Where to append the indices, 3 per counter-clockwise triangle.
+ * @param center A point the polygon may be star-shaped around, or nullptr.
+ *  If it's used, its index is polygon.size().
+ * @return How many points the indices use: polygon.size(), or polygon.size() + 1
+ *  if the center was used. 0 if it went wrong, with nothing appended.
+ */
+template<typename T, typename Index>
+std::size_t triangulateIndices(const std::vector<T>& polygon, std::vector<Index>& indices, const T* center = nullptr) {
+  const auto vertices {polygon.size()};
+  if (vertices < 3) return 0;
+
+  // we want a counter-clockwise polygon
+  const bool ccw {area(polygon) > 0.f};
+  const auto index = [&](std::size_t i) { return ccw ? i : (vertices - 1) - i; };
+  const auto cross = [](float ox, float oy, const T& a, const T& b) {
+    return (static_cast<float>(a.x) - ox) * (static_cast<float>(b.y) - oy) - (static_cast<float>(a.y) - oy) * (static_cast<float>(b.x) - ox);
+  };
+
+  // one pass to see if a fan is enough
+  bool convex {true}, star {center != nullptr};
+  unsigned int crossings {};
+  for (std::size_t i = 0; i < vertices && (convex || star); ++i) {
+    const auto& a {polygon[index(i)]};
+    const auto& b {polygon[index((i + 1) % vertices)]};
+    const auto& c {polygon[index((i + 2) % vertices)]};
+    if (convex && cross(static_cast<float>(a.x), static_cast<float>(a.y), b, c) < 0.f) convex = false;
+    if (star) {
+      const auto cx {static_cast<float>(center->x)}, cy {static_cast<float>(center->y)};
+      // the center must see every edge turning left...
+      if (cross(cx, cy, a, b) <= 0.f) star = false;
+      // ...and go around it only once
+      if (static_cast<float>(a.y) < cy && static_cast<float>(b.y) >= cy) ++crossings;
+    }
+  }
+
+  if (convex) {
+    indices.reserve(indices.size() + 3 * (vertices - 2));
+    for (std::size_t i = 1; i + 1 < vertices; ++i) {
+      indices.push_back(static_cast<Index>(index(0)));
+      indices.push_back(static_cast<Index>(index(i)));
+      indices.push_back(static_cast<Index>(index(i + 1)));
+    }
+    return vertices;
+  }
+  if (star && crossings == 1u) {
+    indices.reserve(indices.size() + 3 * vertices);
+    for (std::size_t i = 0; i < vertices; ++i) {
+      indices.push_back(static_cast<Index>(vertices));
+      indices.push_back(static_cast<Index>(index(i)));
+      indices.push_back(static_cast<Index>(index((i + 1) % vertices)));
+    }
+    return vertices + 1;
+  }
+
+  // ear clipping
+  std::vector<std::size_t> V(vertices);
+  for (std::size_t i = 0; i < vertices; ++i) V[i] = index(i);
+
+  const auto first {indices.size()};
+  indices.reserve(first + 3 * (vertices - 2));
+  auto nv {vertices};
+  // remove nv-2 Vertices, creating 1 triangle every time
+  auto count {2 * nv};   // error detection
+
+  for (std::size_t v = nv - 1; nv > 2;) {
+    // if we loop, it is probably a non-simple polygon
+    if (0 >= (count--)) {
+      indices.resize(first);
+      return 0; // Triangulate: ERROR - probable bad polygon!
+    }
+
+    // three consecutive vertices in current polygon, <u,v,w>
+    auto u {v};
+    if (nv <= u) u = 0; // previous
+    v = u + 1u;
+    if (nv <= v) v = 0; // new v
+    auto w {v + 1u};
+    if (nv <= w) w = 0; // next
+
+    if (snip(polygon, u, v, w, nv, V)) {
+      // output Triangle
+      indices.push_back(static_cast<Index>(V[u]));
+      indices.push_back(static_cast<Index>(V[v]));
+      indices.push_back(static_cast<Index>(V[w]));
+      // remove v from remaining polygon
+      for (std::size_t s = v, t = v + 1; t < nv; ++s, ++t) V[s] = V[t];
+      --nv;
+      // reset error detection counter
+      count = 2 * nv;
+    }
+  }
+  return vertices;
+}
+
 /**
  * @brief Divides a polygon in triangles. **Doesn't work with polygons with inner holes.**
  * @param polygon The polygon to triangularize, or tessellate.
@@ -235,51 +351,10 @@ bool triangulate(const Polygon& polygon, std::vector<GLfloat>& result);
  */
 template<typename T>
 bool triangulate(const std::vector<T>& polygon, std::vector<T>& result) {
-  const auto vertices {polygon.size()};
-  if (vertices < 3) return false;
-
-  std::vector<std::size_t> V {};
-  V.resize(vertices);
-
-  // we want a counter-clockwise polygon in V
-  if (area(polygon) > 0.f) {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = i;
-  }
-  else {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = (vertices - 1) - i;
-  }
-
-  auto nv {vertices};
-  // remove nv-2 Vertices, creating 1 triangle every time
-  auto count {2 * nv};   // error detection
-
-  for (std::size_t i = 0, v = nv - 1; nv > 2; ++i) {
-    // if we loop, it is probably a non-simple polygon
-    if (0 >= (count--)) return false; // Triangulate: ERROR - probable bad polygon!
-
-    // three consecutive vertices in current polygon, <u,v,w>
-    auto u {v};
-    if (nv <= u) u = 0; // previous
-    v = u + 1u;
-    if (nv <= v) v = 0; // new v
-    auto w {v + 1u};
-    if (nv <= w) w = 0; // next
-
-    if (snip(polygon, u, v, w, nv, V)) {
-      std::size_t a{V[u]}, b{V[v]}, c{V[w]}, s{}, t{};
-      // output Triangle
-      result.push_back(polygon[a]);
-      result.push_back(polygon[b]);
-      result.push_back(polygon[c]);
-      // remove v from remaining polygon
-      for (s = v, t = v + 1; t < nv; ++s, ++t) V[s] = V[t];
-      --nv;
-      // reset error detection counter
-      count = 2 * nv;
-    }
-  }
+  std::vector<std::size_t> indices {};
+  if (triangulateIndices(polygon, indices) == 0) return false;
+  result.reserve(result.size() + indices.size());
+  for (const auto index: indices) result.push_back(polygon[index]);
   return true;
 }
 
@@ -293,51 +368,14 @@ bool triangulate(const std::vector<T>& polygon, std::vector<T>& result) {
  */
 template<typename T>
 bool triangulate(const std::vector<T>& polygon, std::vector<std::vector<T>>& result, bool close = false) {
-  const auto vertices {polygon.size()};
-  if (vertices < 3) return false;
-
-  std::vector<std::size_t> V {};
-  V.resize(vertices);
-
-  // we want a counter-clockwise polygon in V
-  if (area(polygon) > 0.f) {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = i;
-  }
-  else {
-    for (auto i = 0u; i < vertices; ++i)
-      V[i] = (vertices - 1) - i;
-  }
-
-  auto nv {vertices};
-  // remove nv-2 Vertices, creating 1 triangle every time
-  auto count {2 * nv};   // error detection
-
-  for (std::size_t i = 0, v = nv - 1; nv > 2; ++i) {
-    // if we loop, it is probably a non-simple polygon
-    if (0 >= (count--)) return false; // Triangulate: ERROR - probable bad polygon!
-
-    // three consecutive vertices in current polygon, <u,v,w>
-    auto u {v};
-    if (nv <= u) u = 0; // previous
-    v = u + 1u;
-    if (nv <= v) v = 0; // new v
-    auto w {v + 1u};
-    if (nv <= w) w = 0; // next
-
-    if (snip(polygon, u, v, w, nv, V)) {
-      std::size_t a{V[u]}, b{V[v]}, c{V[w]}, s{}, t{};
-      // output Triangle
-      if (close) {
-        result.push_back({polygon[a], polygon[b], polygon[c], polygon[a]});
-      } else {
-        result.push_back({polygon[a], polygon[b], polygon[c]});
-      }
-      // remove v from remaining polygon
-      for (s = v, t = v + 1; t < nv; ++s, ++t) V[s] = V[t];
-      --nv;
-      // reset error detection counter
-      count = 2 * nv;
+  std::vector<std::size_t> indices {};
+  if (triangulateIndices(polygon, indices) == 0) return false;
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const auto& a {polygon[indices[i]]};
+    if (close) {
+      result.push_back({a, polygon[indices[i + 1]], polygon[indices[i + 2]], a});
+    } else {
+      result.push_back({a, polygon[indices[i + 1]], polygon[indices[i + 2]]});
     }
   }
   return true;
@@ -33,6 +33,20 @@ class SDL2_Image {
     return true;
   }
 
+  /**
+   * @brief Saves a surface to a PNG file.
+   * @param surface The surface to save.
+   * @param path The path of the file.
+   * @return True on success, or false on errors.
+   */
+  static bool savePNG(SDL_Surface* surface, const std::string& path) {
+    if (IMG_SavePNG(surface, path.c_str()) != 0) {
+      logSDL2Error("IMG_SavePNG", path);
+      return false;
+    }
+    return true;
+  }
+
  private:
 
   static void queryImageVersions() {
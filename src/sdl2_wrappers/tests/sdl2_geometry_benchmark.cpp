@@ -0,0 +1,140 @@
+#include "../sdl2_geometry.hpp"
+#include <box2d/box2d.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kPolygons {2000u};
+constexpr int         kRounds {20};
+
+/**
+ * @brief Same shapes as AerolitePhysicsComponent::generateAeroliteShape().
+ */
+ktp::Geometry::Polygon aeroliteShape(std::mt19937& engine) {
+  std::uniform_int_distribution<unsigned int> sides_distribution {30u, 40u};
+  std::uniform_real_distribution<float> size_distribution {0.82f, 1.f};
+  const auto sides {sides_distribution(engine)};
+  ktp::Geometry::Polygon shape {};
+  shape.reserve(sides);
+  for (auto i = 0u; i < sides; ++i) {
+    const auto f_size {2.f * size_distribution(engine)};
+    shape.push_back({f_size * SDL_cosf(2.f * b2_pi * (float)i / (float)sides), f_size * SDL_sinf(2.f * b2_pi * (float)i / (float)sides)});
+  }
+  return shape;
+}
+
+/**
+ * @brief What the aerolites did before: the triangles as floats, and the
+ *  duplicates removed afterwards with the nested loop EBO::generateEBO() had.
+ */
+std::size_t legacy(const ktp::Geometry::Polygon& polygon, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) {
+  vertices.clear();
+  indices.clear();
+  const auto size {polygon.size()};
+  std::vector<std::size_t> V(size);
+  if (ktp::Geometry::area(polygon) > 0.f) {
+    for (std::size_t i = 0; i < size; ++i) V[i] = i;
+  } else {
+    for (std::size_t i = 0; i < size; ++i) V[i] = (size - 1) - i;
+  }
+  auto nv {size};
+  auto count {2 * nv};
+  for (std::size_t v = nv - 1; nv > 2;) {
+    if (0 >= (count--)) return 0;
+    auto u {v};
+    if (nv <= u) u = 0;
+    v = u + 1u;
+    if (nv <= v) v = 0;
+    auto w {v + 1u};
+    if (nv <= w) w = 0;
+    if (ktp::Geometry::snip(polygon, u, v, w, nv, V)) {
+      for (const auto index: {V[u], V[v], V[w]}) {
+        vertices.push_back(polygon[index].x);
+        vertices.push_back(polygon[index].y);
+        vertices.push_back(0.f);
+      }
+      for (std::size_t s = v, t = v + 1; t < nv; ++s, ++t) V[s] = V[t];
+      --nv;
+      count = 2 * nv;
+    }
+  }
+  std::vector<GLfloat> unique_coords {};
+  for (std::size_t i = 0; i < vertices.size(); i += 3) {
+    bool found {false};
+    for (std::size_t j = 0; j < unique_coords.size(); j += 3) {
+      if (vertices[i] == unique_coords[j] && vertices[i + 1] == unique_coords[j + 1] && vertices[i + 2] == unique_coords[j + 2]) {
+        found = true;
+        indices.push_back(static_cast<GLuint>(j / 3u));
+        break;
+      }
+    }
+    if (!found) {
+      unique_coords.push_back(vertices[i]);
+      unique_coords.push_back(vertices[i + 1]);
+      unique_coords.push_back(vertices[i + 2]);
+      indices.push_back(static_cast<GLuint>((unique_coords.size() - 1u) / 3u));
+    }
+  }
+  vertices = unique_coords;
+  return vertices.size() / 3u;
+}
+
+/**
+ * @brief The new way: the indices straight away, and the points copied once.
+ */
+std::size_t indexed(const ktp::Geometry::Polygon& polygon, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, const ktp::Geometry::Point* center) {
+  vertices.clear();
+  indices.clear();
+  const auto count {ktp::Geometry::triangulateIndices(polygon, indices, center)};
+  vertices.reserve(count * 3u);
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& point {i < polygon.size() ? polygon[i] : *center};
+    vertices.push_back(point.x);
+    vertices.push_back(point.y);
+    vertices.push_back(0.f);
+  }
+  return count;
+}
+
+template<typename Function>
+void run(const char* name, const std::vector<ktp::Geometry::Polygon>& polygons, Function function) {
+  std::vector<GLfloat> vertices {};
+  std::vector<GLuint> indices {};
+  std::size_t triangles {}, points {};
+  const auto start {Clock::now()};
+  for (int round = 0; round < kRounds; ++round) {
+    for (const auto& polygon: polygons) {
+      points += function(polygon, vertices, indices);
+      triangles += indices.size() / 3u;
+    }
+  }
+  const std::chrono::duration<double, std::micro> elapsed {Clock::now() - start};
+  const auto calls {static_cast<double>(kRounds * polygons.size())};
+  std::printf("%-26s %9.3f us/polygon %7.2f triangles %7.2f vertices\n",
+    name, elapsed.count() / calls, static_cast<double>(triangles) / calls, static_cast<double>(points) / calls);
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 engine {1234u};
+  std::vector<ktp::Geometry::Polygon> polygons {};
+  polygons.reserve(kPolygons);
+  for (std::size_t i = 0; i < kPolygons; ++i) polygons.push_back(aeroliteShape(engine));
+
+  const ktp::Geometry::Point origin {0.f, 0.f};
+  std::printf("%zu aerolite shapes, %d rounds\n", kPolygons, kRounds);
+  run("ear clipping + dedupe", polygons, legacy);
+  run("indices, ear clipping", polygons, [](const auto& polygon, auto& vertices, auto& indices) {
+    return indexed(polygon, vertices, indices, nullptr);
+  });
+  run("indices, star fan", polygons, [&origin](const auto& polygon, auto& vertices, auto& indices) {
+    return indexed(polygon, vertices, indices, &origin);
+  });
+  return 0;
+}
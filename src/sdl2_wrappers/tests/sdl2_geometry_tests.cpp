@@ -108,6 +108,42 @@ TEST(AreaTests, CalculatesArea) {
   EXPECT_FLOAT_EQ(area, (4 * 2) / 2) << "The area of this triangle should be 4.";
 }
 
+TEST(ConvexPartitionTests, HandlesBadPolygon) {
+  ktp::Geometry::Polygon polygon {{0, 0}, {1, 1}};
+  std::vector<ktp::Geometry::Polygon> pieces {};
+  EXPECT_FALSE(ktp::Geometry::convexPartition(polygon, pieces, 8)) << "Bad polygons can't be partitioned.";
+  EXPECT_TRUE(pieces.empty()) << "Bad polygons shouldn't give any pieces.";
+}
+
+TEST(ConvexPartitionTests, KeepsConvexPolygons) {
+  const ktp::Geometry::Polygon polygon {{0, 0}, {3, 0}, {3, 2}, {0, 2}, {0, 0}};
+  std::vector<ktp::Geometry::Polygon> pieces {};
+  EXPECT_TRUE(ktp::Geometry::convexPartition(polygon, pieces, 8));
+  ASSERT_EQ(pieces.size(), 1u) << "A convex polygon that fits should be a single piece.";
+  EXPECT_EQ(pieces[0].size(), 4u) << "The closing point shouldn't be in the piece.";
+  EXPECT_FLOAT_EQ(ktp::Geometry::area(pieces[0]), 6.f) << "The piece should be counter-clockwise.";
+}
+
+TEST(ConvexPartitionTests, SplitsConcavePolygons) {
+  // an L, clockwise
+  const ktp::Geometry::Polygon polygon {{0, 0}, {0, 2}, {1, 2}, {1, 1}, {2, 1}, {2, 0}};
+  std::vector<ktp::Geometry::Polygon> pieces {};
+  EXPECT_TRUE(ktp::Geometry::convexPartition(polygon, pieces, 8));
+  EXPECT_EQ(pieces.size(), 2u) << "An L should be split in 2 pieces.";
+  auto area {0.f};
+  for (const auto& piece: pieces) area += ktp::Geometry::area(piece);
+  EXPECT_FLOAT_EQ(area, 3.f) << "The pieces should cover the whole polygon.";
+}
+
+TEST(ConvexPartitionTests, LimitsVertices) {
+  ktp::Geometry::Polygon polygon {};
+  for (auto i = 0; i < 12; ++i) polygon.push_back({SDL_cosf(2.f * b2_pi * i / 12.f), SDL_sinf(2.f * b2_pi * i / 12.f)});
+  std::vector<ktp::Geometry::Polygon> pieces {};
+  EXPECT_TRUE(ktp::Geometry::convexPartition(polygon, pieces, 8));
+  EXPECT_EQ(pieces.size(), 2u) << "A 12 sided polygon should fit in 2 pieces of 8 vertices.";
+  for (const auto& piece: pieces) EXPECT_LE(piece.size(), 8u) << "No piece should have more than 8 vertices.";
+}
+
 TEST(DistanceBetweenPointsTests, CalculatesDistance) {
   ktp::Geometry::Point a{1, 1}, b{2, 1};
   auto distance = ktp::Geometry::distanceBetweenPoints(a, b);
@@ -125,3 +161,41 @@ TEST(InsideTriangleTests, IsInsideATriangle) {
   point = {2, 3};
   EXPECT_TRUE(ktp::Geometry::insideTriangle(triangle, point)) << "This point should be inside the triangle.";
 }
+
+TEST(TriangulateIndicesTests, FansConvexPolygons) {
+  // a square, clockwise
+  const ktp::Geometry::Polygon polygon {{0, 0}, {0, 1}, {1, 1}, {1, 0}};
+  std::vector<unsigned int> indices {};
+  EXPECT_EQ(ktp::Geometry::triangulateIndices(polygon, indices), 4u);
+  EXPECT_EQ(indices.size(), 6u) << "A square should have 2 triangles.";
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const ktp::Geometry::Polygon triangle {polygon[indices[i]], polygon[indices[i + 1]], polygon[indices[i + 2]]};
+    EXPECT_GT(ktp::Geometry::area(triangle), 0.f) << "Triangles should be counter-clockwise.";
+  }
+}
+
+TEST(TriangulateIndicesTests, FansStarShapedPolygons) {
+  // a star around the origin
+  ktp::Geometry::Polygon polygon {};
+  for (auto i = 0u; i < 10u; ++i) {
+    const auto radius {i % 2u == 0u ? 2.f : 1.f};
+    polygon.push_back({radius * SDL_cosf(2.f * b2_pi * i / 10.f), radius * SDL_sinf(2.f * b2_pi * i / 10.f)});
+  }
+  const ktp::Geometry::Point center {0.f, 0.f};
+  std::vector<unsigned int> indices {};
+  EXPECT_EQ(ktp::Geometry::triangulateIndices(polygon, indices, &center), 11u) << "The center should be used.";
+  EXPECT_EQ(indices.size(), 30u) << "A star should have a triangle for every side.";
+  // the center doesn't see every side of an L
+  const ktp::Geometry::Polygon l_shape {{0, 0}, {2, 0}, {2, 1}, {1, 1}, {1, 2}, {0, 2}};
+  const ktp::Geometry::Point corner {1.9f, 1.9f};
+  indices.clear();
+  EXPECT_EQ(ktp::Geometry::triangulateIndices(l_shape, indices, &corner), 6u) << "The center shouldn't be used.";
+  EXPECT_EQ(indices.size(), 12u);
+}
+
+TEST(TriangulateIndicesTests, HandlesBadPolygon) {
+  const ktp::Geometry::Polygon polygon {{0, 0}, {1, 1}};
+  std::vector<unsigned int> indices {};
+  EXPECT_EQ(ktp::Geometry::triangulateIndices(polygon, indices), 0u);
+  EXPECT_TRUE(indices.empty());
+}
@@ -1,5 +1,8 @@
 #include "include/aerolite.hpp"
 #include "include/box2d_utils.hpp"
+#include "include/debug_draw.hpp"
+#include "include/emitter.hpp"
+#include "include/game_entity.hpp"
 #include "include/palette.hpp"
 #include "include/random.hpp"
 #include "include/resources.hpp"
@@ -8,58 +11,266 @@
 #include "sdl2_wrappers/sdl2_geometry.hpp"
 #include "sdl2_wrappers/sdl2_log.hpp"
 #include "sdl2_wrappers/sdl2_timer.hpp"
+#include <algorithm> // std::find_if
+#include <cmath> // std::cbrt std::ceil
+#include <limits> // std::numeric_limits
+#include <string> // std::to_string
+
+namespace {
+  // milliseconds elapsed since a performance counter value
+  double elapsedMs(Uint64 since) {
+    return static_cast<double>(SDL_GetPerformanceCounter() - since) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+  }
+  constexpr auto kBenchmarkEmitter {"benchmark"};
+}
+
+void ktp::Testing::beginFrame() {
+  frame_start_ = pass_start_ = SDL_GetPerformanceCounter();
+}
 
 void ktp::Testing::draw() {
+  if (scenario_ != BenchmarkScenario::Cubes || cubes_count_ == 0) return;
   shader_program_.use();
   vao_.bind();
-  glDrawArraysInstanced(GL_TRIANGLES, 0, vertices_data_.size(), kNumCubes_);
+  glDrawArraysInstanced(GL_TRIANGLES, 0, vertices_data_.size() / 3u, cubes_count_);
+}
+
+void ktp::Testing::drawDebug(DebugDraw& debug_draw) const {
+  if (!drawsDebug()) return;
+  // a third of each primitive type
+  for (std::size_t i = 0; i < debug_primitives_.size(); ++i) {
+    const auto& primitive {debug_primitives_[i]};
+    switch (i % 3u) {
+      case 0u:
+        debug_draw.DrawSolidCircle(primitive.position_, primitive.radius_, {1.f, 0.f}, primitive.color_);
+        break;
+      case 1u:
+        debug_draw.DrawCircle(primitive.position_, primitive.radius_, primitive.color_);
+        break;
+      default:
+        debug_draw.DrawSegment(primitive.position_, primitive.end_, primitive.color_);
+        break;
+    }
+  }
+}
+
+void ktp::Testing::endFrame() {
+  const auto frame_time {elapsedMs(frame_start_)};
+  const auto passes {frame_passes_};
+  frame_passes_.fill(0.0);
+  if (finished_) return;
+  if (++window_frames_ <= kWarmupFrames_) return;
+  sampled_frame_time_ += frame_time;
+  for (std::size_t i = 0; i < passes.size(); ++i) sampled_passes_[i] += passes[i];
+  if (++sampled_frames_ < kSampleFrames_) return;
+  // the window is complete
+  const auto average {sampled_frame_time_ / sampled_frames_};
+  PassTimes average_passes {};
+  for (std::size_t i = 0; i < average_passes.size(); ++i) average_passes[i] = sampled_passes_[i] / sampled_frames_;
+  const auto held {average <= config_.threshold_};
+  if (ramp_) {
+    if (held) {
+      sustained_count_ = load();
+      sustained_frame_time_ = average;
+      sustained_passes_ = average_passes;
+    }
+    if (held && !limited_) {
+      logMessage("Benchmark " + scenarioToString(scenario_) + ": " + std::to_string(load()) + " held at " + std::to_string(average) + "ms");
+      count_ += config_.ramp_step_;
+      resetMeasures();
+      return;
+    }
+    if (limited_) logMessage("Benchmark " + scenarioToString(scenario_) + " limited by the entity pool.");
+    report(sustained_frame_time_, sustained_passes_);
+    exit_code_ = sustained_count_ > 0u && sustained_count_ >= config_.expect_ ? 0 : 1;
+    ramp_ = false;
+  } else {
+    sustained_count_ = load();
+    report(average, average_passes);
+    exit_code_ = held ? 0 : 1;
+  }
+  // interactive runs keep measuring
+  if (config_.enabled_) {
+    finished_ = true;
+  } else {
+    resetMeasures();
+  }
+}
+
+bool ktp::Testing::freeEntities(unsigned int needed) {
+  if (GameEntity::game_entities_.capacity() - GameEntity::count() >= needed) return true;
+  limited_ = true;
+  return false;
+}
+
+void ktp::Testing::generateCubes() {
+  cubes_count_ = static_cast<GLsizei>(count_);
+  std::vector<glm::vec3> translations {};
+  translations.reserve(count_);
+  // a cube of cubes in the [-1, 1] range
+  const auto side {static_cast<int>(std::ceil(std::cbrt(static_cast<double>(count_))))};
+  const auto spacing {2.f / static_cast<float>(side)};
+  for (int z = 0; z < side && translations.size() < count_; ++z) {
+    for (int y = 0; y < side && translations.size() < count_; ++y) {
+      for (int x = 0; x < side && translations.size() < count_; ++x) {
+        translations.push_back({-1.f + spacing * x, -1.f + spacing * y, -1.f + spacing * z});
+      }
+    }
+  }
+  translations_.setup(translations.data(), translations.size() * sizeof(glm::vec3));
+  vao_.linkAttrib(translations_, 2, 3, GL_FLOAT, 0, nullptr);
+  glVertexAttribDivisor(2, 1);
+}
+
+void ktp::Testing::generateDebugPrimitives() {
+  const auto screen {ConfigParser::game_config.screen_size_};
+  const auto width {screen.x * kPixelsToMeters};
+  const auto height {screen.y * kPixelsToMeters};
+  const std::array<b2Color, 3> colors {b2Color{1.f, 0.f, 0.f}, b2Color{0.f, 1.f, 0.f}, b2Color{0.f, 0.5f, 1.f}};
+  while (debug_primitives_.size() < count_) {
+    DebugPrimitive primitive {};
+    primitive.position_ = {generateRand(0.f, width), generateRand(0.f, height)};
+    primitive.end_ = primitive.position_ + b2Vec2{generateRand(-2.f, 2.f), generateRand(-2.f, 2.f)};
+    primitive.radius_ = generateRand(0.1f, 1.f);
+    primitive.color_ = colors[debug_primitives_.size() % colors.size()];
+    debug_primitives_.push_back(primitive);
+  }
+  debug_primitives_.resize(count_);
+}
+
+void ktp::Testing::generateEmitterType() {
+  auto& types {ConfigParser::emitter_types};
+  if (types.empty()) return;
+  // changing the vector invalidates the emitters' pointers, so this must
+  // happen with no emitters alive
+  auto type {std::find_if(types.begin(), types.end(), [](const EmitterType& t) { return t.type_ == kBenchmarkEmitter; })};
+  if (type == types.end()) {
+    EmitterType benchmark {types.front()};
+    benchmark.type_ = kBenchmarkEmitter;
+    types.push_back(benchmark);
+    type = types.end() - 1;
+  }
+  type->emission_interval_ = {0u, 1.f, 1.f};
+  type->emission_rate_ = {config_.particles_per_emitter_, 1.f, 1.f};
+  type->life_time_ = std::numeric_limits<unsigned int>::max();
 }
 
 void ktp::Testing::init() {
-  // camera
-  // camera_.setOrthographicMatrix(glm::ortho(
-  //   0.f, 1366.f, // left, right
-  //   0.f, 768.f, // bottom, top
-  //   -1.f, 1.f) // zNear, zFar
-  // );
-  // camera_.setProjection(Projection::Orthographic);
-  // shader
+  scenario_ = scenarioFromString(config_.scenario_);
+  count_ = config_.count_;
+  ramp_ = config_.ramp_;
+  // cubes
   shader_program_ = Resources::getShader("test");
-  // vertices
   vertices_data_ = cube(0.05f);
   vertices_.setup(vertices_data_);
   vao_.linkAttrib(vertices_, 0, 3, GL_FLOAT, 0, nullptr);
-  // colors
-  GLfloatVector colors_data_ {};
-  colors_data_.resize(vertices_data_.size());
-  for (auto& color_c: colors_data_) {
+  GLfloatVector colors_data {};
+  colors_data.resize(vertices_data_.size());
+  for (auto& color_c: colors_data) {
     color_c = generateRand(0.f, 1.f);
   }
-  colors_.setup(colors_data_);
+  colors_.setup(colors_data);
   vao_.linkAttrib(colors_, 1, 3, GL_FLOAT, 0, nullptr);
-  // translations
-  std::vector<glm::vec3> translations(kNumCubes_);
-  int index {};
-  float offset {0.1f};
-  for (int z = -10; z < 10; z += 2) {
-    for (int y = -10; y < 10; y += 2) {
-      for (int x = -10; x < 10; x += 2) {
-        glm::vec3 translation {};
-        translation.x = (float)x / 10.0f + offset;
-        translation.y = (float)y / 10.0f + offset;
-        translation.z = (float)z / 10.0f + offset;
-        translations[index++] = translation;
-      }
-    }
+  vao_.label("benchmark cubes");
+  vertices_.label("benchmark cubes vertices");
+  colors_.label("benchmark cubes colors");
+  setScenario(scenario_);
+  logMessage("Benchmark " + scenarioToString(scenario_) + " starting at " + std::to_string(count_) + (ramp_ ? " (ramp)" : ""));
+}
+
+unsigned int ktp::Testing::load() const {
+  switch (scenario_) {
+    case BenchmarkScenario::Aerolites:   return GameEntity::entitiesCount(EntityTypes::Aerolite);
+    case BenchmarkScenario::Cubes:       return static_cast<unsigned int>(cubes_count_);
+    case BenchmarkScenario::DebugDraw:   return debug_primitives_.size();
+    case BenchmarkScenario::Particles:   return emitters_.size() * config_.particles_per_emitter_;
+    case BenchmarkScenario::Projectiles: return GameEntity::entitiesCount(EntityTypes::Projectile);
+    case BenchmarkScenario::Stars:       return stars_;
+    default:                             return 0u;
+  }
+}
+
+void ktp::Testing::markPass(BenchmarkPass pass) {
+  glFinish();
+  addPassTime(pass, elapsedMs(pass_start_));
+  pass_start_ = SDL_GetPerformanceCounter();
+}
+
+void ktp::Testing::report(double frame_time, const PassTimes& passes) const {
+  logMessage("Benchmark " + scenarioToString(scenario_) + " result: " + std::to_string(sustained_count_)
+    + " at " + std::to_string(frame_time) + "ms (threshold " + std::to_string(config_.threshold_) + "ms)."
+    + " Update: " + std::to_string(passes[static_cast<std::size_t>(BenchmarkPass::Update)]) + "ms."
+    + " Scene: " + std::to_string(passes[static_cast<std::size_t>(BenchmarkPass::Scene)]) + "ms."
+    + " Debug: " + std::to_string(passes[static_cast<std::size_t>(BenchmarkPass::Debug)]) + "ms."
+    + " Present: " + std::to_string(passes[static_cast<std::size_t>(BenchmarkPass::Present)]) + "ms.");
+}
+
+void ktp::Testing::resetMeasures() {
+  limited_ = false;
+  sampled_frames_ = 0u;
+  sampled_frame_time_ = 0.0;
+  sampled_passes_.fill(0.0);
+  window_frames_ = 0u;
+}
+
+ktp::BenchmarkScenario ktp::Testing::scenarioFromString(const std::string& name) {
+  for (auto i = 0u; i < static_cast<unsigned>(BenchmarkScenario::count); ++i) {
+    const auto scenario {static_cast<BenchmarkScenario>(i)};
+    if (scenarioToString(scenario) == name) return scenario;
+  }
+  logMessage("Warning! Unknown benchmark scenario \"" + name + "\". Using cubes.");
+  return BenchmarkScenario::Cubes;
+}
+
+std::string ktp::Testing::scenarioToString(BenchmarkScenario scenario) {
+  switch (scenario) {
+    case BenchmarkScenario::Aerolites:   return "aerolites";
+    case BenchmarkScenario::Cubes:       return "cubes";
+    case BenchmarkScenario::DebugDraw:   return "debug";
+    case BenchmarkScenario::Particles:   return "particles";
+    case BenchmarkScenario::Projectiles: return "projectiles";
+    case BenchmarkScenario::Stars:       return "stars";
+    default:                             return "unknown";
   }
-  translations_.setup(translations.data(), kNumCubes_ * sizeof(glm::vec3));
-  vao_.linkAttrib(translations_, 2, 3, GL_FLOAT, 0, nullptr);
-  glVertexAttribDivisor(2, 1);
+}
+
+void ktp::Testing::setCount(unsigned int count) {
+  if (count == 0u) return;
+  if (count < count_) {
+    // the entities are gone, start again
+    debug_primitives_.clear();
+    emitters_.clear();
+    stars_ = 0u;
+  }
+  count_ = count;
+  resetMeasures();
+  logMessage("Benchmark " + scenarioToString(scenario_) + " count: " + std::to_string(count_));
+}
+
+void ktp::Testing::setScenario(BenchmarkScenario scenario) {
+  scenario_ = scenario;
+  cubes_count_ = 0;
+  debug_primitives_.clear();
+  emitters_.clear();
+  stars_ = 0u;
+  if (scenario_ == BenchmarkScenario::Particles) generateEmitterType();
+  finished_ = false;
+  resetMeasures();
+}
+
+void ktp::Testing::toggleRamp() {
+  ramp_ = !ramp_;
+  sustained_count_ = 0u;
+  resetMeasures();
+  logMessage(std::string{"Benchmark ramp "} + (ramp_ ? "on" : "off"));
 }
 
 void ktp::Testing::update(float delta_time) {
-  updateCamera(delta_time);
-  updateMVP();
+  updateLoad();
+  if (scenario_ == BenchmarkScenario::Cubes) {
+    updateCamera(delta_time);
+    updateMVP();
+  }
 }
 
 void ktp::Testing::updateCamera(float delta_time) {
@@ -79,6 +290,50 @@ void ktp::Testing::updateCamera(float delta_time) {
   }
 }
 
+void ktp::Testing::updateLoad() {
+  const auto screen {ConfigParser::game_config.screen_size_};
+  const auto random_point = [&screen]() {
+    return b2Vec2{generateRand(0.f, (float)screen.x), generateRand(0.f, (float)screen.y)};
+  };
+  switch (scenario_) {
+    case BenchmarkScenario::Aerolites:
+      while (GameEntity::entitiesCount(EntityTypes::Aerolite) < count_ && freeEntities(1u)) {
+        AerolitePhysicsComponent::spawnAerolite(random_point());
+      }
+      break;
+    case BenchmarkScenario::Cubes:
+      if (static_cast<unsigned int>(cubes_count_) != count_) generateCubes();
+      break;
+    case BenchmarkScenario::DebugDraw:
+      if (debug_primitives_.size() != count_) generateDebugPrimitives();
+      break;
+    case BenchmarkScenario::Particles:
+      while (emitters_.size() * config_.particles_per_emitter_ < count_ && freeEntities(1u)) {
+        const auto emitter {static_cast<EmitterPhysicsComponent*>(GameEntity::createEntity(EntityTypes::Emitter)->physics())};
+        const auto where {random_point()};
+        emitter->init(kBenchmarkEmitter, {where.x, where.y, 0.f});
+        emitters_.push_back(emitter);
+      }
+      for (auto emitter: emitters_) emitter->generateParticles();
+      break;
+    case BenchmarkScenario::Projectiles:
+      // a projectile brings an exhaust emitter and an explosion along
+      while (GameEntity::entitiesCount(EntityTypes::Projectile) < count_ && freeEntities(3u)) {
+        const auto projectile {static_cast<ProjectilePhysicsComponent*>(GameEntity::createEntity(EntityTypes::Projectile)->physics())};
+        projectile->setTransform(kPixelsToMeters * random_point(), generateRand(0.f, 2.f * b2_pi));
+      }
+      break;
+    case BenchmarkScenario::Stars:
+      while (stars_ < count_ && freeEntities(1u)) {
+        const auto background {GameEntity::createEntity(EntityTypes::Background)};
+        stars_ += static_cast<const BackgroundGraphicsComponent*>(background->graphics())->starsCount();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
 void ktp::Testing::updateMVP() {
   glm::mat4 model {1.f};
   const glm::mat4 mvp {camera_.projectionMatrix() * camera_.viewMatrix() * model};
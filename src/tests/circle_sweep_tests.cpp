@@ -0,0 +1,71 @@
+#include "../include/circle_sweep.hpp"
+#include <gtest/gtest.h>
+#include <box2d/box2d.h>
+
+namespace {
+
+// the explosion particle radius
+constexpr float kRadius {0.2f};
+
+b2PolygonShape box() {
+  b2PolygonShape polygon {};
+  polygon.SetAsBox(1.f, 1.f);
+  return polygon;
+}
+
+b2CircleShape circle() {
+  b2CircleShape shape {};
+  shape.m_radius = 1.f;
+  return shape;
+}
+
+} // namespace
+
+TEST(SweepCircleTests, HitsFromOutside) {
+  float fraction {};
+  b2Vec2 normal {};
+  EXPECT_EQ(ktp::sweepCircle(circle(), {-3.f, 0.f}, {2.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::Enters);
+  EXPECT_NEAR(fraction, 0.9f, 1e-5f) << "It should touch when the centers are 1.2 apart.";
+  EXPECT_NEAR(normal.x, -1.f, 1e-5f);
+  EXPECT_EQ(ktp::sweepCircle(circle(), {-3.f, 0.f}, {-2.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::None) << "Going away shouldn't hit.";
+  EXPECT_EQ(ktp::sweepCircle(circle(), {-3.f, 0.f}, {1.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::None) << "Stopping short shouldn't hit.";
+}
+
+TEST(SweepCircleTests, StartsInside) {
+  float fraction {1.f};
+  b2Vec2 normal {};
+  // overlapping by less than the radius, going away
+  EXPECT_EQ(ktp::sweepCircle(circle(), {-1.1f, 0.f}, {-1.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::Inside);
+  EXPECT_FLOAT_EQ(fraction, 0.f);
+  EXPECT_NEAR(normal.x, -1.f, 1e-5f) << "The normal should point the way out.";
+  // right at the center
+  EXPECT_EQ(ktp::sweepCircle(circle(), {0.f, 0.f}, {1.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::Inside);
+  EXPECT_NEAR(normal.Length(), 1.f, 1e-5f) << "The normal should still be a unit vector.";
+}
+
+TEST(SweepPolygonTests, HitsFromOutside) {
+  float fraction {};
+  b2Vec2 normal {};
+  EXPECT_EQ(ktp::sweepPolygon(box(), {-3.f, 0.f}, {2.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::Enters);
+  EXPECT_NEAR(fraction, 0.9f, 1e-5f) << "It should touch the face pushed out by the radius.";
+  EXPECT_NEAR(normal.x, -1.f, 1e-5f);
+  EXPECT_NEAR(normal.y, 0.f, 1e-5f);
+  EXPECT_EQ(ktp::sweepPolygon(box(), {-3.f, 0.f}, {0.f, 2.f}, kRadius, fraction, normal), ktp::SweepHit::None) << "Going by shouldn't hit.";
+  EXPECT_EQ(ktp::sweepPolygon(box(), {-3.f, 0.f}, {1.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::None) << "Stopping short shouldn't hit.";
+}
+
+TEST(SweepPolygonTests, StartsInside) {
+  float fraction {1.f};
+  b2Vec2 normal {};
+  // in the expanded box only, like shrapnel born at the tip of a projectile, going away
+  EXPECT_EQ(ktp::sweepPolygon(box(), {-1.1f, 0.f}, {-1.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::Inside);
+  EXPECT_FLOAT_EQ(fraction, 0.f);
+  EXPECT_NEAR(normal.x, -1.f, 1e-5f) << "The normal should be the one of the nearest face.";
+  // going in
+  EXPECT_EQ(ktp::sweepPolygon(box(), {-1.1f, 0.f}, {1.f, 0.f}, kRadius, fraction, normal), ktp::SweepHit::Inside);
+  // going along
+  EXPECT_EQ(ktp::sweepPolygon(box(), {-1.1f, 0.f}, {0.f, 1.f}, kRadius, fraction, normal), ktp::SweepHit::Inside);
+  // inside the box itself
+  EXPECT_EQ(ktp::sweepPolygon(box(), {0.f, 0.9f}, {0.f, -0.5f}, kRadius, fraction, normal), ktp::SweepHit::Inside);
+  EXPECT_NEAR(normal.y, 1.f, 1e-5f);
+}
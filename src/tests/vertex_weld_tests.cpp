@@ -0,0 +1,126 @@
+#include "../include/vertex_weld.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The nested loop EBO::generateEBO() had, for any stride. Every vertex
+ *  is compared with every unique one, by the cell of its components if there's
+ *  an epsilon.
+ */
+void legacy(std::vector<float>& vertices, std::vector<unsigned int>& indices, std::size_t stride, float epsilon) {
+  indices.clear();
+  const float inverse_epsilon {epsilon > 0.f ? 1.f / epsilon : 0.f};
+  std::vector<float> unique_coords {};
+  for (std::size_t i = 0; i + stride <= vertices.size(); i += stride) {
+    bool found {false};
+    for (std::size_t j = 0; j < unique_coords.size(); j += stride) {
+      std::size_t c {};
+      while (c < stride && ktp::weldKey(vertices[i + c], inverse_epsilon) == ktp::weldKey(unique_coords[j + c], inverse_epsilon)) ++c;
+      if (c == stride) {
+        found = true;
+        indices.push_back(static_cast<unsigned int>(j / stride));
+        break;
+      }
+    }
+    if (!found) {
+      unique_coords.insert(unique_coords.end(), vertices.begin() + i, vertices.begin() + i + stride);
+      indices.push_back(static_cast<unsigned int>(unique_coords.size() / stride - 1u));
+    }
+  }
+  vertices = std::move(unique_coords);
+}
+
+/**
+ * @brief Random vertices picked from a few, so there are plenty of duplicates.
+ */
+std::vector<float> randomVertices(std::size_t count, std::size_t stride, unsigned int seed) {
+  std::mt19937 engine {seed};
+  std::uniform_real_distribution<float> value_distribution {-10.f, 10.f};
+  std::vector<float> pool(32u * stride);
+  for (auto& value: pool) value = value_distribution(engine);
+  std::uniform_int_distribution<std::size_t> pick_distribution {0u, 31u};
+  std::vector<float> vertices {};
+  vertices.reserve(count * stride);
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto pick {pick_distribution(engine) * stride};
+    vertices.insert(vertices.end(), pool.begin() + pick, pool.begin() + pick + stride);
+  }
+  return vertices;
+}
+
+void expectSameAsLegacy(const std::vector<float>& input, std::size_t stride, float epsilon) {
+  auto expected_vertices {input};
+  std::vector<unsigned int> expected_indices {};
+  legacy(expected_vertices, expected_indices, stride, epsilon);
+  auto vertices {input};
+  std::vector<unsigned int> indices {};
+  ktp::weldVertices(vertices, indices, stride, epsilon);
+  EXPECT_EQ(vertices, expected_vertices);
+  EXPECT_EQ(indices, expected_indices);
+}
+
+} // namespace
+
+TEST(WeldVerticesTests, SameAsLegacyStride3) {
+  expectSameAsLegacy(randomVertices(1000u, 3u, 1u), 3u, 0.f);
+}
+
+TEST(WeldVerticesTests, SameAsLegacyStride5) {
+  expectSameAsLegacy(randomVertices(1000u, 5u, 2u), 5u, 0.f);
+}
+
+TEST(WeldVerticesTests, SameAsLegacyWithEpsilon) {
+  // jittered copies of a few vertices, so the cells matter
+  auto input {randomVertices(1000u, 5u, 3u)};
+  std::mt19937 engine {4u};
+  std::uniform_real_distribution<float> jitter_distribution {-1e-4f, 1e-4f};
+  for (auto& value: input) value += jitter_distribution(engine);
+  expectSameAsLegacy(input, 5u, 0.f);
+  expectSameAsLegacy(input, 5u, 1e-2f);
+}
+
+TEST(WeldVerticesTests, Epsilon) {
+  const std::vector<float> input {
+    0.f,    0.f,    0.f,
+    0.001f, 0.f,    0.f,
+    1.f,    0.f,    0.f,
+    1.f,    0.002f, 0.f
+  };
+  auto vertices {input};
+  std::vector<unsigned int> indices {};
+  ktp::weldVertices(vertices, indices, 3u, 0.f);
+  EXPECT_EQ(vertices.size(), input.size()) << "Without epsilon only equal vertices are welded.";
+  EXPECT_EQ(indices, (std::vector<unsigned int>{0u, 1u, 2u, 3u}));
+  vertices = input;
+  ktp::weldVertices(vertices, indices, 3u, 0.01f);
+  EXPECT_EQ(vertices, (std::vector<float>{0.f, 0.f, 0.f, 1.f, 0.f, 0.f})) << "The first vertex of a cell should be kept.";
+  EXPECT_EQ(indices, (std::vector<unsigned int>{0u, 0u, 1u, 1u}));
+}
+
+TEST(WeldVerticesTests, NegativeZero) {
+  std::vector<float> vertices {0.f, -0.f, 1.f, -0.f, 0.f, 1.f};
+  std::vector<unsigned int> indices {};
+  ktp::weldVertices(vertices, indices, 3u, 0.f);
+  EXPECT_EQ(vertices.size(), 3u) << "-0 should be welded with 0.";
+  EXPECT_EQ(indices, (std::vector<unsigned int>{0u, 0u}));
+}
+
+TEST(WeldVerticesTests, Empty) {
+  std::vector<float> vertices {};
+  std::vector<unsigned int> indices {7u};
+  ktp::weldVertices(vertices, indices, 3u, 0.f);
+  EXPECT_TRUE(vertices.empty());
+  EXPECT_TRUE(indices.empty()) << "Old indices should be cleared.";
+}
+
+TEST(WeldVerticesTests, AllDuplicates) {
+  std::vector<float> vertices {};
+  for (auto i = 0; i < 100; ++i) vertices.insert(vertices.end(), {1.f, 2.f, 3.f, 0.5f, 0.25f});
+  std::vector<unsigned int> indices {};
+  ktp::weldVertices(vertices, indices, 5u, 0.f);
+  EXPECT_EQ(vertices, (std::vector<float>{1.f, 2.f, 3.f, 0.5f, 0.25f}));
+  EXPECT_EQ(indices, std::vector<unsigned int>(100u, 0u));
+}